@@ -14,6 +14,7 @@
  *  limitations under the License.
  ********************************************************************************/
 
+#include <os_io_seproxyhal.h>
 #include <stdio.h>
 
 #include "app_mode.h"
@@ -0,0 +1,229 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "address_batch.h"
+
+#if !defined(LEDGER_SPECIFIC)
+#include <string.h>
+
+#include "parser_impl_con.h"
+#include "sha512.h"
+
+// Every Oasis address has the same shape: 21 bytes make 34 symbols with 2 bits of padding
+#define HRP_LEN (sizeof(COIN_HRP) - 1)
+#define DATA_SYMBOLS 34
+#define CHECKSUM_SYMBOLS 6
+#define BECH32_CONST 1u
+
+// Addresses checksummed side by side, the lane loops have a fixed trip count and no branches so they vectorize
+#define LANES 8
+
+static const char CHARSET[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+static const uint32_t GEN[5] = {0x3b6a57b2, 0x26508e6d, 0x1ea119fa, 0x3d4233dd, 0x2a1462b3};
+
+__Z_INLINE uint32_t polymod_step(uint32_t chk, uint8_t symbol) {
+    const uint32_t top = chk >> 25;
+    chk = ((chk & 0x1ffffff) << 5) ^ symbol;
+    for (uint8_t i = 0; i < 5; i++) {
+        chk ^= (0u - ((top >> i) & 1u)) & GEN[i];
+    }
+    return chk;
+}
+
+// Checksum state once the expanded human readable part went in, the same for every address
+static uint32_t hrp_state() {
+    uint32_t chk = 1;
+    for (size_t i = 0; i < HRP_LEN; i++) {
+        chk = polymod_step(chk, COIN_HRP[i] >> 5);
+    }
+    chk = polymod_step(chk, 0);
+    for (size_t i = 0; i < HRP_LEN; i++) {
+        chk = polymod_step(chk, COIN_HRP[i] & 31);
+    }
+    return chk;
+}
+
+// Four groups of five bytes give eight symbols each, the last byte gives two
+static void to_symbols(uint8_t symbols[DATA_SYMBOLS], const uint8_t raw[ADDR_RAW]) {
+    for (uint8_t g = 0; g < 4; g++) {
+        const uint8_t *p = raw + 5 * g;
+        const uint64_t v = (uint64_t)p[0] << 32 | (uint64_t)p[1] << 24 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 8 | p[4];
+        for (uint8_t j = 0; j < 8; j++) {
+            symbols[8 * g + j] = (v >> (35 - 5 * j)) & 31;
+        }
+    }
+    symbols[32] = raw[20] >> 3;
+    symbols[33] = (raw[20] & 7) << 2;
+}
+
+static void from_symbols(uint8_t raw[ADDR_RAW], const uint8_t symbols[DATA_SYMBOLS]) {
+    for (uint8_t g = 0; g < 4; g++) {
+        uint64_t v = 0;
+        for (uint8_t j = 0; j < 8; j++) {
+            v = (v << 5) | symbols[8 * g + j];
+        }
+        for (uint8_t j = 0; j < 5; j++) {
+            raw[5 * g + j] = (uint8_t)(v >> (32 - 8 * j));
+        }
+    }
+    raw[20] = (uint8_t)(symbols[32] << 3 | symbols[33] >> 2);
+}
+
+// Encodes up to LANES addresses, unused lanes are computed over zeros and dropped
+static void encode_lanes(char *out, const uint8_t *raw, size_t used, uint32_t start) {
+    uint8_t symbols[LANES][DATA_SYMBOLS] = {0};
+    uint32_t chk[LANES];
+    for (size_t l = 0; l < LANES; l++) {
+        if (l < used) {
+            to_symbols(symbols[l], raw + l * ADDR_RAW);
+        }
+        chk[l] = start;
+    }
+
+    for (uint8_t s = 0; s < DATA_SYMBOLS; s++) {
+        for (size_t l = 0; l < LANES; l++) {
+            chk[l] = polymod_step(chk[l], symbols[l][s]);
+        }
+    }
+    for (uint8_t s = 0; s < CHECKSUM_SYMBOLS; s++) {
+        for (size_t l = 0; l < LANES; l++) {
+            chk[l] = polymod_step(chk[l], 0);
+        }
+    }
+
+    for (size_t l = 0; l < used; l++) {
+        char *p = out + l * ADDRESS_BECH32_STRIDE;
+        MEMCPY(p, COIN_HRP "1", HRP_LEN + 1);
+        p += HRP_LEN + 1;
+        for (uint8_t s = 0; s < DATA_SYMBOLS; s++) {
+            *p++ = CHARSET[symbols[l][s]];
+        }
+        const uint32_t checksum = chk[l] ^ BECH32_CONST;
+        for (uint8_t s = 0; s < CHECKSUM_SYMBOLS; s++) {
+            *p++ = CHARSET[(checksum >> (5 * (CHECKSUM_SYMBOLS - 1 - s))) & 31];
+        }
+        *p = 0;
+    }
+}
+
+zxerr_t address_batch_encode_raw(char *out, size_t outLen, const uint8_t *raw, size_t count) {
+    if (out == NULL || raw == NULL) {
+        return zxerr_no_data;
+    }
+    if (outLen / ADDRESS_BECH32_STRIDE < count) {
+        return zxerr_buffer_too_small;
+    }
+
+    const uint32_t start = hrp_state();
+    for (size_t i = 0; i < count; i += LANES) {
+        const size_t used = count - i < LANES ? count - i : LANES;
+        encode_lanes(out + i * ADDRESS_BECH32_STRIDE, raw + i * ADDR_RAW, used, start);
+    }
+    return zxerr_ok;
+}
+
+zxerr_t address_batch_encode_pk(char *out, size_t outLen, const uint8_t *pks, size_t count, address_kind_e kind) {
+    if (out == NULL || pks == NULL) {
+        return zxerr_no_data;
+    }
+    if (kind != addr_ed25519 && kind != addr_sr25519) {
+        return zxerr_invalid_crypto_settings;
+    }
+    if (outLen / ADDRESS_BECH32_STRIDE < count) {
+        return zxerr_buffer_too_small;
+    }
+
+    const char *context = (kind == addr_ed25519) ? COIN_ADDRESS_ED25519_CONTEXT : COIN_ADDRESS_SR25519_CONTEXT;
+    const size_t contextLen = strlen(context);
+    const uint32_t start = hrp_state();
+
+    uint8_t raw[LANES][ADDR_RAW];
+    uint8_t hash[SHA512_DIGEST_LENGTH];
+    for (size_t i = 0; i < count; i += LANES) {
+        const size_t used = count - i < LANES ? count - i : LANES;
+        for (size_t l = 0; l < used; l++) {
+            // 1 byte version and the first 20 bytes of SHA512-256(context || version || pk)
+            SHA512_256_with_context_version((const uint8_t *)context, contextLen, COIN_ADDRESS_VERSION,
+                                            pks + (i + l) * PK_LEN_ED25519, PK_LEN_ED25519, hash);
+            raw[l][0] = COIN_ADDRESS_VERSION;
+            MEMCPY(raw[l] + 1, hash, ADDR_RAW - 1);
+        }
+        encode_lanes(out + i * ADDRESS_BECH32_STRIDE, raw[0], used, start);
+    }
+    return zxerr_ok;
+}
+
+zxerr_t address_batch_map_eth(uint8_t *raw, size_t rawLen, const uint8_t *ethAddrs, size_t count) {
+    if (raw == NULL || ethAddrs == NULL) {
+        return zxerr_no_data;
+    }
+    if (rawLen / ADDR_RAW < count) {
+        return zxerr_buffer_too_small;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        _mapEthToNative(ethAddrs + i * ETH_ADDR_LEN, raw + i * ADDR_RAW);
+    }
+    return zxerr_ok;
+}
+
+zxerr_t address_batch_decode(uint8_t *raw, size_t rawLen, const char *addresses, size_t count, size_t *failed) {
+    if (raw == NULL || addresses == NULL || failed == NULL) {
+        return zxerr_no_data;
+    }
+    *failed = 0;
+    if (rawLen / ADDR_RAW < count) {
+        return zxerr_buffer_too_small;
+    }
+
+    int8_t reverse[128];
+    memset(reverse, -1, sizeof(reverse));
+    for (uint8_t i = 0; i < 32; i++) {
+        reverse[(uint8_t)CHARSET[i]] = (int8_t)i;
+    }
+
+    const uint32_t start = hrp_state();
+    uint8_t symbols[DATA_SYMBOLS];
+    for (size_t i = 0; i < count; i++) {
+        *failed = i;
+        const char *p = addresses + i * ADDRESS_BECH32_STRIDE;
+        if (memcmp(p, COIN_HRP "1", HRP_LEN + 1) != 0 || p[ADDRESS_BECH32_LEN] != 0) {
+            return zxerr_encoding_failed;
+        }
+        p += HRP_LEN + 1;
+
+        uint32_t chk = start;
+        for (uint8_t s = 0; s < DATA_SYMBOLS + CHECKSUM_SYMBOLS; s++) {
+            const uint8_t c = (uint8_t)p[s];
+            if (c >= sizeof(reverse) || reverse[c] < 0) {
+                return zxerr_encoding_failed;
+            }
+            if (s < DATA_SYMBOLS) {
+                symbols[s] = (uint8_t)reverse[c];
+            }
+            chk = polymod_step(chk, (uint8_t)reverse[c]);
+        }
+
+        // Padding bits must be zero
+        if (chk != BECH32_CONST || (symbols[DATA_SYMBOLS - 1] & 3) != 0) {
+            return zxerr_encoding_failed;
+        }
+        from_symbols(raw + i * ADDR_RAW, symbols);
+    }
+
+    *failed = count;
+    return zxerr_ok;
+}
+#endif
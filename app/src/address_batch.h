@@ -0,0 +1,55 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "coin.h"
+#include "zxerror.h"
+#include "zxmacros.h"
+
+#if !defined(LEDGER_SPECIFIC)
+// Bulk address conversions for host tools such as indexers, the app itself encodes one address at a time
+
+// "oasis1", 34 data characters and 6 checksum characters
+#define ADDRESS_BECH32_LEN 46
+// Addresses are NUL terminated and laid out this many bytes apart
+#define ADDRESS_BECH32_STRIDE (ADDRESS_BECH32_LEN + 1)
+
+/// Bech32 encodes count raw addresses of ADDR_RAW bytes each, the same way parser_printAddress does
+zxerr_t address_batch_encode_raw(char *out, size_t outLen, const uint8_t *raw, size_t count);
+
+/// Addresses of count ed25519 or sr25519 public keys, the same way crypto_encodeAddress does
+zxerr_t address_batch_encode_pk(char *out, size_t outLen, const uint8_t *pks, size_t count, address_kind_e kind);
+
+/// Native addresses (ADDR_RAW bytes each) of count Ethereum addresses of ETH_ADDR_LEN bytes each,
+/// the mapping the parser checks orig_to against
+zxerr_t address_batch_map_eth(uint8_t *raw, size_t rawLen, const uint8_t *ethAddrs, size_t count);
+
+/// Decodes count addresses laid out as the encoders write them into ADDR_RAW bytes each
+/// Only the lower case form with the oasis prefix is accepted
+/// \param failed index of the first address rejected, count when all of them decoded
+zxerr_t address_batch_decode(uint8_t *raw, size_t rawLen, const char *addresses, size_t count, size_t *failed);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -28,14 +28,17 @@
 #include "crypto.h"
 #include "eth_addr.h"
 #include "eth_utils.h"
+#include "key_cache.h"
 #include "parser_impl.h"
 #include "parser_txdef.h"
+#include "trace.h"
 #include "tx.h"
 #include "view.h"
 #include "view_internal.h"
 #include "zxmacros.h"
 
 static bool tx_initialized = false;
+static bool tx_header_checked = false;
 
 static const char *msg_error1 = "Expert Mode";
 static const char *msg_error2 = "Required";
@@ -101,9 +104,26 @@ void extract_eth_path(uint32_t rx, uint32_t offset) {
     hdPathLen = path_len;
 }
 
-bool process_chunk(const volatile uint32_t *tx, uint32_t rx) {
-    UNUSED(tx);
+// Rejects the transaction as soon as its context or root item are known to be invalid,
+// instead of after the whole payload has been transferred
+__Z_INLINE void check_chunk_header(volatile uint32_t *tx) {
+    if (tx_header_checked) {
+        return;
+    }
 
+    uint8_t parser_err = 0;
+    const char *error_msg = tx_parse_header(&parser_err);
+    if (error_msg != NULL) {
+        tx_initialized = false;
+        const int error_msg_length = strlen(error_msg);
+        MEMCPY(G_io_apdu_buffer, error_msg, error_msg_length);
+        *tx += (error_msg_length);
+        THROW(APDU_CODE_DATA_INVALID);
+    }
+    tx_header_checked = parser_err == parser_ok;
+}
+
+bool process_chunk(volatile uint32_t *tx, uint32_t rx, tx_type_t tx_type) {
     const uint8_t payloadType = G_io_apdu_buffer[OFFSET_PAYLOAD_TYPE];
 
     if (G_io_apdu_buffer[OFFSET_P2] != 0) {
@@ -117,10 +137,15 @@ bool process_chunk(const volatile uint32_t *tx, uint32_t rx) {
     uint32_t added = 0;
     switch (payloadType) {
         case 0:
-            tx_initialize_oasis();
+            if (tx_type == oasis_batch_tx) {
+                tx_initialize_batch();
+            } else {
+                tx_initialize_oasis();
+            }
             tx_reset();
             extractHDPath(rx, OFFSET_DATA);
             tx_initialized = true;
+            tx_header_checked = false;
             return false;
         case 1:
             if (!tx_initialized) {
@@ -131,6 +156,7 @@ bool process_chunk(const volatile uint32_t *tx, uint32_t rx) {
                 tx_initialized = false;
                 THROW(APDU_CODE_OUTPUT_BUFFER_TOO_SMALL);
             }
+            check_chunk_header(tx);
             return false;
         case 2:
             if (!tx_initialized) {
@@ -212,10 +238,12 @@ bool process_chunk_eth(__Z_UNUSED volatile uint32_t *tx, uint32_t rx) {
                 THROW(APDU_CODE_TX_NOT_INITIALIZED);
             }
 
+            // only the RLP header is needed, reading it does not force the buffered chunks into flash
             uint64_t buff_len = tx_get_buffer_length();
-            uint8_t *buff_data = tx_get_buffer();
+            uint8_t rlp_header[RLP_TX_HEADER_MAX_LEN] = {0};
+            const uint32_t header_len = tx_read(0, rlp_header, sizeof(rlp_header));
 
-            if (get_tx_rlp_len(buff_data, buff_len, &read, &to_read) != rlp_ok) {
+            if (get_tx_rlp_len(rlp_header, header_len, &read, &to_read) != rlp_ok) {
                 THROW(APDU_CODE_DATA_INVALID);
             }
 
@@ -305,6 +333,38 @@ __Z_INLINE void handleGetAddr(volatile uint32_t *flags, volatile uint32_t *tx, u
     THROW(APDU_CODE_OK);
 }
 
+// Account discovery: no review, P1 is the address kind and the data is the number of keys wanted
+// followed by the path of the first one. Hosts ask again from the first index not returned
+__Z_INLINE void handleGetAddrRange(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
+    UNUSED(flags);
+    zemu_log("handleGetAddrRange\n");
+
+    const uint8_t kind = G_io_apdu_buffer[OFFSET_P1];
+    const uint8_t p2 = G_io_apdu_buffer[OFFSET_P2];
+    if ((kind != addr_ed25519 && kind != addr_secp256k1 && kind != addr_sr25519) ||
+        (p2 != 0 && p2 != P2_ADDR_RANGE_PK_ONLY)) {
+        THROW(APDU_CODE_INVALIDP1P2);
+    }
+
+    if (rx < OFFSET_DATA + 1) {
+        THROW(APDU_CODE_WRONG_LENGTH);
+    }
+    const uint8_t count = G_io_apdu_buffer[OFFSET_DATA];
+    if (count == 0) {
+        THROW(APDU_CODE_DATA_INVALID);
+    }
+    extractHDPath(rx, OFFSET_DATA + 1);
+
+    uint16_t replyLen = 0;
+    const zxerr_t err = app_fill_address_range((address_kind_e)kind, count, p2 == P2_ADDR_RANGE_PK_ONLY, &replyLen);
+    if (err != zxerr_ok || replyLen == 0) {
+        *tx = 0;
+        THROW(APDU_CODE_DATA_INVALID);
+    }
+    *tx = replyLen;
+    THROW(APDU_CODE_OK);
+}
+
 __Z_INLINE void handleGetEthAddr(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
     extract_eth_path(rx, OFFSET_DATA);
 
@@ -333,9 +393,10 @@ __Z_INLINE void handleGetEthAddr(volatile uint32_t *flags, volatile uint32_t *tx
 }
 
 __Z_INLINE void handleSignSecp256k1(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
-    if (!process_chunk(tx, rx)) {
+    if (!process_chunk(tx, rx, oasis_tx)) {
         THROW(APDU_CODE_OK);
     }
+    TRACE_BEGIN(G_io_apdu_buffer[OFFSET_INS])
 
     CHECK_APP_CANARY()
     uint8_t parser_err = 0;
@@ -354,18 +415,21 @@ __Z_INLINE void handleSignSecp256k1(volatile uint32_t *flags, volatile uint32_t
     }
 
     CHECK_APP_CANARY()
+    TRACE_START(trace_review)
     view_review_init(tx_getItem, tx_getNumItems, app_sign_secp256k1);
 #if !defined(TARGET_STAX) && !defined(TARGET_FLEX) && !defined(TARGET_APEX_P)
     view_inspect_init(tx_getInnerItem, tx_getNumInnerItems, tx_canInspectItem);
 #endif
     view_review_show(REVIEW_TXN);
+    TRACE_STOP(trace_review)
     *flags |= IO_ASYNCH_REPLY;
 }
 
 __Z_INLINE void handleSignEd25519(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
-    if (!process_chunk(tx, rx)) {
+    if (!process_chunk(tx, rx, oasis_tx)) {
         THROW(APDU_CODE_OK);
     }
+    TRACE_BEGIN(G_io_apdu_buffer[OFFSET_INS])
 
     CHECK_APP_CANARY()
     uint8_t parser_err = 0;
@@ -383,18 +447,67 @@ __Z_INLINE void handleSignEd25519(volatile uint32_t *flags, volatile uint32_t *t
         THROW(APDU_CODE_DATA_INVALID);
     }
     CHECK_APP_CANARY()
+    TRACE_START(trace_review)
     view_review_init(tx_getItem, tx_getNumItems, app_sign_ed25519);
 #if !defined(TARGET_STAX) && !defined(TARGET_FLEX) && !defined(TARGET_APEX_P)
     view_inspect_init(tx_getInnerItem, tx_getNumInnerItems, tx_canInspectItem);
 #endif
     view_review_show(REVIEW_TXN);
+    TRACE_STOP(trace_review)
     *flags |= IO_ASYNCH_REPLY;
 }
 
+#if defined(APP_BATCH_SIGNING)
+__Z_INLINE void handleSignBatchEd25519(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
+    if (G_io_apdu_buffer[OFFSET_PAYLOAD_TYPE] == P1_BATCH_SIGNATURES) {
+        if (G_io_apdu_buffer[OFFSET_P2] != 0) {
+            THROW(APDU_CODE_INVALIDP1P2);
+        }
+        if (rx != OFFSET_DATA + 1) {
+            THROW(APDU_CODE_WRONG_LENGTH);
+        }
+
+        const uint8_t first = G_io_apdu_buffer[OFFSET_DATA];
+        uint16_t replyLen = 0;
+        if (app_fill_batch_signatures(first, &replyLen) != zxerr_ok || replyLen == 0) {
+            *tx = 0;
+            THROW(APDU_CODE_COMMAND_NOT_ALLOWED);
+        }
+        *tx = replyLen;
+        THROW(APDU_CODE_OK);
+    }
+
+    if (!process_chunk(tx, rx, oasis_batch_tx)) {
+        THROW(APDU_CODE_OK);
+    }
+    TRACE_BEGIN(G_io_apdu_buffer[OFFSET_INS])
+
+    CHECK_APP_CANARY()
+    uint8_t parser_err = 0;
+    const char *error_msg = tx_parse(&parser_err);
+    CHECK_APP_CANARY()
+
+    if (error_msg != NULL) {
+        int error_msg_length = strlen(error_msg);
+        MEMCPY(G_io_apdu_buffer, error_msg, error_msg_length);
+        *tx += (error_msg_length);
+        THROW(APDU_CODE_DATA_INVALID);
+    }
+
+    CHECK_APP_CANARY()
+    TRACE_START(trace_review)
+    view_review_init(tx_getItem, tx_getNumItems, app_sign_batch_ed25519);
+    view_review_show(REVIEW_TXN);
+    TRACE_STOP(trace_review)
+    *flags |= IO_ASYNCH_REPLY;
+}
+#endif
+
 __Z_INLINE void handleSignEth(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
     if (!process_chunk_eth(tx, rx)) {
         THROW(APDU_CODE_OK);
     }
+    TRACE_BEGIN(G_io_apdu_buffer[OFFSET_INS])
     CHECK_APP_CANARY()
 
     uint8_t parser_err = 0;
@@ -409,15 +522,18 @@ __Z_INLINE void handleSignEth(volatile uint32_t *flags, volatile uint32_t *tx, u
     }
 
     CHECK_APP_CANARY()
+    TRACE_START(trace_review)
     view_review_init(tx_getItem, tx_getNumItems, app_sign_eth);
     view_review_show(REVIEW_TXN);
+    TRACE_STOP(trace_review)
     *flags |= IO_ASYNCH_REPLY;
 }
 
 __Z_INLINE void handleSignSr25519(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
-    if (!process_chunk(tx, rx)) {
+    if (!process_chunk(tx, rx, oasis_tx)) {
         THROW(APDU_CODE_OK);
     }
+    TRACE_BEGIN(G_io_apdu_buffer[OFFSET_INS])
 
     CHECK_APP_CANARY()
     uint8_t parser_err = 0;
@@ -436,17 +552,48 @@ __Z_INLINE void handleSignSr25519(volatile uint32_t *flags, volatile uint32_t *t
     }
 
     CHECK_APP_CANARY()
+    TRACE_START(trace_review)
     view_review_init(tx_getItem, tx_getNumItems, app_sign_sr25519);
 #if !defined(TARGET_STAX) && !defined(TARGET_FLEX) && !defined(TARGET_APEX_P)
     view_inspect_init(tx_getInnerItem, tx_getNumInnerItems, tx_canInspectItem);
 #endif
     view_review_show(REVIEW_TXN);
+    TRACE_STOP(trace_review)
     *flags |= IO_ASYNCH_REPLY;
 }
 
+#if defined(APP_TRACE)
+__Z_INLINE void handleGetTraces(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
+    UNUSED(flags);
+    UNUSED(rx);
+    if (G_io_apdu_buffer[OFFSET_P2] != 0) {
+        THROW(APDU_CODE_INVALIDP1P2);
+    }
+
+    // P1 caps the number of traces, 0 asks for all of them
+    const uint8_t count = G_io_apdu_buffer[OFFSET_P1];
+    *tx = trace_serialize(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE - 2, count);
+    THROW(APDU_CODE_OK);
+}
+#endif
+
 void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
     uint16_t sw = 0;
 
+    // Ticker events already wipe cached keys when the device locks, this covers an APDU arriving first
+    if (os_global_pin_is_validated() != BOLOS_UX_OK) {
+        key_cache_clear();
+    }
+
+#if defined(APP_BATCH_SIGNING)
+    // Batch signatures are only handed out right after the approval, any other APDU may change
+    // the path or the buffer the batch was approved with
+    if (rx <= OFFSET_P1 || G_io_apdu_buffer[OFFSET_CLA] != CLA || G_io_apdu_buffer[OFFSET_INS] != INS_SIGN_BATCH_ED25519 ||
+        G_io_apdu_buffer[OFFSET_P1] != P1_BATCH_SIGNATURES) {
+        app_batch_reset();
+    }
+#endif
+
     BEGIN_TRY {
         TRY {
             uint8_t cla = G_io_apdu_buffer[OFFSET_CLA];
@@ -489,6 +636,14 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                     break;
                 }
 
+#if defined(APP_BATCH_SIGNING)
+                case INS_SIGN_BATCH_ED25519: {
+                    CHECK_PIN_VALIDATED()
+                    handleSignBatchEd25519(flags, tx, rx);
+                    break;
+                }
+#endif
+
                 case INS_GET_ADDR_SECP256K1: {
                     if (cla != CLA_ETH) {
                         zemu_log("INS_GET_ADDR_SECP256K1\n");
@@ -514,6 +669,13 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                     break;
                 }
 
+                case INS_GET_ADDR_RANGE: {
+                    zemu_log("INS_GET_ADDR_RANGE\n");
+                    CHECK_PIN_VALIDATED()
+                    handleGetAddrRange(flags, tx, rx);
+                    break;
+                }
+
                 case INS_SIGN_RT_SR25519: {
                     zemu_log("INS_SIGN_RT_SR25519\n");
                     CHECK_PIN_VALIDATED()
@@ -521,6 +683,14 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                     break;
                 }
 
+#if defined(APP_TRACE)
+                case INS_GET_TRACES: {
+                    CHECK_PIN_VALIDATED()
+                    handleGetTraces(flags, tx, rx);
+                    break;
+                }
+#endif
+
                 default:
                     THROW(APDU_CODE_INS_NOT_SUPPORTED);
             }
@@ -536,6 +706,9 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                     sw = 0x6800 | (e & 0x7FF);
                     break;
             }
+            if (sw != APDU_CODE_OK) {
+                TRACE_END(sw)
+            }
             G_io_apdu_buffer[*tx] = sw >> 8;
             G_io_apdu_buffer[*tx + 1] = sw;
             *tx += 2;
@@ -22,12 +22,27 @@
 #define INS_SIGN_RT_ED25519 5
 #define INS_SIGN_RT_SR25519 6
 #define INS_SIGN_RT_SECP256K1 7
+#define INS_SIGN_BATCH_ED25519 8
+#define INS_GET_TRACES 9
+#define INS_GET_ADDR_RANGE 10
 #define INS_GET_ADDR_ETH 2
 
 // transaction is sent as a blob of rlp encoded bytes,
 #define P1_ETH_FIRST 0x00
 #define P1_ETH_MORE 0x80
 
+// once a batch is approved, the signatures that did not fit in the reply are read with this
+// payload type, data is the index of the first signature wanted
+#define P1_BATCH_SIGNATURES 0x03
+
+// the batch summary stays in RAM for the whole app lifetime, Nano S has none to spare
+#if !defined(TARGET_NANOS)
+#define APP_BATCH_SIGNING
+#endif
+
+// address range replies with the public keys only, the host encodes the addresses itself
+#define P2_ADDR_RANGE_PK_ONLY 0x01
+
 #define MAINNET_GENESIS_HASH "bb3d748def55bdfb797a2ac53ee6ee141e54cd2ab2dc2375f4a0703a178e6e55"
 #define TESTNET_GENESIS_HASH "0b91b8e4e44b2003a7c5e23ddadb5e14ef5345c0ebcb3ddcae07fa2f244cab76"
 
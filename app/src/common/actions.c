@@ -26,10 +26,18 @@
 #include "parser_impl.h"
 #include "sha512.h"
 #include "stdbool.h"
+#include "trace.h"
 #include "tx.h"
 
 uint16_t action_addrResponseLen;
 
+#if defined(APP_BATCH_SIGNING)
+static bool batch_approved = false;
+// Path the batch was approved for, signatures never follow hdPath once other APDUs have changed it
+static uint32_t batch_hdPath[MAX_BIP32_PATH];
+static uint8_t batch_hdPathLen = 0;
+#endif
+
 void app_sign_ed25519() {
     uint8_t *signature = G_io_apdu_buffer;
     uint16_t replyLen = 0;
@@ -41,13 +49,74 @@ void app_sign_ed25519() {
 
     if (err != zxerr_ok || replyLen == 0) {
         set_code(G_io_apdu_buffer, 0, APDU_CODE_SIGN_VERIFY_ERROR);
+        TRACE_END(APDU_CODE_SIGN_VERIFY_ERROR)
         io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
     } else {
         set_code(G_io_apdu_buffer, replyLen, APDU_CODE_OK);
+        TRACE_END(APDU_CODE_OK)
         io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, replyLen + 2);
     }
 }
 
+#if defined(APP_BATCH_SIGNING)
+void app_batch_reset() {
+    batch_approved = false;
+    MEMZERO(batch_hdPath, sizeof(batch_hdPath));
+    batch_hdPathLen = 0;
+}
+
+zxerr_t app_fill_batch_signatures(uint8_t first, uint16_t *replyLen) {
+    *replyLen = 0;
+    if (!batch_approved || first >= parser_batch_obj.count) {
+        return zxerr_unknown;
+    }
+
+    MEMCPY(hdPath, batch_hdPath, sizeof(hdPath));
+    hdPathLen = batch_hdPathLen;
+
+    uint8_t messageDigest[CX_SHA512_SIZE] = {0};
+    for (uint8_t i = first; i < parser_batch_obj.count; i++) {
+        if (*replyLen + ED25519_SIGNATURE_SIZE > IO_APDU_BUFFER_SIZE - 3) {
+            break;
+        }
+        CHECK_ZXERR(crypto_getBatchBytesToSign(i, messageDigest, sizeof(messageDigest)))
+
+        uint16_t signatureLen = 0;
+        CHECK_ZXERR(crypto_signEd25519(G_io_apdu_buffer + *replyLen, IO_APDU_BUFFER_SIZE - 3 - *replyLen, messageDigest,
+                                       CX_SHA256_SIZE, &signatureLen))
+        if (signatureLen != ED25519_SIGNATURE_SIZE) {
+            return zxerr_unknown;
+        }
+        *replyLen += signatureLen;
+    }
+
+    return zxerr_ok;
+}
+
+void app_sign_batch_ed25519() {
+    batch_approved = true;
+    MEMCPY(batch_hdPath, hdPath, sizeof(batch_hdPath));
+    batch_hdPathLen = hdPathLen;
+    uint16_t replyLen = 0;
+
+    MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
+    const zxerr_t err = app_fill_batch_signatures(0, &replyLen);
+
+    if (err != zxerr_ok || replyLen == 0) {
+        app_batch_reset();
+        MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
+        set_code(G_io_apdu_buffer, 0, APDU_CODE_SIGN_VERIFY_ERROR);
+        TRACE_END(APDU_CODE_SIGN_VERIFY_ERROR)
+        io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
+    } else {
+        // Four signatures already take 256 bytes, past what set_code can offset
+        set_code(G_io_apdu_buffer + replyLen, 0, APDU_CODE_OK);
+        TRACE_END(APDU_CODE_OK)
+        io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, replyLen + 2);
+    }
+}
+#endif
+
 void app_sign_secp256k1() {
     uint8_t *signature = G_io_apdu_buffer;
     uint16_t replyLen = 0;
@@ -59,9 +128,11 @@ void app_sign_secp256k1() {
 
     if (err != zxerr_ok || replyLen == 0) {
         set_code(G_io_apdu_buffer, 0, APDU_CODE_SIGN_VERIFY_ERROR);
+        TRACE_END(APDU_CODE_SIGN_VERIFY_ERROR)
         io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
     } else {
         set_code(G_io_apdu_buffer, replyLen, APDU_CODE_OK);
+        TRACE_END(APDU_CODE_OK)
         io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, replyLen + 2);
     }
 }
@@ -79,16 +150,22 @@ void app_sign_sr25519() {
 
     if (err != zxerr_ok || replyLen == 0) {
         set_code(G_io_apdu_buffer, 0, APDU_CODE_SIGN_VERIFY_ERROR);
+        TRACE_END(APDU_CODE_SIGN_VERIFY_ERROR)
         io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
     } else {
         set_code(G_io_apdu_buffer, replyLen, APDU_CODE_OK);
+        TRACE_END(APDU_CODE_OK)
         io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, replyLen + 2);
     }
 }
 
 void app_reject() {
+#if defined(APP_BATCH_SIGNING)
+    app_batch_reset();
+#endif
     MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
     set_code(G_io_apdu_buffer, 0, APDU_CODE_COMMAND_NOT_ALLOWED);
+    TRACE_END(APDU_CODE_COMMAND_NOT_ALLOWED)
     io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
 }
 
@@ -108,6 +185,66 @@ zxerr_t app_fill_address(address_kind_e kind) {
     return zxerr_ok;
 }
 
+zxerr_t app_fill_address_range(address_kind_e kind, uint8_t count, bool pkOnly, uint16_t *replyLen) {
+    *replyLen = 0;
+    if (count == 0 || hdPathLen == 0 || kind == addr_eth) {
+        return zxerr_unknown;
+    }
+
+    // Every index stays on the hardened or non hardened side of the first one
+    const uint32_t first = hdPath[hdPathLen - 1];
+    if ((first & 0x7FFFFFFFu) > 0x7FFFFFFFu - (count - 1)) {
+        return zxerr_out_of_bounds;
+    }
+
+    const uint16_t pkLen = kind == addr_secp256k1 ? PK_LEN_SECP256K1 : PK_LEN_ED25519;
+    // Large enough for crypto_fillAddress with any of the three kinds
+    uint8_t entry[PK_LEN_SECP256K1 + 50] = {0};
+
+    MEMZERO(G_io_apdu_buffer, IO_APDU_BUFFER_SIZE);
+    uint16_t offset = 1;
+    uint16_t entrySize = 0;
+    uint8_t filled = 0;
+    zxerr_t err = zxerr_ok;
+
+    // Entries of one kind all have the same size, so nothing is derived once the previous one shows it will not fit
+    while (filled < count && offset + entrySize <= IO_APDU_BUFFER_SIZE - 2) {
+        hdPath[hdPathLen - 1] = first + filled;
+
+        uint16_t entryLen = 0;
+        err = crypto_fillAddress(entry, sizeof(entry), &entryLen, kind);
+        if (err == zxerr_ok && (entryLen <= pkLen || entryLen - pkLen > UINT8_MAX)) {
+            err = zxerr_unknown;
+        }
+        if (err != zxerr_ok) {
+            break;
+        }
+
+        entrySize = pkOnly ? pkLen : entryLen + 1;
+        if (offset + entrySize > IO_APDU_BUFFER_SIZE - 2) {
+            break;
+        }
+
+        MEMCPY(G_io_apdu_buffer + offset, entry, pkLen);
+        if (!pkOnly) {
+            G_io_apdu_buffer[offset + pkLen] = (uint8_t)(entryLen - pkLen);
+            MEMCPY(G_io_apdu_buffer + offset + pkLen + 1, entry + pkLen, entryLen - pkLen);
+        }
+        offset += entrySize;
+        filled++;
+    }
+
+    // Later requests see the path that was asked for, not the last index of the range
+    hdPath[hdPathLen - 1] = first;
+    if (err != zxerr_ok) {
+        return err;
+    }
+
+    G_io_apdu_buffer[0] = filled;
+    *replyLen = offset;
+    return filled > 0 ? zxerr_ok : zxerr_buffer_too_small;
+}
+
 void app_sign_eth() {
     const uint8_t *message = tx_get_buffer();
     const uint16_t messageLength = tx_get_buffer_length();
@@ -118,9 +255,11 @@ void app_sign_eth() {
 
     if (err != zxerr_ok || replyLen == 0) {
         set_code(G_io_apdu_buffer, 0, APDU_CODE_SIGN_VERIFY_ERROR);
+        TRACE_END(APDU_CODE_SIGN_VERIFY_ERROR)
         io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
     } else {
         set_code(G_io_apdu_buffer, replyLen, APDU_CODE_OK);
+        TRACE_END(APDU_CODE_OK)
         io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, replyLen + 2);
     }
 }
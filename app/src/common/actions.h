@@ -15,6 +15,7 @@
  ********************************************************************************/
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "coin.h"
@@ -26,7 +27,20 @@ void app_sign_ed25519();
 void app_sign_secp256k1();
 void app_sign_sr25519();
 void app_sign_eth();
+
+#if defined(APP_BATCH_SIGNING)
+/// Signs every transaction of the approved batch, replies with as many signatures as fit
+void app_sign_batch_ed25519();
+/// Writes the batch signatures starting at first into the APDU buffer, only once the batch was approved
+/// Signs with the path the batch was approved for, which is also restored into hdPath
+zxerr_t app_fill_batch_signatures(uint8_t first, uint16_t *replyLen);
+/// Forgets the batch approval and its path
+void app_batch_reset();
+#endif
 zxerr_t app_fill_address(address_kind_e kind);
+/// Derives up to count keys from the current path on, the last path component being the first index,
+/// and writes as many entries as fit in the APDU buffer behind a one byte entry count
+zxerr_t app_fill_address_range(address_kind_e kind, uint8_t count, bool pkOnly, uint16_t *replyLen);
 
 void app_reject();
 
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "key_cache.h"
+
+#include <os.h>
+#include <string.h>
+
+#include "coin.h"
+#include "zxmacros.h"
+
+// RAM only, a reboot or another app starting always loses it
+typedef struct {
+    bool valid;
+    key_cache_kind_e kind;
+    uint8_t mode;
+    uint8_t pathLen;
+    uint32_t path[MAX_BIP32_PATH];
+    uint16_t keyLen;
+    uint8_t key[KEY_CACHE_MAX_LEN];
+    uint32_t idleMs;
+} key_cache_t;
+
+static key_cache_t keyCache;
+
+static bool key_cache_matches(key_cache_kind_e kind, uint8_t mode, const uint32_t *path, uint8_t pathLen) {
+    return keyCache.valid && keyCache.kind == kind && keyCache.mode == mode && keyCache.pathLen == pathLen &&
+           memcmp(keyCache.path, path, sizeof(uint32_t) * pathLen) == 0;
+}
+
+void key_cache_clear() {
+    MEMZERO(&keyCache, sizeof(keyCache));
+}
+
+bool key_cache_get(key_cache_kind_e kind, uint8_t mode, const uint32_t *path, uint8_t pathLen, uint8_t *out,
+                   uint16_t outLen) {
+    if (path == NULL || out == NULL || pathLen > MAX_BIP32_PATH) {
+        return false;
+    }
+    if (!key_cache_matches(kind, mode, path, pathLen)) {
+        key_cache_clear();
+        return false;
+    }
+    if (outLen != keyCache.keyLen) {
+        return false;
+    }
+
+    MEMCPY(out, keyCache.key, keyCache.keyLen);
+    keyCache.idleMs = 0;
+    return true;
+}
+
+void key_cache_put(key_cache_kind_e kind, uint8_t mode, const uint32_t *path, uint8_t pathLen, const uint8_t *key,
+                   uint16_t keyLen) {
+    key_cache_clear();
+    if (path == NULL || key == NULL || pathLen > MAX_BIP32_PATH || keyLen > KEY_CACHE_MAX_LEN) {
+        return;
+    }
+
+    keyCache.kind = kind;
+    keyCache.mode = mode;
+    keyCache.pathLen = pathLen;
+    MEMCPY(keyCache.path, path, sizeof(uint32_t) * pathLen);
+    keyCache.keyLen = keyLen;
+    MEMCPY(keyCache.key, key, keyLen);
+    keyCache.valid = true;
+}
+
+void key_cache_ticker() {
+    if (!keyCache.valid) {
+        return;
+    }
+    keyCache.idleMs += KEY_CACHE_TICKER_MS;
+    if (keyCache.idleMs >= KEY_CACHE_MAX_IDLE_MS || os_global_pin_is_validated() != BOLOS_UX_OK) {
+        key_cache_clear();
+    }
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// Largest key material kept: 64 bytes of secret followed by a 32 bytes public part or chain code
+#define KEY_CACHE_MAX_LEN 96
+
+/// Period of the SEPROXYHAL ticker events the SDK sends the app
+#define KEY_CACHE_TICKER_MS 100
+
+/// Time the entry survives without being used
+#define KEY_CACHE_MAX_IDLE_MS 30000
+
+/// What the cached material was derived for, the same path gives different keys for each
+typedef enum {
+    key_cache_ed25519 = 1,
+    key_cache_sr25519,
+    key_cache_secp256k1,
+} key_cache_kind_e;
+
+/// Copies the cached key material for (kind, mode, path)
+/// Asking for anything else wipes the entry, so only the last path is ever held
+/// \return true on a hit
+bool key_cache_get(key_cache_kind_e kind, uint8_t mode, const uint32_t *path, uint8_t pathLen, uint8_t *out,
+                   uint16_t outLen);
+
+/// Replaces the cached entry
+void key_cache_put(key_cache_kind_e kind, uint8_t mode, const uint32_t *path, uint8_t pathLen, const uint8_t *key,
+                   uint16_t keyLen);
+
+/// Wipes the entry
+void key_cache_clear();
+
+/// Called on every SEPROXYHAL ticker event, whether or not an APDU is being handled
+/// Wipes the entry at once if the device is locked, otherwise once it has been idle for KEY_CACHE_MAX_IDLE_MS
+void key_cache_ticker();
+
+#ifdef __cplusplus
+}
+#endif
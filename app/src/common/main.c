@@ -17,8 +17,29 @@
 #include <os_io_seproxyhal.h>
 
 #include "app_main.h"
+#include "key_cache.h"
 #include "view.h"
 
+// Every way out of the app ends in os_sched_exit, which never returns, so the key cache is wiped there
+// The Makefile links with --wrap=os_sched_exit to route the calls made by the SDK and zxlib through here
+void __real_os_sched_exit(bolos_task_status_t exit_code);
+
+void __wrap_os_sched_exit(bolos_task_status_t exit_code) {
+    key_cache_clear();
+    __real_os_sched_exit(exit_code);
+}
+
+// Ticker events keep coming while the app waits for an APDU or for the user, so they age the key cache and wipe it
+// as soon as the device locks. The Makefile links with --wrap=io_event to see them before zxlib handles them
+unsigned char __real_io_event(unsigned char channel);
+
+unsigned char __wrap_io_event(unsigned char channel) {
+    if (G_io_seproxyhal_spi_buffer[0] == SEPROXYHAL_TAG_TICKER_EVENT) {
+        key_cache_ticker();
+    }
+    return __real_io_event(channel);
+}
+
 __attribute__((section(".boot"))) int main(void) {
     // exit critical section
     __asm volatile("cpsie i");
@@ -35,4 +56,7 @@ __attribute__((section(".boot"))) int main(void) {
         FINALLY {}
     }
     END_TRY;
+
+    // Only reached when app_main gave up on an exception
+    key_cache_clear();
 }
@@ -29,6 +29,10 @@ const char *parser_getErrorDescription(parser_error_t err);
 //// parses a tx buffer
 parser_error_t parser_parse(parser_context_t *ctx, const uint8_t *data, size_t dataLen);
 
+//// checks the header of a tx buffer that is still being received
+//// returns parser_no_data while more bytes are needed, parser_ok once the header is valid
+parser_error_t parser_parseHeader(parser_context_t *ctx, const uint8_t *data, size_t dataLen);
+
 //// verifies tx fields
 parser_error_t parser_validate(const parser_context_t *ctx);
 
@@ -102,6 +102,7 @@ typedef enum {
 typedef enum {
     oasis_tx = 0,
     eth_tx,
+    oasis_batch_tx,
 } tx_type_t;
 
 typedef struct {
@@ -0,0 +1,133 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "trace.h"
+
+#include "zxmacros.h"
+
+#if defined(APP_TRACE)
+
+#if !defined(TRACE_CLOCK)
+#if defined(LEDGER_SPECIFIC)
+// The SDK gives apps no cycle counter, every stage would read 0 ticks
+#error "APP_TRACE needs a TRACE_CLOCK on device builds, tracing is meant for the host emulator"
+#else
+#include <time.h>
+// Nanoseconds, stages are far shorter than the 4 s wrap around
+static uint32_t trace_host_clock() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+#define TRACE_CLOCK() trace_host_clock()
+#endif
+#endif
+
+static trace_record_t traceRing[TRACE_RING_SIZE];
+static uint8_t traceNext = 0;
+static uint8_t traceCount = 0;
+
+static bool traceOpen = false;
+static trace_record_t traceCurrent;
+static uint32_t traceStarted[TRACE_STAGES];
+
+#if !defined(LEDGER_SPECIFIC)
+static trace_hook_t traceHook = NULL;
+
+void trace_set_hook(trace_hook_t hook) { traceHook = hook; }
+#endif
+
+void trace_begin(uint8_t ins) {
+    MEMZERO(&traceCurrent, sizeof(traceCurrent));
+    MEMZERO(traceStarted, sizeof(traceStarted));
+    traceCurrent.ins = ins;
+    traceOpen = true;
+}
+
+void trace_stage_start(trace_stage_e stage) {
+    if (stage >= TRACE_STAGES) {
+        return;
+    }
+    traceStarted[stage] = TRACE_CLOCK();
+}
+
+void trace_stage_stop(trace_stage_e stage) {
+    if (stage >= TRACE_STAGES) {
+        return;
+    }
+    const uint32_t ticks = (uint32_t)TRACE_CLOCK() - traceStarted[stage];
+
+#if !defined(LEDGER_SPECIFIC)
+    if (traceHook != NULL) {
+        traceHook(stage, ticks);
+    }
+#endif
+
+    if (traceOpen) {
+        traceCurrent.ticks[stage] += ticks;
+    }
+}
+
+void trace_end(uint16_t sw) {
+    if (!traceOpen) {
+        return;
+    }
+    traceOpen = false;
+    traceCurrent.sw = sw;
+
+    traceRing[traceNext] = traceCurrent;
+    traceNext = (traceNext + 1) % TRACE_RING_SIZE;
+    if (traceCount < TRACE_RING_SIZE) {
+        traceCount++;
+    }
+}
+
+void trace_reset() {
+    traceOpen = false;
+    traceNext = 0;
+    traceCount = 0;
+    MEMZERO(traceRing, sizeof(traceRing));
+}
+
+uint16_t trace_serialize(uint8_t *out, uint16_t outLen, uint8_t count) {
+    if (out == NULL || outLen < 1) {
+        return 0;
+    }
+    if (count == 0 || count > traceCount) {
+        count = traceCount;
+    }
+    if (count > (outLen - 1) / TRACE_RECORD_LEN) {
+        count = (outLen - 1) / TRACE_RECORD_LEN;
+    }
+
+    uint8_t *p = out;
+    *p++ = count;
+    for (uint8_t i = 0; i < count; i++) {
+        const trace_record_t *r = &traceRing[(traceNext + TRACE_RING_SIZE - 1 - i) % TRACE_RING_SIZE];
+        *p++ = r->ins;
+        *p++ = r->sw >> 8;
+        *p++ = r->sw & 0xFF;
+        for (uint8_t s = 0; s < TRACE_STAGES; s++) {
+            *p++ = (r->ticks[s] >> 24) & 0xFF;
+            *p++ = (r->ticks[s] >> 16) & 0xFF;
+            *p++ = (r->ticks[s] >> 8) & 0xFF;
+            *p++ = r->ticks[s] & 0xFF;
+        }
+    }
+
+    return (uint16_t)(p - out);
+}
+
+#endif
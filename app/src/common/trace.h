@@ -0,0 +1,85 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// Stages of the sign path, from the last chunk to the signature
+/// Time spent waiting for the user is not part of any stage
+typedef enum {
+    trace_parse = 0,
+    trace_validate,
+    trace_review,
+    trace_hash,
+    trace_derive,
+    trace_sign,
+    TRACE_STAGES
+} trace_stage_e;
+
+/// Most recent sign requests kept
+#define TRACE_RING_SIZE 8
+/// [ins][sw (2 bytes, BE)][ticks per stage (4 bytes each, BE)]
+#define TRACE_RECORD_LEN (3 + 4 * TRACE_STAGES)
+
+typedef struct {
+    uint8_t ins;
+    uint16_t sw;
+    /// Ticks spent in each stage, summed when a stage runs more than once
+    uint32_t ticks[TRACE_STAGES];
+} trace_record_t;
+
+// Only builds with APP_TRACE pay for the instrumentation
+#if defined(APP_TRACE)
+#define TRACE_BEGIN(ins) trace_begin(ins);
+#define TRACE_START(stage) trace_stage_start(stage);
+#define TRACE_STOP(stage) trace_stage_stop(stage);
+#define TRACE_END(sw) trace_end(sw);
+#else
+#define TRACE_BEGIN(ins)
+#define TRACE_START(stage)
+#define TRACE_STOP(stage)
+#define TRACE_END(sw)
+#endif
+
+/// Opens a trace for the request, dropping one left open
+void trace_begin(uint8_t ins);
+void trace_stage_start(trace_stage_e stage);
+void trace_stage_stop(trace_stage_e stage);
+/// Closes the open trace with the reply status word and stores it, nothing happens if none is open
+void trace_end(uint16_t sw);
+
+/// Drops every stored trace
+void trace_reset();
+
+/// Writes up to count stored traces, newest first, as [n] followed by n records
+/// \param count 0 for all of them
+/// \return bytes written
+uint16_t trace_serialize(uint8_t *out, uint16_t outLen, uint8_t count);
+
+#if !defined(LEDGER_SPECIFIC)
+/// Host builds can watch every stage as it completes, e.g. to feed a benchmark
+typedef void (*trace_hook_t)(trace_stage_e stage, uint32_t ticks);
+void trace_set_hook(trace_hook_t hook);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -19,13 +19,19 @@
 #include <string.h>
 
 #include "apdu_codes.h"
-#include "buffering.h"
 #include "parser.h"
 #include "parser_common.h"
+#include "trace.h"
+#include "tx_buffer.h"
 #include "zxmacros.h"
 
+// Transactions that fit in RAM never touch flash, bigger ones are streamed into flash one window at a time
 #define RAM_BUFFER_SIZE 8192
+#if defined(TARGET_NANOS)
 #define FLASH_BUFFER_SIZE 16384
+#else
+#define FLASH_BUFFER_SIZE 32768
+#endif
 
 // Ram
 uint8_t ram_buffer[RAM_BUFFER_SIZE];
@@ -36,14 +42,17 @@ typedef struct {
 } storage_t;
 
 #if defined(LEDGER_SPECIFIC)
-storage_t NV_CONST N_appdata_impl __attribute__((aligned(64)));
+storage_t NV_CONST N_appdata_impl __attribute__((aligned(TX_BUFFER_PAGE_SIZE)));
 #define N_appdata (*(NV_VOLATILE storage_t *)PIC(&N_appdata_impl))
+#else
+// Host builds keep the flash buffer in RAM
+storage_t N_appdata __attribute__((aligned(TX_BUFFER_PAGE_SIZE)));
 #endif
 
 parser_context_t ctx_parsed_tx;
 
 void tx_initialize() {
-    buffering_init(ram_buffer, sizeof(ram_buffer), (uint8_t *)N_appdata.buffer, sizeof(N_appdata.buffer));
+    tx_buffer_init(ram_buffer, sizeof(ram_buffer), (uint8_t *)N_appdata.buffer, sizeof(N_appdata.buffer));
 }
 
 void tx_initialize_oasis() {
@@ -56,16 +65,30 @@ void tx_initialize_eth() {
     tx_initialize();
 }
 
-void tx_reset() { buffering_reset(); }
+void tx_initialize_batch() {
+    ctx_parsed_tx.tx_type = oasis_batch_tx;
+    tx_initialize();
+}
+
+void tx_reset() { tx_buffer_reset(); }
+
+uint32_t tx_append(unsigned char *buffer, uint32_t length) { return tx_buffer_append(buffer, length); }
 
-uint32_t tx_append(unsigned char *buffer, uint32_t length) { return buffering_append(buffer, length); }
+uint32_t tx_get_buffer_length() { return tx_buffer_length(); }
 
-uint32_t tx_get_buffer_length() { return buffering_get_buffer()->pos; }
+uint8_t *tx_get_buffer() { return (uint8_t *)tx_buffer_data(); }
 
-uint8_t *tx_get_buffer() { return buffering_get_buffer()->data; }
+uint32_t tx_read(uint32_t offset, uint8_t *out, uint32_t length) { return tx_buffer_read(offset, out, length); }
 
 const char *tx_parse(uint8_t *parser_err) {
+    const tx_buffer_stats_t *stats = tx_buffer_stats();
+    ZEMU_LOGF(100, "tx buffer: %u bytes, peak %u staged %u flash pages %u/%u\n", (unsigned int)tx_get_buffer_length(),
+              (unsigned int)stats->maxLength, (unsigned int)stats->maxStaged, (unsigned int)stats->flashPages,
+              (unsigned int)stats->maxFlashPages);
+
+    TRACE_START(trace_parse)
     uint8_t err = parser_parse(&ctx_parsed_tx, tx_get_buffer(), tx_get_buffer_length());
+    TRACE_STOP(trace_parse)
 
     *parser_err = err;
     if (err != parser_ok) {
@@ -73,7 +96,9 @@ const char *tx_parse(uint8_t *parser_err) {
         return parser_getErrorDescription(err);
     }
 
+    TRACE_START(trace_validate)
     err = parser_validate(&ctx_parsed_tx);
+    TRACE_STOP(trace_validate)
     CHECK_APP_CANARY()
 
     if (err != parser_ok) {
@@ -83,6 +108,19 @@ const char *tx_parse(uint8_t *parser_err) {
     return NULL;
 }
 
+const char *tx_parse_header(uint8_t *parser_err) {
+    uint32_t length = 0;
+    const uint8_t *head = tx_buffer_head(&length);
+
+    const parser_error_t err = parser_parseHeader(&ctx_parsed_tx, head, length);
+    *parser_err = err;
+    if (err == parser_ok || err == parser_no_data) {
+        return NULL;
+    }
+
+    return parser_getErrorDescription(err);
+}
+
 zxerr_t tx_getNumItems(uint8_t *num_items) {
     parser_error_t err = parser_getNumItems(&ctx_parsed_tx, num_items);
 
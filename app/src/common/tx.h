@@ -24,6 +24,7 @@
 void tx_initialize();
 void tx_initialize_oasis();
 void tx_initialize_eth();
+void tx_initialize_batch();
 /// Clears the transaction buffer
 void tx_reset();
 
@@ -39,14 +40,23 @@ uint32_t tx_append(unsigned char *buffer, uint32_t length);
 uint32_t tx_get_buffer_length();
 
 /// Returns the raw json transaction buffer
+/// Once the transaction has spilled into flash this writes the staged tail, so only call it when all chunks are in
 /// \return
 uint8_t *tx_get_buffer();
 
+/// Copies part of the transaction buffer without finishing it
+/// \return number of bytes copied
+uint32_t tx_read(uint32_t offset, uint8_t *out, uint32_t length);
+
 /// Parse message stored in transaction buffer
 /// This function should be called as soon as full buffer data is loaded.
 /// \return It returns NULL if data is valid or error message otherwise.
 const char *tx_parse(uint8_t *parser_err);
 
+/// Checks the header of a transaction that is still being received
+/// \return It returns NULL if the header is valid or not complete yet (parser_no_data), error message otherwise.
+const char *tx_parse_header(uint8_t *parser_err);
+
 /// Return the number of items in the transaction
 zxerr_t tx_getNumItems(uint8_t *num_items);
 
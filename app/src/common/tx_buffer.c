@@ -0,0 +1,154 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "tx_buffer.h"
+
+#include "zxmacros.h"
+
+typedef struct {
+    uint8_t *window;
+    uint32_t windowSize;
+    uint8_t *flash;
+    uint32_t flashSize;
+
+    // bytes already committed to flash, always a whole number of windows
+    uint32_t flushed;
+    // bytes of the transaction currently held in the window
+    uint32_t staged;
+    // flash also holds the staged tail
+    bool synced;
+} tx_buffer_t;
+
+static tx_buffer_t txBuffer;
+static tx_buffer_stats_t txBufferStats;
+
+static void _flush(uint32_t length) {
+    const uint32_t pages = (length + TX_BUFFER_PAGE_SIZE - 1) / TX_BUFFER_PAGE_SIZE;
+
+    // The window is a whole number of pages, so rounding up never reads past it
+    MEMCPY_NV(txBuffer.flash + txBuffer.flushed, txBuffer.window, pages * TX_BUFFER_PAGE_SIZE);
+
+    txBufferStats.flashPages += pages;
+    if (txBufferStats.flashPages > txBufferStats.maxFlashPages) {
+        txBufferStats.maxFlashPages = txBufferStats.flashPages;
+    }
+}
+
+void tx_buffer_init(uint8_t *window, uint32_t windowSize, uint8_t *flash, uint32_t flashSize) {
+    txBuffer.window = window;
+    // Never stage more than flash can hold, the transaction length is checked against flashSize
+    txBuffer.windowSize = windowSize > flashSize ? flashSize : windowSize;
+    txBuffer.flash = flash;
+    txBuffer.flashSize = flashSize;
+    tx_buffer_reset();
+}
+
+void tx_buffer_reset() {
+    txBuffer.flushed = 0;
+    txBuffer.staged = 0;
+    txBuffer.synced = false;
+    txBufferStats.flashPages = 0;
+}
+
+uint32_t tx_buffer_append(const uint8_t *data, uint32_t length) {
+    if (data == NULL || txBuffer.window == NULL) {
+        return 0;
+    }
+
+    if (length > txBuffer.flashSize - tx_buffer_length()) {
+        return 0;
+    }
+
+    uint32_t remaining = length;
+    while (remaining > 0) {
+        // Full windows are only flushed once more data arrives, so anything that fits in RAM never touches flash
+        if (txBuffer.staged == txBuffer.windowSize) {
+            _flush(txBuffer.windowSize);
+            txBuffer.flushed += txBuffer.windowSize;
+            txBuffer.staged = 0;
+        }
+
+        uint32_t n = txBuffer.windowSize - txBuffer.staged;
+        if (n > remaining) {
+            n = remaining;
+        }
+        MEMCPY(txBuffer.window + txBuffer.staged, data, n);
+        txBuffer.staged += n;
+        data += n;
+        remaining -= n;
+    }
+    txBuffer.synced = false;
+
+    if (txBuffer.staged > txBufferStats.maxStaged) {
+        txBufferStats.maxStaged = txBuffer.staged;
+    }
+    if (tx_buffer_length() > txBufferStats.maxLength) {
+        txBufferStats.maxLength = tx_buffer_length();
+    }
+
+    return length;
+}
+
+uint32_t tx_buffer_length() { return txBuffer.flushed + txBuffer.staged; }
+
+uint32_t tx_buffer_read(uint32_t offset, uint8_t *out, uint32_t length) {
+    const uint32_t total = tx_buffer_length();
+    if (out == NULL || offset >= total) {
+        return 0;
+    }
+    if (length > total - offset) {
+        length = total - offset;
+    }
+
+    uint32_t copied = 0;
+    if (offset < txBuffer.flushed) {
+        copied = txBuffer.flushed - offset;
+        if (copied > length) {
+            copied = length;
+        }
+        MEMCPY(out, txBuffer.flash + offset, copied);
+    }
+    if (copied < length) {
+        MEMCPY(out + copied, txBuffer.window + (offset + copied - txBuffer.flushed), length - copied);
+    }
+
+    return length;
+}
+
+const uint8_t *tx_buffer_head(uint32_t *length) {
+    if (txBuffer.flushed == 0) {
+        *length = txBuffer.staged;
+        return txBuffer.window;
+    }
+
+    *length = txBuffer.flushed;
+    return txBuffer.flash;
+}
+
+const uint8_t *tx_buffer_data() {
+    if (txBuffer.flushed == 0) {
+        return txBuffer.window;
+    }
+
+    if (!txBuffer.synced) {
+        // The staged bytes stay in the window, a later append just rewrites the same pages
+        _flush(txBuffer.staged);
+        txBuffer.synced = true;
+    }
+
+    return txBuffer.flash;
+}
+
+const tx_buffer_stats_t *tx_buffer_stats() { return &txBufferStats; }
@@ -0,0 +1,79 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// Flash is only ever written in whole pages starting at page boundaries
+#ifndef TX_BUFFER_PAGE_SIZE
+#define TX_BUFFER_PAGE_SIZE 64
+#endif
+
+typedef struct {
+    /// Longest transaction buffered since boot
+    uint32_t maxLength;
+    /// Most bytes held in the RAM window at the same time
+    uint32_t maxStaged;
+    /// Flash pages written for the current transaction
+    uint32_t flashPages;
+    /// Most flash pages written for a single transaction since boot
+    uint32_t maxFlashPages;
+} tx_buffer_stats_t;
+
+/// Sets up the transaction buffer
+/// Chunks are staged in the RAM window and only moved to flash, one full window
+/// at a time, once the transaction outgrows it. Both sizes must be multiples of
+/// TX_BUFFER_PAGE_SIZE and flash must be page aligned. A window larger than flash is only used up to flashSize.
+/// \param window RAM staging window
+/// \param windowSize
+/// \param flash flash backing storage
+/// \param flashSize maximum transaction length
+void tx_buffer_init(uint8_t *window, uint32_t windowSize, uint8_t *flash, uint32_t flashSize);
+
+/// Drops the current transaction, high-water marks are kept
+void tx_buffer_reset();
+
+/// Appends data to the end of the transaction
+/// \return length if it was appended, 0 if it does not fit
+uint32_t tx_buffer_append(const uint8_t *data, uint32_t length);
+
+/// Returns the number of bytes in the transaction
+uint32_t tx_buffer_length();
+
+/// Copies up to length bytes starting at offset, wherever they currently live
+/// Unlike tx_buffer_data it never writes to flash, so it can be used while chunks are still arriving
+/// \return number of bytes copied
+uint32_t tx_buffer_read(uint32_t offset, uint8_t *out, uint32_t length);
+
+/// Returns the longest prefix of the transaction that is contiguous without writing to flash
+/// It covers at least the first window, or the whole transaction if it is shorter
+const uint8_t *tx_buffer_head(uint32_t *length);
+
+/// Returns the whole transaction as a contiguous buffer
+/// If the transaction spilled into flash the staged tail is written first
+const uint8_t *tx_buffer_data();
+
+/// Returns the buffer high-water marks
+const tx_buffer_stats_t *tx_buffer_stats();
+
+#ifdef __cplusplus
+}
+#endif
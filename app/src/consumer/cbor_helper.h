@@ -19,6 +19,7 @@
 
 #include "cbor.h"
 #include "parser_common.h"
+#include "parser_txdef_con.h"
 
 __Z_INLINE parser_error_t parser_mapCborError(CborError err) {
     switch (err) {
@@ -63,6 +64,27 @@ __Z_INLINE parser_error_t parser_mapCborError(CborError err) {
     CborParser parser;          \
     CHECK_CBOR_ERR(cbor_parser_init(c->buffer + c->offset, c->bufferLen - c->offset, 0, &parser, &it))
 
+// Verifies that the item is well formed (no missing bytes...) unless it lies inside the range that was already
+// validated in this parse. cbor_value_validate_basic walks the whole subtree, so every item inside a validated
+// range is a sub-item that was covered by that walk. Only use it with values from the transaction buffer parser:
+// parsers opened over the contents of a byte string share its bytes without being validated.
+__Z_INLINE parser_error_t _validateOnce(cbor_validated_range_t *range, const CborValue *it) {
+    const uint8_t *start = cbor_value_get_next_byte(it);
+    if (range->start != NULL && range->bufferEnd == it->parser->source.end && start >= range->start &&
+        start < range->end) {
+        return parser_ok;
+    }
+
+    // Same walk as cbor_value_validate_basic, keeping the position where the item ends
+    CborValue next = *it;
+    CHECK_CBOR_ERR(cbor_value_advance(&next))
+
+    range->start = start;
+    range->end = cbor_value_get_next_byte(&next);
+    range->bufferEnd = it->parser->source.end;
+    return parser_ok;
+}
+
 __Z_INLINE parser_error_t _matchKey(CborValue *value, const char *expectedKey) {
     CHECK_CBOR_TYPE(cbor_value_get_type(value), CborTextStringType)
 
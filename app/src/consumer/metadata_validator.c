@@ -0,0 +1,113 @@
+/*******************************************************************************
+ *  (c) 2019 Zondax GmbH
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "metadata_validator.h"
+
+// All validators share one 256-entry table that maps every byte to the set of
+// character classes it belongs to. Fields are validated in a single pass that
+// only combines table lookups with bitwise operations: there are no data
+// dependent branches and no early exits, so the compiler is free to unroll or
+// vectorize the loops and the cost only depends on the field length.
+
+#define CC_PRINTABLE 0x01  // 33..127, no spaces
+#define CC_URL 0x02        // printable, neither '?' (query) nor '#' (fragment)
+#define CC_DOMAIN 0x04     // [A-Za-z0-9.-]
+#define CC_HANDLE 0x08     // [A-Za-z0-9_-]
+#define CC_AT 0x10         // '@'
+#define CC_DOT 0x20        // '.'
+
+static const uint8_t CHAR_CLASS[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0x00
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0x10
+    0x00, 0x03, 0x03, 0x01, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x0F, 0x27, 0x03,  // 0x20
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x03, 0x03, 0x03, 0x03, 0x03, 0x01,  // 0x30
+    0x13, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,  // 0x40
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x03, 0x03, 0x03, 0x03, 0x0B,  // 0x50
+    0x03, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,  // 0x60
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x03, 0x03, 0x03, 0x03, 0x03,  // 0x70
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0x80
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0x90
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0xA0
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0xB0
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0xC0
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0xD0
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0xE0
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0xF0
+};
+
+static const char URL_PREFIX[] = "https://";
+#define URL_PREFIX_LEN (sizeof(URL_PREFIX) - 1)
+
+static bool isValidUrl(const uint8_t *data, size_t dataLen) {
+    if (dataLen < URL_PREFIX_LEN) {
+        return false;
+    }
+
+    uint8_t classes = 0xFF;
+    uint8_t prefix_diff = 0;
+    for (size_t i = 0; i < URL_PREFIX_LEN; i++) {
+        classes &= CHAR_CLASS[data[i]];
+        prefix_diff |= data[i] ^ (uint8_t)URL_PREFIX[i];
+    }
+    for (size_t i = URL_PREFIX_LEN; i < dataLen; i++) {
+        classes &= CHAR_CLASS[data[i]];
+    }
+
+    return prefix_diff == 0 && (classes & CC_URL) != 0;
+}
+
+static bool isValidEmail(const uint8_t *data, size_t dataLen) {
+    // after_at is the DFA state: all zeros while in the local part and all
+    // ones once an '@' has been seen. A second '@' is not a domain character.
+    uint8_t classes = 0xFF;
+    uint8_t after_at = 0;
+    uint8_t domain_bad = 0;
+    uint8_t domain_seen = 0;
+    for (size_t i = 0; i < dataLen; i++) {
+        const uint8_t c = CHAR_CLASS[data[i]];
+        classes &= c;
+        domain_bad |= after_at & (uint8_t)~c;
+        domain_seen |= after_at & c;
+        after_at |= (uint8_t)(0u - ((c & CC_AT) >> 4));
+    }
+
+    return (classes & CC_PRINTABLE) != 0 && after_at != 0 && (domain_bad & CC_DOMAIN) == 0 &&
+           (domain_seen & CC_DOT) != 0;
+}
+
+static bool isValidHandle(const uint8_t *data, size_t dataLen) {
+    uint8_t classes = 0xFF;
+    for (size_t i = 0; i < dataLen; i++) {
+        classes &= CHAR_CLASS[data[i]];
+    }
+    return (classes & CC_HANDLE) != 0;
+}
+
+bool metadata_is_valid(metadata_field_e field, const uint8_t *data, size_t dataLen) {
+    if (data == NULL && dataLen > 0) {
+        return false;
+    }
+
+    switch (field) {
+        case metadata_field_url:
+            return isValidUrl(data, dataLen);
+        case metadata_field_email:
+            return isValidEmail(data, dataLen);
+        case metadata_field_handle:
+            return isValidHandle(data, dataLen);
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ *  (c) 2019 Zondax GmbH
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    metadata_field_url = 0,
+    metadata_field_email,
+    metadata_field_handle,
+} metadata_field_e;
+
+/// Validates an entity metadata field in a single pass over its bytes
+/// \param field kind of field, selects the character classes and rules
+/// \param data field contents (not necessarily zero terminated)
+/// \param dataLen number of bytes in data
+/// \return true if the field matches the rules of its kind
+bool metadata_is_valid(metadata_field_e field, const uint8_t *data, size_t dataLen);
+
+#ifdef __cplusplus
+}
+#endif
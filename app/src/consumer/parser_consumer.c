@@ -37,8 +37,6 @@ static const char *blindSignWarning =
     "transactions without reviewing each transaction field. "
     "If you are not sure why you are here, reject or unplug your device immediately.";
 
-const char addressV0_Secp256k1_ethContext[40] = "oasis-runtime-sdk/address: secp256k1eth";
-
 #if defined(LEDGER_SPECIFIC)
 // For some reason NanoX requires this function
 void __assert_fail(__Z_UNUSED const char *assertion, __Z_UNUSED const char *file, __Z_UNUSED unsigned int line,
@@ -83,12 +81,43 @@ static const char *methodsMap[] = {
     "        Call      (ParaTime)",
 };
 
+#if defined(APP_BATCH_SIGNING)
+__Z_INLINE parser_error_t parser_parseBatch(parser_context_t *ctx) {
+    CHECK_PARSER_ERR(_readBatchHeader(ctx, &parser_tx_obj, &parser_batch_obj))
+
+    for (uint8_t i = 0; i < parser_batch_obj.count; i++) {
+        // Every transaction goes through the same checks as if it was signed alone
+        parser_context_t txCtx = *ctx;
+        txCtx.tx_type = oasis_tx;
+        txCtx.offset = parser_batch_obj.txOffset[i];
+        txCtx.bufferLen = parser_batch_obj.txOffset[i] + parser_batch_obj.txLen[i];
+
+        CHECK_PARSER_ERR(_read(&txCtx, &parser_tx_obj))
+        // Anything after the root item would be signed without being shown
+        if (parser_tx_obj.validated.end != txCtx.buffer + txCtx.bufferLen) {
+            return parser_unexpected_characters;
+        }
+        CHECK_PARSER_ERR(parser_validate(&txCtx))
+        CHECK_PARSER_ERR(_addToBatch(&parser_batch_obj, &parser_tx_obj))
+    }
+
+    return parser_ok;
+}
+#endif
+
 parser_error_t parser_parse(parser_context_t *ctx, const uint8_t *data, size_t dataLen) {
     if (ctx->tx_type == eth_tx) {
         CHECK_PARSER_ERR(parser_init(ctx, data, dataLen))
         return _readEth(ctx, &eth_tx_obj);
     }
 
+#if defined(APP_BATCH_SIGNING)
+    if (ctx->tx_type == oasis_batch_tx) {
+        CHECK_PARSER_ERR(parser_init(ctx, data, dataLen))
+        return parser_parseBatch(ctx);
+    }
+#endif
+
     CHECK_PARSER_ERR(parser_init(ctx, data, dataLen))
     CHECK_PARSER_ERR(_readContext(ctx, &parser_tx_obj))
     CHECK_PARSER_ERR(_extractContextSuffix(&parser_tx_obj))
@@ -104,8 +133,22 @@ parser_error_t parser_parse(parser_context_t *ctx, const uint8_t *data, size_t d
     return parser_ok;
 }
 
+parser_error_t parser_parseHeader(parser_context_t *ctx, const uint8_t *data, size_t dataLen) {
+    // Only single oasis transactions have a header worth checking early
+    if (ctx->tx_type != oasis_tx) {
+        return parser_ok;
+    }
+
+    if (dataLen == 0) {
+        return parser_no_data;
+    }
+
+    CHECK_PARSER_ERR(parser_init(ctx, data, dataLen))
+    return _readHeader(ctx, &parser_tx_obj);
+}
+
 parser_error_t parser_validate(const parser_context_t *ctx) {
-    if (ctx->tx_type != eth_tx) {
+    if (ctx->tx_type == oasis_tx) {
         CHECK_PARSER_ERR(_validateTx(ctx, &parser_tx_obj))
     }
 
@@ -138,6 +181,15 @@ parser_error_t parser_getNumItems(const parser_context_t *ctx, uint8_t *num_item
             *num_items = _getNumItemsEth(ctx);
             break;
         }
+#if defined(APP_BATCH_SIGNING)
+        case oasis_batch_tx: {
+            *num_items = _getNumItemsBatch(&parser_batch_obj);
+            if (parser_tx_obj.context.suffixLen > 0) {
+                (*num_items)++;
+            }
+            break;
+        }
+#endif
         default:
             return parser_unsupported_tx;
     }
@@ -401,6 +453,14 @@ __Z_INLINE parser_error_t parser_getType(__Z_UNUSED const parser_context_t *ctx,
     return parser_unexpected_method;
 }
 
+// Copies a byte string view into a fixed size field, zero padded on the right
+__Z_INLINE void _copyBytesView(uint8_t *out, size_t outLen, const bytes_view_t *view) {
+    MEMZERO(out, outLen);
+    if (view->buffer != NULL) {
+        MEMCPY(out, view->buffer, view->len < outLen ? view->len : outLen);
+    }
+}
+
 #define LESS_THAN_64_DIGIT(num_digit) \
     if (num_digit > 64) return parser_value_out_of_range;
 
@@ -686,33 +746,6 @@ __Z_INLINE parser_error_t parser_printVersion(const version_t ver, char *outVal,
     return parser_ok;
 }
 
-__Z_INLINE parser_error_t parser_ethMapNative(const uint8_t *ethstr, const uint16_t ethstrLen, uint8_t *native,
-                                              const uint16_t nativeLen) {
-    if (nativeLen < ADDR_RAW || native == NULL) {
-        return parser_unexpected_value;
-    }
-
-    uint8_t ethaddr[ETH_ADDR_LEN] = {0};
-    uint8_t total[ETH_MAP_BUFFER] = {0};
-    uint8_t messageDigest[SHA512_DIGEST_LENGTH] = {0};
-
-    // Take Eth addr without 0x
-    hexstr_to_array(ethaddr, ETH_ADDR_LEN, (char *)&ethstr[2], ethstrLen - 2);
-    // Concatenate Eth Context + version (= 0) + ethaddr (more info on oasis-SDK)
-    MEMCPY(total, addressV0_Secp256k1_ethContext, sizeof(addressV0_Secp256k1_ethContext));
-    MEMCPY(total + sizeof(addressV0_Secp256k1_ethContext), ethaddr, ETH_ADDR_LEN);
-    SHA512_256(total, sizeof(total), messageDigest);
-
-    uint8_t addressRaw[ADDR_RAW] = {0};
-    MEMCPY(addressRaw + 1, messageDigest, ETH_ADDR_LEN);
-
-    if (MEMCMP(addressRaw, native, ADDR_RAW) == 0) {
-        return parser_ok;
-    }
-
-    return parser_invalid_eth_mapping;
-}
-
 __Z_INLINE parser_error_t parser_getItemRuntimeConsensus(const parser_context_t *ctx, const int8_t displayIdx, char *outKey,
                                                          uint16_t outKeyLen, char *outVal, uint16_t outValLen,
                                                          uint8_t pageIdx, uint8_t *pageCount) {
@@ -732,10 +765,10 @@ __Z_INLINE parser_error_t parser_getItemRuntimeConsensus(const parser_context_t
             snprintf(outVal, outValLen, "Self");
             if (parser_tx_obj.oasis.runtime.meta.has_orig_to) {
                 if (parser_tx_obj.oasis.runtime.call.body.consensus.has_to) {
-                    CHECK_PARSER_ERR(parser_ethMapNative((uint8_t *)parser_tx_obj.oasis.runtime.meta.orig_to,
-                                                         sizeof(parser_tx_obj.oasis.runtime.meta.orig_to),
-                                                         (uint8_t *)parser_tx_obj.oasis.runtime.call.body.consensus.to,
-                                                         sizeof(parser_tx_obj.oasis.runtime.call.body.consensus.to)));
+                    if (MEMCMP(parser_tx_obj.oasis.runtime.meta.orig_to_native,
+                               parser_tx_obj.oasis.runtime.call.body.consensus.to, ADDR_RAW) != 0) {
+                        return parser_invalid_eth_mapping;
+                    }
                     pageStringExt(outVal, outValLen, (char *)parser_tx_obj.oasis.runtime.meta.orig_to, 42, pageIdx,
                                   pageCount);
                     return parser_ok;
@@ -966,8 +999,9 @@ __Z_INLINE parser_error_t parser_getItemRuntimeEncrypted(const parser_context_t
         }
         case 2: {
             snprintf(outKey, outKeyLen, "Tx Hash");
-            if (array_to_hexstr(outBuffer, sizeof(outBuffer),
-                                (uint8_t *)&parser_tx_obj.oasis.runtime.call.body.encrypted.data_hash, 32) != 64) {
+            CHECK_PARSER_ERR(_getDataHash(&parser_tx_obj.oasis.runtime.call.body.encrypted.data))
+            if (array_to_hexstr(outBuffer, sizeof(outBuffer), parser_tx_obj.oasis.runtime.call.body.encrypted.data.hash,
+                                sizeof(parser_tx_obj.oasis.runtime.call.body.encrypted.data.hash)) != 64) {
                 return parser_unexpected_value;
             }
             pageString(outVal, outValLen, outBuffer, pageIdx, pageCount);
@@ -980,8 +1014,9 @@ __Z_INLINE parser_error_t parser_getItemRuntimeEncrypted(const parser_context_t
         }
         case 4: {
             snprintf(outKey, outKeyLen, "Nonce");
-            if (array_to_hexstr(outBuffer, sizeof(outBuffer),
-                                (uint8_t *)&parser_tx_obj.oasis.runtime.call.body.encrypted.nonce, 15) != 30) {
+            uint8_t nonce[15] = {0};
+            _copyBytesView(nonce, sizeof(nonce), &parser_tx_obj.oasis.runtime.call.body.encrypted.nonce);
+            if (array_to_hexstr(outBuffer, sizeof(outBuffer), nonce, sizeof(nonce)) != 30) {
                 return parser_unexpected_value;
             }
             pageString(outVal, outValLen, outBuffer, pageIdx, pageCount);
@@ -1039,8 +1074,9 @@ __Z_INLINE parser_error_t parser_getItemRuntimeEvm(const parser_context_t *ctx,
         }
         case 2: {
             snprintf(outKey, outKeyLen, "Tx Hash");
-            if (array_to_hexstr(outBuffer, sizeof(outBuffer),
-                                (uint8_t *)&parser_tx_obj.oasis.runtime.call.body.evm.data_hash, 32) != 64) {
+            CHECK_PARSER_ERR(_getDataHash(&parser_tx_obj.oasis.runtime.call.body.evm.data))
+            if (array_to_hexstr(outBuffer, sizeof(outBuffer), parser_tx_obj.oasis.runtime.call.body.evm.data.hash,
+                                sizeof(parser_tx_obj.oasis.runtime.call.body.evm.data.hash)) != 64) {
                 return parser_unexpected_value;
             }
             pageString(outVal, outValLen, outBuffer, pageIdx, pageCount);
@@ -1048,8 +1084,9 @@ __Z_INLINE parser_error_t parser_getItemRuntimeEvm(const parser_context_t *ctx,
         }
         case 3: {
             snprintf(outKey, outKeyLen, "Address");
-            if (array_to_hexstr(outBuffer, sizeof(outBuffer), (uint8_t *)&parser_tx_obj.oasis.runtime.call.body.evm.address,
-                                ETH_ADDR_LEN) != 40) {
+            uint8_t address[ETH_ADDR_LEN] = {0};
+            _copyBytesView(address, sizeof(address), &parser_tx_obj.oasis.runtime.call.body.evm.address);
+            if (array_to_hexstr(outBuffer, sizeof(outBuffer), address, sizeof(address)) != 40) {
                 return parser_unexpected_value;
             }
             pageString(outVal, outValLen, outBuffer, pageIdx, pageCount);
@@ -1776,6 +1813,78 @@ __Z_INLINE parser_error_t parser_getItemTx(const parser_context_t *ctx, int8_t d
     return parser_no_data;
 }
 
+#if defined(APP_BATCH_SIGNING)
+__Z_INLINE parser_error_t parser_printBatchAmount(oasis_methods_e method, const uint8_t *amount, char *outVal,
+                                                  uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
+    const quantity_t q = {.buffer = amount, .len = BATCH_AMOUNT_LEN};
+    if (method == stakingReclaimEscrow) {
+        return parser_printShares(&q, outVal, outValLen, pageIdx, pageCount);
+    }
+    return parser_printQuantity(&q, &parser_tx_obj.context, outVal, outValLen, pageIdx, pageCount);
+}
+
+__Z_INLINE parser_error_t parser_getItemBatch(uint16_t displayIdx, char *outKey, uint16_t outKeyLen, char *outVal,
+                                              uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
+    const batch_summary_t *b = &parser_batch_obj;
+
+    if (displayIdx == 0) {
+        snprintf(outKey, outKeyLen, "Type");
+        snprintf(outVal, outValLen, "Batch (%d %s)", b->count, b->count == 1 ? "tx" : "txs");
+        *pageCount = 1;
+        return parser_ok;
+    }
+
+    // Each method is followed by its destinations
+    uint16_t idx = 1;
+    for (uint8_t m = 0; m < b->methodsLen; m++) {
+        const batch_method_t *method = &b->methods[m];
+        if (displayIdx == idx) {
+            snprintf(outKey, outKeyLen, "%s", (const char *)PIC(methodsMap[method->method]));
+            snprintf(outVal, outValLen, "%d %s", method->count, method->count == 1 ? "tx" : "txs");
+            *pageCount = 1;
+            return parser_ok;
+        }
+        if (displayIdx == idx + 1) {
+            snprintf(outKey, outKeyLen, "Total");
+            return parser_printBatchAmount(method->method, method->total, outVal, outValLen, pageIdx, pageCount);
+        }
+        idx += 2;
+
+        for (uint8_t d = 0; d < b->destinationsLen; d++) {
+            const batch_destination_t *destination = &b->destinations[d];
+            if (destination->method != method->method) {
+                continue;
+            }
+            const bool reclaim = destination->method == stakingReclaimEscrow;
+            if (displayIdx == idx) {
+                snprintf(outKey, outKeyLen, reclaim ? "From" : "To");
+                return parser_printAddress(&destination->address, outVal, outValLen, pageIdx, pageCount, false);
+            }
+            if (displayIdx == idx + 1) {
+                snprintf(outKey, outKeyLen, reclaim ? "Shares" : "Amount");
+                return parser_printBatchAmount(destination->method, destination->amount, outVal, outValLen, pageIdx,
+                                               pageCount);
+            }
+            idx += 2;
+        }
+    }
+
+    if (displayIdx == idx) {
+        snprintf(outKey, outKeyLen, "Fee");
+        const quantity_t fee = {.buffer = b->fee, .len = BATCH_AMOUNT_LEN};
+        return parser_printQuantity(&fee, &parser_tx_obj.context, outVal, outValLen, pageIdx, pageCount);
+    }
+    if (displayIdx == idx + 1) {
+        snprintf(outKey, outKeyLen, "Gas limit");
+        uint64_to_str(outVal, outValLen, b->gas);
+        *pageCount = 1;
+        return parser_ok;
+    }
+
+    return parser_display_idx_out_of_range;
+}
+#endif
+
 parser_error_t parser_getItemOasis(const parser_context_t *ctx, uint16_t displayIdx, char *outKey, uint16_t outKeyLen,
                                    char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
     MEMZERO(outKey, outKeyLen);
@@ -1822,6 +1931,10 @@ parser_error_t parser_getItemOasis(const parser_context_t *ctx, uint16_t display
             pageStringExt(outVal, outValLen, (const char *)parser_tx_obj.context.suffixPtr, parser_tx_obj.context.suffixLen,
                           pageIdx, pageCount);
         }
+#if defined(APP_BATCH_SIGNING)
+    } else if (ctx->tx_type == oasis_batch_tx) {
+        err = parser_getItemBatch(displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
+#endif
     } else {
         switch (parser_tx_obj.type) {
             case txType: {
@@ -1876,7 +1989,8 @@ parser_error_t parser_getItemOasis(const parser_context_t *ctx, uint16_t display
 parser_error_t parser_getItem(const parser_context_t *ctx, uint16_t displayIdx, char *outKey, uint16_t outKeyLen,
                               char *outVal, uint16_t outValLen, uint8_t pageIdx, uint8_t *pageCount) {
     switch (ctx->tx_type) {
-        case oasis_tx: {
+        case oasis_tx:
+        case oasis_batch_tx: {
             return parser_getItemOasis(ctx, displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
         }
         case eth_tx: {
@@ -30,8 +30,12 @@
 #endif
 
 #include "cbor_helper.h"
+#include "metadata_validator.h"
 
 parser_tx_t parser_tx_obj;
+#if defined(APP_BATCH_SIGNING)
+batch_summary_t parser_batch_obj;
+#endif
 
 const char context_prefix_tx[] = "oasis-core/consensus: tx for chain ";
 const char context_prefix_entity[] = "oasis-core/registry: register entity";
@@ -189,6 +193,81 @@ void parser_setCborState(cbor_parser_state_t *state, const CborParser *parser, c
     }
 }
 
+// SHA-256 over data that arrives in pieces, backed by cx on the device and picohash on the host
+typedef struct {
+#if defined(LEDGER_SPECIFIC)
+    cx_sha256_t ctx;
+#else
+    picohash_ctx_t ctx;
+#endif
+} sha256_stream_t;
+
+__Z_INLINE parser_error_t _sha256StreamInit(sha256_stream_t *stream) {
+    MEMZERO(stream, sizeof(sha256_stream_t));
+#if defined(LEDGER_SPECIFIC)
+    CHECK_CX_PARSER_OK(cx_sha256_init_no_throw(&stream->ctx))
+#else
+    picohash_init_sha256(&stream->ctx);
+#endif
+    return parser_ok;
+}
+
+__Z_INLINE parser_error_t _sha256StreamUpdate(sha256_stream_t *stream, const uint8_t *data, size_t dataLen) {
+#if defined(LEDGER_SPECIFIC)
+    CHECK_CX_PARSER_OK(cx_hash_no_throw(&stream->ctx.header, 0, data, dataLen, NULL, 0))
+#else
+    picohash_update(&stream->ctx, data, dataLen);
+#endif
+    return parser_ok;
+}
+
+__Z_INLINE parser_error_t _sha256StreamFinal(sha256_stream_t *stream, uint8_t *out, size_t outLen) {
+    if (outLen < CX_SHA256_SIZE) {
+        return parser_unexpected_buffer_size;
+    }
+#if defined(LEDGER_SPECIFIC)
+    CHECK_CX_PARSER_OK(cx_hash_no_throw(&stream->ctx.header, CX_LAST, NULL, 0, out, outLen))
+#else
+    picohash_final(&stream->ctx, out);
+#endif
+    return parser_ok;
+}
+
+parser_error_t _getDataHash(data_hash_t *data) {
+    if (data->hashed) {
+        return parser_ok;
+    }
+
+    sha256_stream_t stream;
+    CHECK_PARSER_ERR(_sha256StreamInit(&stream))
+
+    // Indefinite length strings are hashed chunk by chunk
+    CborValue it = data->cborState.startValue;
+    CHECK_CBOR_ERR(_cbor_value_begin_string_iteration(&it))
+    while (true) {
+        const uint8_t *chunk = NULL;
+        size_t chunkLen = 0;
+        const CborError err = _cbor_value_get_string_chunk(&it, (const void **)&chunk, &chunkLen, &it);
+        if (err == CborErrorNoMoreStringChunks) {
+            break;
+        }
+        CHECK_CBOR_ERR(err)
+        CHECK_PARSER_ERR(_sha256StreamUpdate(&stream, chunk, chunkLen))
+    }
+
+    CHECK_PARSER_ERR(_sha256StreamFinal(&stream, data->hash, sizeof(data->hash)))
+    data->hashed = true;
+    return parser_ok;
+}
+
+__Z_INLINE parser_error_t _readDataHash(CborValue *value, data_hash_t *out) {
+    CHECK_CBOR_TYPE(cbor_value_get_type(value), CborByteStringType)
+    MEMZERO(out, sizeof(data_hash_t));
+    // Only keep the position, the hash is computed when it is displayed
+    parser_setCborState(&out->cborState, value->parser, value);
+    return parser_ok;
+}
+
 __Z_INLINE parser_error_t _readAddressRaw(CborValue *value, address_raw_t *out) {
     CHECK_CBOR_TYPE(cbor_value_get_type(value), CborByteStringType)
     CborValue dummy;
@@ -218,15 +297,31 @@ __Z_INLINE parser_error_t _readPublicKey(CborValue *value, publickey_t *out) {
     return parser_ok;
 }
 
-__Z_INLINE parser_error_t _readQuantity(CborValue *value, quantity_t *out) {
+__Z_INLINE parser_error_t _readBytesView(CborValue *value, bytes_view_t *out) {
     CHECK_CBOR_TYPE(cbor_value_get_type(value), CborByteStringType)
-    CborValue dummy;
-    MEMZERO(out, sizeof(quantity_t));
-    out->len = sizeof_field(quantity_t, buffer);
-    CHECK_CBOR_ERR(cbor_value_copy_byte_string(value, (uint8_t *)out->buffer, &out->len, &dummy))
+    MEMZERO(out, sizeof(bytes_view_t));
+
+    // Canonical CBOR only has definite length strings, which are contiguous in the buffer
+    if (!cbor_value_is_length_known(value)) {
+        return parser_cbor_not_canonical;
+    }
+
+    CborValue it = *value;
+    const uint8_t *ptr = NULL;
+    size_t len = 0;
+    CHECK_CBOR_ERR(_cbor_value_begin_string_iteration(&it))
+    CHECK_CBOR_ERR(_cbor_value_get_string_chunk(&it, (const void **)&ptr, &len, NULL))
+    if (len > BYTES_VIEW_MAX_LEN) {
+        return parser_cbor_unexpected;
+    }
+
+    out->buffer = ptr;
+    out->len = (uint16_t)len;
     return parser_ok;
 }
 
+__Z_INLINE parser_error_t _readQuantity(CborValue *value, quantity_t *out) { return _readBytesView(value, out); }
+
 __Z_INLINE parser_error_t _readUint64(CborValue *value, uint64_t *out) {
     CHECK_CBOR_TYPE(cbor_value_get_type(value), CborIntegerType)
     CHECK_CBOR_ERR(cbor_value_get_uint64(value, out))
@@ -278,15 +373,22 @@ __Z_INLINE parser_error_t _readOrigTo(CborValue *value, uint8_t *out) {
     return parser_ok;
 }
 
-__Z_INLINE parser_error_t _readRuntimeString(CborValue *value, string_t *out) {
-    CHECK_CBOR_TYPE(cbor_value_get_type(value), CborByteStringType)
-    CborValue dummy;
-    MEMZERO(out, sizeof(string_t));
-    out->len = sizeof_field(string_t, buffer);
-    CHECK_CBOR_ERR(cbor_value_copy_byte_string(value, (uint8_t *)out->buffer, &out->len, &dummy))
-    return parser_ok;
+static const char addressV0_Secp256k1_ethContext[40] = "oasis-runtime-sdk/address: secp256k1eth";
+
+void _mapEthToNative(const uint8_t ethAddr[ETH_ADDR_LEN], uint8_t native[ADDR_RAW]) {
+    // The context is followed by its zero termination, which doubles as the version byte
+    uint8_t total[ETH_MAP_BUFFER] = {0};
+    uint8_t messageDigest[SHA512_DIGEST_LENGTH] = {0};
+    MEMCPY(total, addressV0_Secp256k1_ethContext, sizeof(addressV0_Secp256k1_ethContext));
+    MEMCPY(total + sizeof(addressV0_Secp256k1_ethContext), ethAddr, ETH_ADDR_LEN);
+    SHA512_256(total, sizeof(total), messageDigest);
+
+    native[0] = 0;
+    MEMCPY(native + 1, messageDigest, ADDR_RAW - 1);
 }
 
+__Z_INLINE parser_error_t _readRuntimeString(CborValue *value, string_t *out) { return _readBytesView(value, out); }
+
 __Z_INLINE parser_error_t _readVersion(CborValue *target, version_t *out) {
     CborValue versions;
     size_t numItems = 0;
@@ -815,8 +917,8 @@ __Z_INLINE parser_error_t _readMethod(parser_tx_t *v, CborValue *rootItem) {
     if (!cbor_value_is_valid(rootItem)) {
         return parser_required_method;
     }
-    // Verify it is well formed (no missing bytes...)
-    CHECK_CBOR_ERR(cbor_value_validate_basic(rootItem))
+    // Verify it is well formed (no missing bytes...), already done if the root was validated
+    CHECK_PARSER_ERR(_validateOnce(&v->validated, rootItem))
 
     CborValue tmp;
     CHECK_CBOR_ERR(cbor_value_map_find_value(rootItem, "method", &tmp))
@@ -934,9 +1036,19 @@ __Z_INLINE parser_error_t _readRuntimeMeta(parser_tx_t *v, CborValue *rootItem)
     if (cbor_value_is_valid(&dataField)) {
         v->oasis.runtime.meta.has_orig_to = true;
         CHECK_PARSER_ERR(_readOrigTo(&dataField, (uint8_t *)&v->oasis.runtime.meta.orig_to))
+
+        // Mapped once here instead of on every page showing it, the destination is compared on display
+        uint8_t ethAddr[ETH_ADDR_LEN] = {0};
+        if (hexstr_to_array(ethAddr, sizeof(ethAddr), (const char *)v->oasis.runtime.meta.orig_to + 2,
+                            sizeof(v->oasis.runtime.meta.orig_to) - 2) != ETH_ADDR_LEN) {
+            MEMZERO(v->oasis.runtime.meta.orig_to_native, sizeof(v->oasis.runtime.meta.orig_to_native));
+            return parser_invalid_eth_mapping;
+        }
+        _mapEthToNative(ethAddr, v->oasis.runtime.meta.orig_to_native);
     } else {
         v->oasis.runtime.meta.has_orig_to = false;
         MEMZERO((void *)&v->oasis.runtime.meta.orig_to, sizeof(v->oasis.runtime.meta.orig_to));
+        MEMZERO(v->oasis.runtime.meta.orig_to_native, sizeof(v->oasis.runtime.meta.orig_to_native));
     }
     return parser_ok;
 }
@@ -985,32 +1097,10 @@ __Z_INLINE parser_error_t _readName(parser_tx_t *v, CborValue *rootItem) {
 }
 
 parser_error_t _isValidUrl(url_t *url) {
-    // Verify they are all printable char
-    for (uint8_t i = 0; i < (uint8_t)url->len; i++) {
-        uint8_t c = *(url->buffer + i);
-        // 33  because no space in url
-        if (c < 33 || c > 127) {
-            return parser_invalid_url_format;
-        }
-    }
-
-    const char https_prefix[] = "https://";
-    if (strncmp(https_prefix, (const char *)url->buffer, strlen(https_prefix)) != 0) {
-        return parser_invalid_url_format;
-    }
-
-    // Dectect query by lookin for the `?` separator
-    char query_separator = '?';
-    if (strchr((const char *)url->buffer, query_separator) != NULL) {
-        return parser_invalid_url_format;
-    }
-
-    // Dectect fragment by looking for the `#` the fragment identifier
-    char fragment_identifier = '#';
-    if (strchr((const char *)url->buffer, fragment_identifier) != NULL) {
+    // https scheme, printable characters without spaces, no query or fragment
+    if (!metadata_is_valid(metadata_field_url, url->buffer, url->len)) {
         return parser_invalid_url_format;
     }
-
     return parser_ok;
 }
 
@@ -1044,38 +1134,10 @@ __Z_INLINE parser_error_t _readUrl(parser_tx_t *v, CborValue *rootItem) {
 }
 
 parser_error_t _isValidEmail(email_t *email) {
-    uint8_t arobase_count = 0;
-    uint8_t punct_count = 0;
-
-    for (uint8_t i = 0; i < (uint8_t)email->len; i++) {
-        uint8_t c = *(email->buffer + i);
-        // Verify they are all printable char
-        if (c < 33 || c > 127) {
-            return parser_invalid_email_format;
-        }
-
-        // Should have exactly one @
-        if (c == '@') {
-            arobase_count++;
-            continue;
-        }
-
-        // We are in the second part of the email
-        if (arobase_count == 1) {
-            if (c == '.') {
-                punct_count++;
-                continue;
-            }
-            if ((c < 48 || c > 57) && (c < 65 || c > 90) && (c < 97 || c > 122) && c != '-') {
-                return parser_invalid_email_format;
-            }
-        }
-    }
-
-    if (arobase_count > 1 || punct_count < 1) {
+    // printable characters, exactly one @ and a domain name with at least one '.'
+    if (!metadata_is_valid(metadata_field_email, email->buffer, email->len)) {
         return parser_invalid_email_format;
     }
-
     return parser_ok;
 }
 
@@ -1109,14 +1171,10 @@ __Z_INLINE parser_error_t _readEmail(parser_tx_t *v, CborValue *rootItem) {
 }
 
 parser_error_t _isValidHandle(handle_t *handle) {
-    // Verify they are all printable char
-    for (uint8_t i = 0; i < (uint8_t)handle->len; i++) {
-        uint8_t c = *(handle->buffer + i);
-        if ((c < 48 || c > 57) && (c < 65 || c > 90) && (c < 97 || c > 122) && c != '-' && c != '_') {
-            return parser_invalid_handle_format;
-        }
+    // [A-Za-z0-9_-]
+    if (!metadata_is_valid(metadata_field_handle, handle->buffer, handle->len)) {
+        return parser_invalid_handle_format;
     }
-
     return parser_ok;
 }
 
@@ -1181,8 +1239,8 @@ __Z_INLINE parser_error_t _readRuntimeMethod(parser_tx_t *v, CborValue *rootItem
     if (!cbor_value_is_valid(rootItem)) {
         return parser_required_method;
     }
-    // Verify it is well formed (no missing bytes...)
-    CHECK_CBOR_ERR(cbor_value_validate_basic(rootItem))
+    // Verify it is well formed (no missing bytes...), already done if the root was validated
+    CHECK_PARSER_ERR(_validateOnce(&v->validated, rootItem))
 
     CborValue tmp;
     CHECK_CBOR_ERR(cbor_value_map_find_value(rootItem, "method", &tmp))
@@ -1237,8 +1295,8 @@ __Z_INLINE parser_error_t _readRuntimeContractsBody(parser_tx_t *v, CborValue *r
     if (!cbor_value_is_valid(rootItem)) {
         return parser_required_method;
     }
-    // Verify it is well formed (no missing bytes...)
-    CHECK_CBOR_ERR(cbor_value_validate_basic(rootItem))
+    // Verify it is well formed (no missing bytes...), already done if the root was validated
+    CHECK_PARSER_ERR(_validateOnce(&v->validated, rootItem))
 
     CborValue bodyField;
     size_t numItems = 0;
@@ -1310,8 +1368,8 @@ __Z_INLINE parser_error_t _readRuntimeConsensusBody(parser_tx_t *v, CborValue *r
     if (!cbor_value_is_valid(rootItem)) {
         return parser_required_method;
     }
-    // Verify it is well formed (no missing bytes...)
-    CHECK_CBOR_ERR(cbor_value_validate_basic(rootItem))
+    // Verify it is well formed (no missing bytes...), already done if the root was validated
+    CHECK_PARSER_ERR(_validateOnce(&v->validated, rootItem))
 
     CborValue bodyField;
     size_t numItems = 0;
@@ -1364,8 +1422,8 @@ __Z_INLINE parser_error_t _readRuntimeEncrypted(parser_tx_t *v, CborValue *rootI
     if (!cbor_value_is_valid(rootItem)) {
         return parser_required_method;
     }
-    // Verify it is well formed (no missing bytes...)
-    CHECK_CBOR_ERR(cbor_value_validate_basic(rootItem))
+    // Verify it is well formed (no missing bytes...), already done if the root was validated
+    CHECK_PARSER_ERR(_validateOnce(&v->validated, rootItem))
     CborValue bodyField;
     size_t numItems = 0;
     CHECK_CBOR_ERR(cbor_value_map_find_value(rootItem, "body", &bodyField))
@@ -1397,25 +1455,7 @@ __Z_INLINE parser_error_t _readRuntimeEncrypted(parser_tx_t *v, CborValue *rootI
     if (!cbor_value_is_valid(&dataField)) {
         return parser_required_nonce;
     }
-    const uint8_t *buffer = NULL;
-    size_t buffer_size = 0;
-    CHECK_CBOR_ERR(_cbor_value_begin_string_iteration(&dataField))
-    CHECK_CBOR_ERR(_cbor_value_get_string_chunk(&dataField, (const void **)&buffer, &buffer_size, NULL))
-
-    MEMZERO(&v->oasis.runtime.call.body.encrypted.data_hash, sizeof(v->oasis.runtime.call.body.encrypted.data_hash));
-#if defined(LEDGER_SPECIFIC)
-    cx_sha256_t ctx;
-    memset(&ctx, 0, sizeof(ctx));
-    cx_sha256_init_no_throw(&ctx);
-    CHECK_CX_PARSER_OK(cx_hash_no_throw(&ctx.header, CX_LAST, buffer, buffer_size,
-                                        (unsigned char *)&v->oasis.runtime.call.body.encrypted.data_hash,
-                                        sizeof(v->oasis.runtime.call.body.encrypted.data_hash)));
-#else
-    picohash_ctx_t ctx;
-    picohash_init_sha256(&ctx);
-    picohash_update(&ctx, buffer, buffer_size);
-    picohash_final(&ctx, &v->oasis.runtime.call.body.encrypted.data_hash);
-#endif
+    CHECK_PARSER_ERR(_readDataHash(&dataField, &v->oasis.runtime.call.body.encrypted.data))
 
     return parser_ok;
 }
@@ -1424,8 +1464,8 @@ __Z_INLINE parser_error_t _readRuntimeEvmBody(parser_tx_t *v, CborValue *rootIte
     if (!cbor_value_is_valid(rootItem)) {
         return parser_required_method;
     }
-    // Verify it is well formed (no missing bytes...)
-    CHECK_CBOR_ERR(cbor_value_validate_basic(rootItem))
+    // Verify it is well formed (no missing bytes...), already done if the root was validated
+    CHECK_PARSER_ERR(_validateOnce(&v->validated, rootItem))
     CborValue bodyField;
     size_t numItems = 0;
     CHECK_CBOR_ERR(cbor_value_map_find_value(rootItem, "body", &bodyField))
@@ -1450,25 +1490,7 @@ __Z_INLINE parser_error_t _readRuntimeEvmBody(parser_tx_t *v, CborValue *rootIte
     if (!cbor_value_is_valid(&dataField)) {
         return parser_required_nonce;
     }
-    const uint8_t *buffer = NULL;
-    size_t buffer_size = 0;
-    CHECK_CBOR_ERR(_cbor_value_begin_string_iteration(&dataField))
-    CHECK_CBOR_ERR(_cbor_value_get_string_chunk(&dataField, (const void **)&buffer, &buffer_size, NULL))
-
-    MEMZERO(&v->oasis.runtime.call.body.evm.data_hash, sizeof(v->oasis.runtime.call.body.evm.data_hash));
-#if defined(LEDGER_SPECIFIC)
-    cx_sha256_t ctx;
-    memset(&ctx, 0, sizeof(ctx));
-    cx_sha256_init_no_throw(&ctx);
-    CHECK_CX_PARSER_OK(cx_hash_no_throw(&ctx.header, CX_LAST, buffer, buffer_size,
-                                        (unsigned char *)&v->oasis.runtime.call.body.encrypted.data_hash,
-                                        sizeof(v->oasis.runtime.call.body.encrypted.data_hash)));
-#else
-    picohash_ctx_t ctx;
-    picohash_init_sha256(&ctx);
-    picohash_update(&ctx, buffer, buffer_size);
-    picohash_final(&ctx, &v->oasis.runtime.call.body.evm.data_hash);
-#endif
+    CHECK_PARSER_ERR(_readDataHash(&dataField, &v->oasis.runtime.call.body.evm.data))
 
     return parser_ok;
 }
@@ -1535,8 +1557,8 @@ __Z_INLINE parser_error_t _readRuntimeFee(parser_tx_t *v, CborValue *rootItem) {
     if (!cbor_value_is_valid(rootItem)) {
         return parser_required_method;
     }
-    // Verify it is well formed (no missing bytes...)
-    CHECK_CBOR_ERR(cbor_value_validate_basic(rootItem))
+    // Verify it is well formed (no missing bytes...), already done if the root was validated
+    CHECK_PARSER_ERR(_validateOnce(&v->validated, rootItem))
 
     CborValue feeField;
     size_t numItems = 0;
@@ -1646,6 +1668,18 @@ __Z_INLINE parser_error_t _evaluateCborInit(parser_context_t *c, CborValue *it)
     return parser_ok;
 }
 
+__Z_INLINE parser_error_t _checkContextChars(const parser_tx_t *v) {
+    // Check all bytes in context as ASCII within 32..127
+    for (uint16_t i = 0; i < v->context.len; i++) {
+        const uint8_t tmp = v->context.ptr[i];
+        if (!IS_PRINTABLE(tmp)) {
+            return parser_context_invalid_chars;
+        }
+    }
+
+    return parser_ok;
+}
+
 parser_error_t _readContext(parser_context_t *c, parser_tx_t *v) {
     v->context.suffixPtr = NULL;
     v->context.suffixLen = 0;
@@ -1693,12 +1727,70 @@ parser_error_t _readContext(parser_context_t *c, parser_tx_t *v) {
         return parser_cbor_unexpected;
     }
 
-    // Check all bytes in context as ASCII within 32..127
-    for (uint16_t i = 0; i < v->context.len; i++) {
-        const uint8_t tmp = v->context.ptr[i];
-        if (!IS_PRINTABLE(tmp)) {
-            return parser_context_invalid_chars;
+    return _checkContextChars(v);
+}
+
+parser_error_t _readHeader(parser_context_t *c, parser_tx_t *v) {
+    v->context.suffixPtr = NULL;
+    v->context.suffixLen = 0;
+
+    if (c->bufferLen <= c->offset) {
+        return parser_no_data;
+    }
+
+    CborValue it;
+    CborParser parser;
+    CborError err = cbor_parser_init(c->buffer + c->offset, c->bufferLen - c->offset, 0, &parser, &it);
+    if (err == CborErrorUnexpectedEOF) {
+        return parser_no_data;
+    }
+
+    if (cbor_value_is_map(&it) && err == CborNoError) {
+        // The metadata map can only be read once it is complete, it is then read exactly as _readContext would
+        CborValue metaEnd = it;
+        err = cbor_value_advance(&metaEnd);
+        if (err == CborErrorUnexpectedEOF) {
+            return parser_no_data;
         }
+        if (err != CborNoError) {
+            // Malformed metadata is reported by the full parse
+            return parser_ok;
+        }
+
+        CHECK_PARSER_ERR(_readRuntimeMeta(v, &it))
+        CHECK_PARSER_ERR(_computeRuntimeSigContext(v))
+        v->context.ptr = (uint8_t *)v->oasis.runtime.sigcxt;
+        v->context.len = strlen(v->oasis.runtime.sigcxt);
+        CHECK_PARSER_ERR(_checkContextChars(v))
+
+        // Where the body starts is left to the full parse, it searches for it
+        return _extractContextSuffix(v);
+    }
+
+    if (err != CborNoError && err != CborErrorIllegalNumber) {
+        return parser_cbor_unexpected;
+    }
+
+    const uint8_t contextLen = *(c->buffer + c->offset);
+    if (contextLen >= 2 && c->offset + 1 + contextLen > c->bufferLen) {
+        return parser_no_data;
+    }
+    CHECK_PARSER_ERR(_readContext(c, v))
+    CHECK_PARSER_ERR(_extractContextSuffix(v))
+
+    // Root item header, the same checks _read does before walking the tree
+    if (c->bufferLen <= c->offset) {
+        return parser_no_data;
+    }
+    err = cbor_parser_init(c->buffer + c->offset, c->bufferLen - c->offset, 0, &parser, &it);
+    if (err == CborErrorUnexpectedEOF) {
+        return parser_no_data;
+    }
+    if (err != CborNoError) {
+        return parser_mapCborError(err);
+    }
+    if (!cbor_value_is_map(&it)) {
+        return parser_root_item_should_be_a_map;
     }
 
     return parser_ok;
@@ -1809,7 +1901,9 @@ parser_error_t _read(const parser_context_t *c, parser_tx_t *v) {
     CborValue rootItem = {0};
     INIT_CBOR_PARSER(c, rootItem)
 
-    CHECK_CBOR_ERR(cbor_value_validate_basic(&rootItem))
+    // Validate the whole tree once, readers below skip the subtrees inside it
+    MEMZERO(&v->validated, sizeof(cbor_validated_range_t));
+    CHECK_PARSER_ERR(_validateOnce(&v->validated, &rootItem))
 
     if (cbor_value_at_end(&rootItem)) {
         return parser_unexpected_buffer_end;
@@ -1853,6 +1947,147 @@ parser_error_t _validateTx(const parser_context_t *c, __Z_UNUSED const parser_tx
     return parser_ok;
 }
 
+#if defined(APP_BATCH_SIGNING)
+parser_error_t _readBatchHeader(parser_context_t *c, parser_tx_t *v, batch_summary_t *b) {
+    MEMZERO(b, sizeof(batch_summary_t));
+
+    CHECK_PARSER_ERR(_readContext(c, v))
+    CHECK_PARSER_ERR(_extractContextSuffix(v))
+
+    // Only consensus transactions are signed as (context || cbor), which is what lets them share a context
+    if (v->type != txType) {
+        return parser_unsupported_tx;
+    }
+
+    if (c->offset >= c->bufferLen) {
+        return parser_unexpected_buffer_end;
+    }
+    b->count = *(c->buffer + c->offset);
+    c->offset++;
+
+    if (b->count == 0 || b->count > BATCH_MAX_TXS) {
+        return parser_unexpected_number_items;
+    }
+
+    // Every transaction is framed as [length (2 bytes, big endian)][cbor]
+    for (uint8_t i = 0; i < b->count; i++) {
+        if (c->bufferLen - c->offset < 2) {
+            return parser_unexpected_buffer_end;
+        }
+        const uint16_t txLen = (uint16_t)(*(c->buffer + c->offset) << 8u) | *(c->buffer + c->offset + 1);
+        c->offset += 2;
+
+        if (txLen == 0 || txLen > c->bufferLen - c->offset) {
+            return parser_unexpected_buffer_end;
+        }
+        b->txOffset[i] = c->offset;
+        b->txLen[i] = txLen;
+        c->offset += txLen;
+    }
+
+    // Trailing bytes would be part of no signature, reject them
+    if (c->offset != c->bufferLen) {
+        return parser_unexpected_characters;
+    }
+
+    return parser_ok;
+}
+
+// Adds a big endian quantity into a BATCH_AMOUNT_LEN bytes big endian total
+__Z_INLINE parser_error_t _addQuantity(uint8_t *total, const quantity_t *q) {
+    if (q->len > BATCH_AMOUNT_LEN) {
+        return parser_value_out_of_range;
+    }
+
+    uint16_t carry = 0;
+    for (uint8_t i = 0; i < BATCH_AMOUNT_LEN; i++) {
+        uint16_t sum = total[BATCH_AMOUNT_LEN - 1 - i] + carry;
+        if (i < q->len) {
+            sum += q->buffer[q->len - 1 - i];
+        }
+        total[BATCH_AMOUNT_LEN - 1 - i] = (uint8_t)sum;
+        carry = sum >> 8u;
+    }
+
+    return carry == 0 ? parser_ok : parser_value_out_of_range;
+}
+
+parser_error_t _addToBatch(batch_summary_t *b, const parser_tx_t *v) {
+    if (v->type != txType) {
+        return parser_unexpected_type;
+    }
+
+    const address_raw_t *address = NULL;
+    const quantity_t *amount = NULL;
+    switch (v->oasis.tx.method) {
+        case stakingTransfer:
+            address = &v->oasis.tx.body.stakingTransfer.to;
+            amount = &v->oasis.tx.body.stakingTransfer.amount;
+            break;
+        case stakingEscrow:
+            address = &v->oasis.tx.body.stakingEscrow.account;
+            amount = &v->oasis.tx.body.stakingEscrow.amount;
+            break;
+        case stakingReclaimEscrow:
+            address = &v->oasis.tx.body.stakingReclaimEscrow.account;
+            amount = &v->oasis.tx.body.stakingReclaimEscrow.shares;
+            break;
+        default:
+            return parser_unexpected_method;
+    }
+
+    batch_method_t *method = NULL;
+    for (uint8_t i = 0; i < b->methodsLen; i++) {
+        if (b->methods[i].method == v->oasis.tx.method) {
+            method = &b->methods[i];
+            break;
+        }
+    }
+    if (method == NULL) {
+        if (b->methodsLen >= BATCH_MAX_METHODS) {
+            return parser_unexpected_number_items;
+        }
+        method = &b->methods[b->methodsLen++];
+        method->method = v->oasis.tx.method;
+    }
+    method->count++;
+    CHECK_PARSER_ERR(_addQuantity(method->total, amount))
+
+    batch_destination_t *destination = NULL;
+    for (uint8_t i = 0; i < b->destinationsLen; i++) {
+        if (b->destinations[i].method == v->oasis.tx.method &&
+            MEMCMP(b->destinations[i].address, *address, sizeof(address_raw_t)) == 0) {
+            destination = &b->destinations[i];
+            break;
+        }
+    }
+    if (destination == NULL) {
+        if (b->destinationsLen >= BATCH_MAX_DESTINATIONS) {
+            return parser_unexpected_number_items;
+        }
+        destination = &b->destinations[b->destinationsLen++];
+        destination->method = v->oasis.tx.method;
+        MEMCPY(destination->address, *address, sizeof(address_raw_t));
+    }
+    CHECK_PARSER_ERR(_addQuantity(destination->amount, amount))
+
+    if (v->oasis.tx.has_fee) {
+        CHECK_PARSER_ERR(_addQuantity(b->fee, &v->oasis.tx.fee_amount))
+        if (v->oasis.tx.fee_gas > UINT64_MAX - b->gas) {
+            return parser_value_out_of_range;
+        }
+        b->gas += v->oasis.tx.fee_gas;
+    }
+
+    return parser_ok;
+}
+
+uint8_t _getNumItemsBatch(const batch_summary_t *b) {
+    // Type, then method and total per method, then address and amount per destination, then fee and gas
+    return 1 + 2 * b->methodsLen + 2 * b->destinationsLen + 2;
+}
+#endif
+
 uint8_t _getNumItems(__Z_UNUSED const parser_context_t *c, const parser_tx_t *v) {
     // typical tx: Type, Fee, Gas (exclude Genesis hash)
     const uint8_t commonElements = 3;
@@ -2117,7 +2352,8 @@ parser_error_t _getTokenAtIndex(const parser_context_t *c, token_t *token, uint8
     CborValue it;
     INIT_CBOR_PARSER(c, it)
 
-    CHECK_CBOR_ERR(cbor_value_validate_basic(&it))
+    // The buffer was validated when it was parsed
+    CHECK_PARSER_ERR(_validateOnce(&parser_tx_obj.validated, &it))
 
     if (cbor_value_at_end(&it)) {
         return parser_unexpected_buffer_end;
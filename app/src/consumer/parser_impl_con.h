@@ -36,6 +36,9 @@ extern const char context_prefix_entity[];
 extern const char context_prefix_entity_metadata[];
 
 extern parser_tx_t parser_tx_obj;
+#if defined(APP_BATCH_SIGNING)
+extern batch_summary_t parser_batch_obj;
+#endif
 
 parser_error_t parser_init(parser_context_t *ctx, const uint8_t *buffer, uint16_t bufferSize);
 
@@ -43,8 +46,24 @@ parser_error_t _read(const parser_context_t *c, parser_tx_t *v);
 
 parser_error_t _readContext(parser_context_t *c, parser_tx_t *v);
 
+/// Checks the context and the root item header on the first bytes of a transaction
+/// \return parser_no_data while more bytes are needed to tell, parser_ok once the header is fine
+parser_error_t _readHeader(parser_context_t *c, parser_tx_t *v);
+
 parser_error_t _validateTx(const parser_context_t *c, const parser_tx_t *v);
 
+#if defined(APP_BATCH_SIGNING)
+/// Reads the shared context and the framing of a batch: [ctxLen][ctx][count]([txLen (2 bytes, BE)][cbor])*count
+/// Transactions are not parsed, only located, and the framing has to cover the whole buffer
+parser_error_t _readBatchHeader(parser_context_t *c, parser_tx_t *v, batch_summary_t *b);
+
+/// Adds the transaction that was just read to the batch totals
+/// Only staking transfers, escrows and reclaims can be batched
+parser_error_t _addToBatch(batch_summary_t *b, const parser_tx_t *v);
+
+uint8_t _getNumItemsBatch(const batch_summary_t *b);
+#endif
+
 uint8_t _getNumItems(const parser_context_t *c, const parser_tx_t *v);
 
 parser_error_t _getCommissionRateStepAtIndex(const parser_context_t *c, commissionRateStep_t *rate, uint8_t index);
@@ -57,12 +76,19 @@ parser_error_t _getEntityNodesIdAtIndex(const oasis_entity_t *entity, publickey_
 
 parser_error_t _extractContextSuffix(parser_tx_t *v);
 
+/// Native address of an Ethereum address: version 0 and the first 20 bytes of
+/// SHA512-256("oasis-runtime-sdk/address: secp256k1eth" || version || ethAddr)
+void _mapEthToNative(const uint8_t ethAddr[ETH_ADDR_LEN], uint8_t native[ADDR_RAW]);
+
 parser_error_t _isValidUrl(url_t *url);
 
 parser_error_t _isValidEmail(email_t *email);
 
 parser_error_t _isValidHandle(handle_t *handle);
 
+/// Returns (computing it on first use) the SHA-256 of a data byte string read by the parser
+parser_error_t _getDataHash(data_hash_t *data);
+
 parser_error_t parser_picoHash(uint8_t *src, size_t srcLen, uint8_t *dest, size_t destLen);
 
 #ifdef __cplusplus
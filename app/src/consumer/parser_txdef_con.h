@@ -82,17 +82,20 @@ typedef struct {
 
 typedef uint8_t publickey_t[32];
 
+// Byte string inside the transaction buffer. Only valid while the buffer is, decoded when displayed
 typedef struct {
-    uint8_t buffer[64];
-    size_t len;
-} quantity_t;
+    const uint8_t *buffer;
+    uint16_t len;
+} bytes_view_t;
+
+// Byte strings longer than this are rejected
+#define BYTES_VIEW_MAX_LEN 64
+
+typedef bytes_view_t quantity_t;
 
 typedef uint8_t address_raw_t[21];
 
-typedef struct {
-    uint8_t buffer[64];
-    size_t len;
-} string_t;
+typedef bytes_view_t string_t;
 
 typedef struct {
     // one more for the zero termination
@@ -148,6 +151,13 @@ typedef struct {
     CborValue startValue;
 } cbor_parser_state_t;
 
+// Byte range of the CBOR item that was last structurally validated in this parse
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *end;
+    const uint8_t *bufferEnd;
+} cbor_validated_range_t;
+
 typedef struct {
     uint64_t descriptor_version;
     publickey_t id;
@@ -273,15 +283,22 @@ typedef struct {
     quantity_t shares;
 } body_consensus_t;
 
+// Byte string that is displayed as its SHA-256, hashed the first time it is shown
+typedef struct {
+    cbor_parser_state_t cborState;
+    bool hashed;
+    uint8_t hash[32];
+} data_hash_t;
+
 typedef struct {
     string_t address;
-    char data_hash[32];
+    data_hash_t data;
 } body_evm_t;
 
 typedef struct {
     publickey_t pk;
     string_t nonce;
-    char data_hash[32];
+    data_hash_t data;
 } body_encrypted_t;
 
 typedef struct {
@@ -325,10 +342,15 @@ typedef struct {
     const uint8_t runtime_id[RUNTIME_ID_BYTE_LEN * 2];
     const uint8_t orig_to[ORIG_TO_SIZE];
     bool has_orig_to;
+    // orig_to mapped to its native address once while parsing, a malformed orig_to fails the parse
+    uint8_t orig_to_native[ADDR_RAW];
 } meta_t;
 
+// context prefix, hex encoded 32 byte hash and zero termination
+#define RUNTIME_SIGCXT_SIZE (sizeof("oasis-runtime-sdk/tx: v0 for chain ") - 1 + 64 + 1)
+
 typedef struct {
-    char sigcxt[200];
+    char sigcxt[RUNTIME_SIGCXT_SIZE];
     size_t metaLen;
     uint16_t v;
     runtime_call_t call;
@@ -341,6 +363,7 @@ typedef enum { unknownType, txType, entityType, nodeType, consensusType, entityM
 typedef struct {
     context_t context;
     oasis_blob_type_e type;
+    cbor_validated_range_t validated;
 
     union {
         oasis_tx_t tx;
@@ -350,6 +373,42 @@ typedef struct {
     } oasis;
 } parser_tx_t;
 
+// Batch of consensus transactions sharing one context, reviewed once and signed one by one
+#define BATCH_MAX_TXS 32
+// Every destination is shown, so the screen count bounds how many distinct ones a batch can have
+#define BATCH_MAX_DESTINATIONS 8
+// Staking transfer, add escrow and reclaim escrow
+#define BATCH_MAX_METHODS 3
+// Totals are kept as 256 bit big endian numbers
+#define BATCH_AMOUNT_LEN 32
+
+typedef struct {
+    oasis_methods_e method;
+    uint8_t count;
+    uint8_t total[BATCH_AMOUNT_LEN];
+} batch_method_t;
+
+typedef struct {
+    oasis_methods_e method;
+    address_raw_t address;
+    uint8_t amount[BATCH_AMOUNT_LEN];
+} batch_destination_t;
+
+typedef struct {
+    uint8_t count;
+    // Position of each transaction CBOR inside the buffer
+    uint16_t txOffset[BATCH_MAX_TXS];
+    uint16_t txLen[BATCH_MAX_TXS];
+
+    uint8_t methodsLen;
+    batch_method_t methods[BATCH_MAX_METHODS];
+    uint8_t destinationsLen;
+    batch_destination_t destinations[BATCH_MAX_DESTINATIONS];
+
+    uint8_t fee[BATCH_AMOUNT_LEN];
+    uint64_t gas;
+} batch_summary_t;
+
 // simple struct that holds a bigint(256)
 typedef struct {
     uint32_t offset;
@@ -20,9 +20,12 @@
 
 #include "apdu_codes.h"
 #include "coin.h"
+#include "crypto_derive.h"
+#include "key_cache.h"
 #include "ristretto.h"
 #include "rslib.h"
 #include "sha512.h"
+#include "trace.h"
 #include "tx.h"
 #include "zxformat.h"
 #include "zxmacros.h"
@@ -69,30 +72,10 @@ zxerr_t crypto_extractPublicKeySr25519(uint8_t *pubKey, uint16_t pubKeyLen) {
         return zxerr_invalid_crypto_settings;
     }
 
-    cx_ecfp_private_key_t cx_privateKey;
     uint8_t privateKeyData[SK_LEN_25519] = {0};
 
-    zxerr_t error = zxerr_unknown;
-    const int mode = (hdPathLen == HDPATH_LEN_ADR0008) ? HDW_ED25519_SLIP10 : HDW_NORMAL;
-
     // Generate keys
-    CATCH_CXERROR(
-        os_derive_bip32_with_seed_no_throw(mode, CX_CURVE_Ed25519, hdPath, hdPathLen, privateKeyData, NULL, NULL, 0));
-
-    if (mode == HDW_ED25519_SLIP10) {
-        uint8_t privateKeyData_expanded[SK_LEN_25519] = {0};
-        expanded_sr25519_sk(privateKeyData, privateKeyData_expanded);
-        MEMCPY(privateKeyData, privateKeyData_expanded, SK_LEN_25519);
-        MEMZERO(privateKeyData_expanded, sizeof(privateKeyData_expanded));
-    } else {
-        get_sr25519_sk(privateKeyData);
-    }
-
-    CATCH_CXERROR(crypto_scalarmult_ristretto255_base_sdk(pubKey, privateKeyData));
-    error = zxerr_ok;
-
-catch_cx_error:
-    MEMZERO(&cx_privateKey, sizeof(cx_privateKey));
+    const zxerr_t error = crypto_sr25519Keys(privateKeyData, pubKey);
     MEMZERO(privateKeyData, sizeof(privateKeyData));
 
     if (error != zxerr_ok) {
@@ -113,8 +96,9 @@ zxerr_t crypto_extractPublicKeyEd25519(uint8_t *pubKey, uint16_t pubKeyLen) {
     const int mode = (hdPathLen == HDPATH_LEN_ADR0008) ? HDW_ED25519_SLIP10 : HDW_NORMAL;
 
     // Generate keys
-    CATCH_CXERROR(
-        os_derive_bip32_with_seed_no_throw(mode, CX_CURVE_Ed25519, hdPath, hdPathLen, privateKeyData, NULL, NULL, 0));
+    if (crypto_deriveKey(key_cache_ed25519, mode, CX_CURVE_Ed25519, hdPathLen, privateKeyData, NULL) != zxerr_ok) {
+        goto catch_cx_error;
+    }
 
     CATCH_CXERROR(cx_ecfp_init_private_key_no_throw(CX_CURVE_Ed25519, privateKeyData, 32, &cx_privateKey));
     CATCH_CXERROR(cx_ecfp_init_public_key_no_throw(CX_CURVE_Ed25519, NULL, 0, &cx_publicKey));
@@ -150,8 +134,10 @@ zxerr_t crypto_extractPublicKeySecp256k1(uint8_t *pubKey, uint16_t pubKeyLen, ui
 
     zxerr_t error = zxerr_unknown;
     // Generate keys
-    CATCH_CXERROR(os_derive_bip32_with_seed_no_throw(HDW_NORMAL, CX_CURVE_256K1, hdPath, HDPATH_LEN_DEFAULT, privateKeyData,
-                                                     chainCode, NULL, 0));
+    if (crypto_deriveKey(key_cache_secp256k1, HDW_NORMAL, CX_CURVE_256K1, HDPATH_LEN_DEFAULT, privateKeyData,
+                         chainCode) != zxerr_ok) {
+        goto catch_cx_error;
+    }
 
     CATCH_CXERROR(cx_ecfp_init_private_key_no_throw(CX_CURVE_256K1, privateKeyData, SK_SECP256K1_SIZE, &cx_privateKey));
     CATCH_CXERROR(cx_ecfp_init_public_key_no_throw(CX_CURVE_256K1, NULL, 0, &cx_publicKey));
@@ -197,12 +183,18 @@ zxerr_t crypto_signSecp256k1(uint8_t *output, uint16_t outputLen, const uint8_t
     signature_t *const signature_object = (signature_t *)output;
     zxerr_t error = zxerr_unknown;
 
-    CATCH_CXERROR(os_derive_bip32_with_seed_no_throw(HDW_NORMAL, CX_CURVE_256K1, hdPath, HDPATH_LEN_DEFAULT, privateKeyData,
-                                                     NULL, NULL, 0));
+    TRACE_START(trace_derive)
+    if (crypto_deriveKey(key_cache_secp256k1, HDW_NORMAL, CX_CURVE_256K1, HDPATH_LEN_DEFAULT, privateKeyData, NULL) !=
+        zxerr_ok) {
+        goto catch_cx_error;
+    }
+    TRACE_STOP(trace_derive)
 
+    TRACE_START(trace_sign)
     CATCH_CXERROR(cx_ecfp_init_private_key_no_throw(CX_CURVE_256K1, privateKeyData, SK_SECP256K1_SIZE, &cx_privateKey));
     CATCH_CXERROR(cx_ecdsa_sign_no_throw(&cx_privateKey, CX_RND_RFC6979 | CX_LAST, CX_SHA256, message, messageLen,
                                          signature_object->der_signature, &maxSignatureLen, &info));
+    TRACE_STOP(trace_sign)
 
     const err_convert_e err_c = convertDERtoRSV(signature_object->der_signature, info, signature_object->r,
                                                 signature_object->s, &signature_object->v);
@@ -236,11 +228,16 @@ zxerr_t crypto_signEd25519(uint8_t *output, uint16_t outputLen, const uint8_t *m
     zxerr_t error = zxerr_unknown;
     const int mode = (hdPathLen == HDPATH_LEN_ADR0008) ? HDW_ED25519_SLIP10 : HDW_NORMAL;
 
-    CATCH_CXERROR(
-        os_derive_bip32_with_seed_no_throw(mode, CX_CURVE_Ed25519, hdPath, hdPathLen, privateKeyData, NULL, NULL, 0));
+    TRACE_START(trace_derive)
+    if (crypto_deriveKey(key_cache_ed25519, mode, CX_CURVE_Ed25519, hdPathLen, privateKeyData, NULL) != zxerr_ok) {
+        goto catch_cx_error;
+    }
+    TRACE_STOP(trace_derive)
 
+    TRACE_START(trace_sign)
     CATCH_CXERROR(cx_ecfp_init_private_key_no_throw(CX_CURVE_Ed25519, privateKeyData, 32, &cx_privateKey));
     CATCH_CXERROR(cx_eddsa_sign_no_throw(&cx_privateKey, CX_SHA512, message, messageLen, output, outputLen));
+    TRACE_STOP(trace_sign)
 
     *sigSize = ED25519_SIGNATURE_SIZE;
     error = zxerr_ok;
@@ -266,19 +263,13 @@ zxerr_t crypto_sign_sr25519(uint8_t *output, uint16_t outputLen, const uint8_t *
     *sigSize = 0;
 
     zxerr_t error = zxerr_unknown;
-    const int mode = (hdPathLen == HDPATH_LEN_ADR0008) ? HDW_ED25519_SLIP10 : HDW_NORMAL;
-    CATCH_CXERROR(os_derive_bip32_with_seed_no_throw(mode, CX_CURVE_Ed25519, hdPath, hdPathLen, sk, NULL, NULL, 0));
-
-    if (mode == HDW_ED25519_SLIP10) {
-        uint8_t privateKeyData_expanded[SK_LEN_25519] = {0};
-        expanded_sr25519_sk(sk, privateKeyData_expanded);
-        MEMCPY(sk, privateKeyData_expanded, SK_LEN_25519);
-        MEMZERO(privateKeyData_expanded, sizeof(privateKeyData_expanded));
-    } else {
-        get_sr25519_sk(sk);
+    TRACE_START(trace_derive)
+    if (crypto_sr25519Keys(sk, pk) != zxerr_ok) {
+        goto catch_cx_error;
     }
+    TRACE_STOP(trace_derive)
 
-    CATCH_CXERROR(crypto_scalarmult_ristretto255_base_sdk(pk, sk));
+    TRACE_START(trace_sign)
     sign_sr25519_phase1(sk, pk, ctx, ctx_len, data, len, output);
     CATCH_CXERROR(crypto_scalarmult_ristretto255_base_sdk(output, output + PK_LEN_SR25519));
     *sigSize = SIG_LEN;
@@ -287,6 +278,7 @@ zxerr_t crypto_sign_sr25519(uint8_t *output, uint16_t outputLen, const uint8_t *
 catch_cx_error:
     if (error == zxerr_ok) {
         sign_sr25519_phase2(sk, pk, ctx, ctx_len, data, len, output);
+        TRACE_STOP(trace_sign)
     } else {
         MEMZERO(output, outputLen);
     }
@@ -311,11 +303,16 @@ zxerr_t _sign(uint8_t *output, uint16_t outputLen, const uint8_t *message, uint1
     *sigSize = 0;
 
     zxerr_t error = zxerr_unknown;
-    CATCH_CXERROR(
-        os_derive_bip32_with_seed_no_throw(HDW_NORMAL, CX_CURVE_256K1, hdPath, hdPathLen, privateKeyData, NULL, NULL, 0));
+    TRACE_START(trace_derive)
+    if (crypto_deriveKey(key_cache_secp256k1, HDW_NORMAL, CX_CURVE_256K1, hdPathLen, privateKeyData, NULL) != zxerr_ok) {
+        goto catch_cx_error;
+    }
+    TRACE_STOP(trace_derive)
+    TRACE_START(trace_sign)
     CATCH_CXERROR(cx_ecfp_init_private_key_no_throw(CX_CURVE_256K1, privateKeyData, 32, &cx_privateKey));
     CATCH_CXERROR(cx_ecdsa_sign_no_throw(&cx_privateKey, CX_RND_RFC6979 | CX_LAST, CX_SHA256, message, messageLen,
                                          signature->der_signature, &signatureLength, &tmpInfo));
+    TRACE_STOP(trace_sign)
 
     const err_convert_e err_c =
         convertDERtoRSV(signature->der_signature, tmpInfo, signature->r, signature->s, &signature->v);
@@ -347,7 +344,9 @@ zxerr_t crypto_sign_eth(uint8_t *buffer, uint16_t signatureMaxlen, const uint8_t
     }
 
     uint8_t message_digest[KECCAK256_HASH_LEN] = {0};
+    TRACE_START(trace_hash)
     keccak_digest(message, messageLen, message_digest, KECCAK256_HASH_LEN);
+    TRACE_STOP(trace_hash)
 
     unsigned int info = 0;
     zxerr_t error = _sign(buffer, signatureMaxlen, message_digest, KECCAK256_HASH_LEN, sigSize, &info);
@@ -0,0 +1,76 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "crypto_derive.h"
+
+#include "coin.h"
+#include "crypto.h"
+#include "ristretto.h"
+#include "rslib.h"
+#include "zxmacros.h"
+
+zxerr_t crypto_deriveKey(key_cache_kind_e kind, int mode, cx_curve_t curve, uint8_t pathLen, uint8_t *privateKeyData,
+                         uint8_t *chainCode) {
+    uint8_t material[KEY_CACHE_MAX_LEN] = {0};
+    zxerr_t error = zxerr_unknown;
+
+    if (!key_cache_get(kind, mode, hdPath, pathLen, material, sizeof(material))) {
+        CATCH_CXERROR(os_derive_bip32_with_seed_no_throw(mode, curve, hdPath, pathLen, material, material + 64, NULL, 0));
+        key_cache_put(kind, mode, hdPath, pathLen, material, sizeof(material));
+    }
+
+    MEMCPY(privateKeyData, material, 64);
+    if (chainCode != NULL) {
+        MEMCPY(chainCode, material + 64, 32);
+    }
+    error = zxerr_ok;
+
+catch_cx_error:
+    MEMZERO(material, sizeof(material));
+    return error;
+}
+
+zxerr_t crypto_sr25519Keys(uint8_t sk[SK_LEN_25519], uint8_t pk[PK_LEN_SR25519]) {
+    uint8_t material[KEY_CACHE_MAX_LEN] = {0};
+    uint8_t *const materialSk = material;
+    uint8_t *const materialPk = material + SK_LEN_25519;
+    zxerr_t error = zxerr_unknown;
+    const int mode = (hdPathLen == HDPATH_LEN_ADR0008) ? HDW_ED25519_SLIP10 : HDW_NORMAL;
+
+    if (!key_cache_get(key_cache_sr25519, mode, hdPath, hdPathLen, material, sizeof(material))) {
+        CATCH_CXERROR(
+            os_derive_bip32_with_seed_no_throw(mode, CX_CURVE_Ed25519, hdPath, hdPathLen, materialSk, NULL, NULL, 0));
+
+        if (mode == HDW_ED25519_SLIP10) {
+            uint8_t privateKeyData_expanded[SK_LEN_25519] = {0};
+            expanded_sr25519_sk(materialSk, privateKeyData_expanded);
+            MEMCPY(materialSk, privateKeyData_expanded, SK_LEN_25519);
+            MEMZERO(privateKeyData_expanded, sizeof(privateKeyData_expanded));
+        } else {
+            get_sr25519_sk(materialSk);
+        }
+
+        CATCH_CXERROR(crypto_scalarmult_ristretto255_base_sdk(materialPk, materialSk));
+        key_cache_put(key_cache_sr25519, mode, hdPath, hdPathLen, material, sizeof(material));
+    }
+
+    MEMCPY(sk, materialSk, SK_LEN_25519);
+    MEMCPY(pk, materialPk, PK_LEN_SR25519);
+    error = zxerr_ok;
+
+catch_cx_error:
+    MEMZERO(material, sizeof(material));
+    return error;
+}
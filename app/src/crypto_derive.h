@@ -0,0 +1,41 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "coin.h"
+#include "cx.h"
+#include "key_cache.h"
+#include "zxerror.h"
+
+/// Derives the key at hdPath, or takes it from the key cache when the last derivation was for the same account
+/// \param privateKeyData 64 bytes
+/// \param chainCode 32 bytes, may be NULL
+zxerr_t crypto_deriveKey(key_cache_kind_e kind, int mode, cx_curve_t curve, uint8_t pathLen, uint8_t *privateKeyData,
+                         uint8_t *chainCode);
+
+/// Expanded secret key and public key of the sr25519 account at hdPath
+/// Both are cached, so a hit also skips the expansion and the base point multiplication
+zxerr_t crypto_sr25519Keys(uint8_t sk[SK_LEN_25519], uint8_t pk[PK_LEN_SR25519]);
+
+#ifdef __cplusplus
+}
+#endif
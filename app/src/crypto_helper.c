@@ -21,6 +21,7 @@
 #include "crypto.h"
 #include "parser_impl.h"
 #include "sha512.h"
+#include "trace.h"
 #include "tx.h"
 
 zxerr_t crypto_getBytesToSign(uint8_t *out_hash, size_t out_hash_len) {
@@ -31,6 +32,7 @@ zxerr_t crypto_getBytesToSign(uint8_t *out_hash, size_t out_hash_len) {
 
     uint8_t *message = tx_get_buffer() + CRYPTO_BLOB_SKIP_BYTES;
     uint16_t messageLength = tx_get_buffer_length() - CRYPTO_BLOB_SKIP_BYTES;
+    TRACE_START(trace_hash)
     SHA512_256(message, messageLength, out_hash);
 
     if (parser_tx_obj.type == runtimeType) {
@@ -38,16 +40,56 @@ zxerr_t crypto_getBytesToSign(uint8_t *out_hash, size_t out_hash_len) {
         messageLength = tx_get_buffer_length() - parser_tx_obj.oasis.runtime.metaLen;
         SHA512_256_with_context(parser_tx_obj.context.ptr, parser_tx_obj.context.len, message, messageLength, out_hash);
     }
+    TRACE_STOP(trace_hash)
     return zxerr_ok;
 }
 
+#if defined(APP_BATCH_SIGNING)
+zxerr_t crypto_getBatchBytesToSign(uint8_t index, uint8_t *out_hash, size_t out_hash_len) {
+    if (out_hash == NULL || out_hash_len < CX_SHA512_SIZE || index >= parser_batch_obj.count) {
+        return zxerr_encoding_failed;
+    }
+    MEMZERO(out_hash, out_hash_len);
+
+    // Same message as a transaction signed alone: the shared context followed by its own cbor
+    const uint8_t *message = tx_get_buffer() + parser_batch_obj.txOffset[index];
+    TRACE_START(trace_hash)
+    SHA512_256_with_context(parser_tx_obj.context.ptr, parser_tx_obj.context.len, message, parser_batch_obj.txLen[index],
+                            out_hash);
+    TRACE_STOP(trace_hash)
+    return zxerr_ok;
+}
+#endif
+
 const uint8_t *crypto_getSr25519BytesToSign(uint8_t *msgDigest, size_t msgDigestLen, size_t *ctxLen) {
     if (msgDigest == NULL || msgDigestLen < CX_SHA512_SIZE) {
         return NULL;
     }
     uint8_t *message = tx_get_buffer() + parser_tx_obj.oasis.runtime.metaLen;
     size_t messageLen = tx_get_buffer_length() - parser_tx_obj.oasis.runtime.metaLen;
+    TRACE_START(trace_hash)
     SHA512_256(message, messageLen, msgDigest);
+    TRACE_STOP(trace_hash)
     *ctxLen = (size_t)parser_tx_obj.context.len;
     return parser_tx_obj.context.ptr;
 }
+
+#if !defined(LEDGER_SPECIFIC)
+zxerr_t crypto_getBytesToSignMany(const uint8_t *context, size_t contextLen, const uint8_t *const *messages,
+                                  const size_t *messageLens, size_t count, uint8_t *out, size_t outLen) {
+    if (context == NULL || messages == NULL || messageLens == NULL || out == NULL) {
+        return zxerr_no_data;
+    }
+    if (outLen / CX_SHA512_SIZE < count) {
+        return zxerr_buffer_too_small;
+    }
+
+    // The context is absorbed once, every message resumes from there
+    sha512_256_state_t prefix;
+    SHA512_256_init(&prefix);
+    SHA512_256_update(&prefix, context, contextLen);
+    SHA512_256_many(&prefix, messages, messageLens, count, out);
+    secure_wipe((uint8_t *)&prefix, sizeof(prefix));
+    return zxerr_ok;
+}
+#endif
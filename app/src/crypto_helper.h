@@ -19,6 +19,17 @@
 #include <stdint.h>
 
 #include "zxerror.h"
+#include "zxmacros.h"
 
 zxerr_t crypto_getBytesToSign(uint8_t *toSign, size_t toSignLen);
+#if defined(APP_BATCH_SIGNING)
+zxerr_t crypto_getBatchBytesToSign(uint8_t index, uint8_t *toSign, size_t toSignLen);
+#endif
 const uint8_t *crypto_getSr25519BytesToSign(uint8_t *msgDigest, size_t msgDigestLen, uint32_t *ctxLen);
+
+#if !defined(LEDGER_SPECIFIC)
+/// Host only: what crypto_getBytesToSign yields for count messages signed under one context, the consensus
+/// context of a transaction or the signature context of a runtime one. Digests are CX_SHA512_SIZE bytes apart
+zxerr_t crypto_getBytesToSignMany(const uint8_t *context, size_t contextLen, const uint8_t *const *messages,
+                                  const size_t *messageLens, size_t count, uint8_t *out, size_t outLen);
+#endif
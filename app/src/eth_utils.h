@@ -37,6 +37,9 @@ uint64_t saturating_add(uint64_t a, uint64_t b);
 // Add two numbers returning UINT32_MAX if overflows
 uint32_t saturating_add_u32(uint32_t a, uint32_t b);
 
+// Transaction type byte, list marker and up to 8 length bytes
+#define RLP_TX_HEADER_MAX_LEN 10
+
 /// Returns the number of bytes read and the number of bytes to read
 // Gets the number of bytes read and the number of bytes to read
 //
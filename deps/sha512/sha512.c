@@ -67,11 +67,7 @@ void secure_wipe(uint8_t *v, uint32_t n) {
 /*
  * SHA-512 context structure
  */
-typedef struct {
-    uint64_t total[2];         /*!< number of bytes processed  */
-    uint64_t state[8];         /*!< intermediate digest state  */
-    unsigned char buffer[128]; /*!< data block being processed */
-} mbedtls_sha512_context;
+typedef sha512_256_state_t mbedtls_sha512_context;
 
 /*
  * 64-bit integer manipulation macros (big endian)
@@ -120,14 +116,8 @@ static void mbedtls_sha512_starts(mbedtls_sha512_context *ctx) {
 //    ctx->state[6] = UL64(0x1F83D9ABFB41BD6B);
 //    ctx->state[7] = UL64(0x5BE0CD19137E2179);
 
-    ctx->state[0] = UL64(0x22312194fc2bf72c);
-    ctx->state[1] = UL64(0x9f555fa3c84c64c2);
-    ctx->state[2] = UL64(0x2393b86b6f53b151);
-    ctx->state[3] = UL64(0x963877195940eabd);
-    ctx->state[4] = UL64(0x96283ee2a88effe3);
-    ctx->state[5] = UL64(0xbe5e1e2553863992);
-    ctx->state[6] = UL64(0x2b0199fc2c85b8aa);
-    ctx->state[7] = UL64(0x0eb72ddc81c52ca2);
+    static const uint64_t iv[8] = SHA512_256_IV;
+    memcpy(ctx->state, iv, sizeof(iv));
 }
 
 /*
@@ -248,6 +238,152 @@ static void mbedtls_sha512_process(mbedtls_sha512_context *ctx,
     ctx->state[7] += H;
 }
 
+#if defined(SHA512_HOST_ACCEL)
+/*
+ * Host compression: the message schedule is kept as a 16 word window instead
+ * of 80 words, rounds are unrolled so the working variables are renamed
+ * instead of moved, and consecutive blocks are processed in one call with the
+ * state held in registers.
+ */
+#define SHA512_LOAD(p) __builtin_bswap64(sha512_load_word(p))
+
+static inline uint64_t sha512_load_word(const unsigned char *p) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+#define SCHED(i) \
+  (W[(i) & 15] += S1(W[((i) - 2) & 15]) + W[((i) - 7) & 15] + S0(W[((i) - 15) & 15]))
+
+#define R(a, b, c, d, e, f, g, h, i, w) P(a, b, c, d, e, f, g, h, w, K[(i)])
+
+#define ROUNDS_8(i, wf)                                        \
+  {                                                            \
+    R(A, B, C, D, E, F, G, H, (i) + 0, wf((i) + 0));           \
+    R(H, A, B, C, D, E, F, G, (i) + 1, wf((i) + 1));           \
+    R(G, H, A, B, C, D, E, F, (i) + 2, wf((i) + 2));           \
+    R(F, G, H, A, B, C, D, E, (i) + 3, wf((i) + 3));           \
+    R(E, F, G, H, A, B, C, D, (i) + 4, wf((i) + 4));           \
+    R(D, E, F, G, H, A, B, C, (i) + 5, wf((i) + 5));           \
+    R(C, D, E, F, G, H, A, B, (i) + 6, wf((i) + 6));           \
+    R(B, C, D, E, F, G, H, A, (i) + 7, wf((i) + 7));           \
+  }
+
+#define LOADW(i) (W[i] = SHA512_LOAD(data + 8 * (i)))
+
+static inline __attribute__((always_inline)) void sha512_blocks_unrolled(
+        uint64_t state[8], const unsigned char *data, size_t blocks) {
+    uint64_t temp1, temp2, W[16];
+    uint64_t A, B, C, D, E, F, G, H;
+
+    for (; blocks > 0; blocks--, data += 128) {
+        A = state[0];
+        B = state[1];
+        C = state[2];
+        D = state[3];
+        E = state[4];
+        F = state[5];
+        G = state[6];
+        H = state[7];
+
+        ROUNDS_8(0, LOADW)
+        ROUNDS_8(8, LOADW)
+        ROUNDS_8(16, SCHED)
+        ROUNDS_8(24, SCHED)
+        ROUNDS_8(32, SCHED)
+        ROUNDS_8(40, SCHED)
+        ROUNDS_8(48, SCHED)
+        ROUNDS_8(56, SCHED)
+        ROUNDS_8(64, SCHED)
+        ROUNDS_8(72, SCHED)
+
+        state[0] += A;
+        state[1] += B;
+        state[2] += C;
+        state[3] += D;
+        state[4] += E;
+        state[5] += F;
+        state[6] += G;
+        state[7] += H;
+    }
+}
+
+typedef void (*sha512_blocks_fn)(uint64_t state[8], const unsigned char *data, size_t blocks);
+
+static void sha512_blocks_reference(uint64_t state[8], const unsigned char *data, size_t blocks) {
+    mbedtls_sha512_context ctx;
+    memcpy(ctx.state, state, sizeof(ctx.state));
+    for (; blocks > 0; blocks--, data += 128) {
+        mbedtls_sha512_process(&ctx, data);
+    }
+    memcpy(state, ctx.state, sizeof(ctx.state));
+}
+
+static void sha512_blocks_portable(uint64_t state[8], const unsigned char *data, size_t blocks) {
+    sha512_blocks_unrolled(state, data, blocks);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+/* Same code, rotations become rorx which leaves the flags alone */
+__attribute__((target("bmi2")))
+static void sha512_blocks_bmi2(uint64_t state[8], const unsigned char *data, size_t blocks) {
+    sha512_blocks_unrolled(state, data, blocks);
+}
+
+static int sha512_cpu_has_bmi2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+}
+#endif
+
+/* Never NULL, so hashing before the constructor below has run still works */
+static sha512_blocks_fn sha512_blocks = sha512_blocks_portable;
+static sha512_impl_e sha512_impl = SHA512_IMPL_UNROLLED;
+
+int SHA512_256_select_impl(sha512_impl_e impl) {
+    switch (impl) {
+        case SHA512_IMPL_REFERENCE:
+            sha512_blocks = sha512_blocks_reference;
+            break;
+        case SHA512_IMPL_UNROLLED:
+            sha512_blocks = sha512_blocks_portable;
+            break;
+        case SHA512_IMPL_BMI2:
+#if defined(__x86_64__) && defined(__GNUC__)
+            if (!sha512_cpu_has_bmi2()) {
+                return 0;
+            }
+            sha512_blocks = sha512_blocks_bmi2;
+            break;
+#else
+            return 0;
+#endif
+        default:
+            return 0;
+    }
+    sha512_impl = impl;
+    return 1;
+}
+
+sha512_impl_e SHA512_256_impl(void) { return sha512_impl; }
+
+/* Picked once at load time, before any thread can hash */
+__attribute__((constructor)) static void sha512_select_default_impl(void) {
+    SHA512_256_select_impl(SHA512_IMPL_BMI2);
+}
+
+static void sha512_process_blocks(mbedtls_sha512_context *ctx, const unsigned char *data, size_t blocks) {
+    sha512_blocks(ctx->state, data, blocks);
+}
+#else
+static void sha512_process_blocks(mbedtls_sha512_context *ctx, const unsigned char *data, size_t blocks) {
+    for (; blocks > 0; blocks--, data += 128) {
+        mbedtls_sha512_process(ctx, data);
+    }
+}
+#endif
+
 /*
  * SHA-512 process buffer
  */
@@ -267,16 +403,16 @@ static void mbedtls_sha512_update(mbedtls_sha512_context *ctx,
 
     if (left && ilen >= fill) {
         memcpy((void *) (ctx->buffer + left), input, fill);
-        mbedtls_sha512_process(ctx, ctx->buffer);
+        sha512_process_blocks(ctx, ctx->buffer, 1);
         input += fill;
         ilen -= fill;
         left = 0;
     }
 
-    while (ilen >= 128) {
-        mbedtls_sha512_process(ctx, input);
-        input += 128;
-        ilen -= 128;
+    if (ilen >= 128) {
+        sha512_process_blocks(ctx, input, ilen / 128);
+        input += ilen & ~(size_t) 127;
+        ilen &= 127;
     }
 
     if (ilen > 0) memcpy((void *) (ctx->buffer + left), input, ilen);
@@ -359,3 +495,240 @@ void SHA512_256_with_context(const uint8_t *in_ctx, size_t n_ctx,
     mbedtls_sha512_finish(&ctx, out);
     secure_wipe((uint8_t *) &ctx, sizeof(ctx));
 }
+
+void SHA512_256_init(sha512_256_state_t *st) {
+    mbedtls_sha512_init(st);
+    mbedtls_sha512_starts(st);
+}
+
+void SHA512_256_update(sha512_256_state_t *st, const uint8_t *in, size_t n) {
+    mbedtls_sha512_update(st, in, n);
+}
+
+void SHA512_256_final(sha512_256_state_t *st, uint8_t out[SHA512_DIGEST_LENGTH]) {
+    mbedtls_sha512_finish(st, out);
+    secure_wipe((uint8_t *) st, sizeof(*st));
+}
+
+void SHA512_256_resume(const sha512_256_state_t *prefix,
+                       const uint8_t *in, size_t n, uint8_t out[SHA512_DIGEST_LENGTH]) {
+    mbedtls_sha512_context ctx;
+
+    memcpy(&ctx, prefix, sizeof(ctx));
+    mbedtls_sha512_update(&ctx, in, n);
+    mbedtls_sha512_finish(&ctx, out);
+    secure_wipe((uint8_t *) &ctx, sizeof(ctx));
+}
+
+#if defined(SHA512_HOST_ACCEL)
+/*
+ * Multi-buffer SHA-512: the rounds above run on vectors holding one word of
+ * every lane, so the same macros serve both
+ */
+typedef uint64_t sha512_lanes_t __attribute__((vector_size(8 * SHA512_LANES)));
+
+#define LANEW(i) (W[i])
+
+static inline __attribute__((always_inline)) void sha512_lanes_compress(sha512_lanes_t S[8],
+                                                                       const sha512_lanes_t in[16]) {
+    sha512_lanes_t temp1, temp2, W[16];
+    sha512_lanes_t A = S[0], B = S[1], C = S[2], D = S[3], E = S[4], F = S[5], G = S[6], H = S[7];
+
+    memcpy(W, in, sizeof(W));
+    ROUNDS_8(0, LANEW)
+    ROUNDS_8(8, LANEW)
+    ROUNDS_8(16, SCHED)
+    ROUNDS_8(24, SCHED)
+    ROUNDS_8(32, SCHED)
+    ROUNDS_8(40, SCHED)
+    ROUNDS_8(48, SCHED)
+    ROUNDS_8(56, SCHED)
+    ROUNDS_8(64, SCHED)
+    ROUNDS_8(72, SCHED)
+
+    S[0] += A;
+    S[1] += B;
+    S[2] += C;
+    S[3] += D;
+    S[4] += E;
+    S[5] += F;
+    S[6] += G;
+    S[7] += H;
+}
+
+typedef void (*sha512_lanes_fn)(sha512_lanes_t S[8], const sha512_lanes_t in[16]);
+
+static void sha512_lanes_portable(sha512_lanes_t S[8], const sha512_lanes_t in[16]) {
+    sha512_lanes_compress(S, in);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("avx2")))
+static void sha512_lanes_avx2(sha512_lanes_t S[8], const sha512_lanes_t in[16]) {
+    sha512_lanes_compress(S, in);
+}
+
+/* AVX-512VL adds 64-bit vector rotations */
+__attribute__((target("avx2,avx512f,avx512vl")))
+static void sha512_lanes_avx512(sha512_lanes_t S[8], const sha512_lanes_t in[16]) {
+    sha512_lanes_compress(S, in);
+}
+#endif
+
+static sha512_lanes_fn sha512_lanes = sha512_lanes_portable;
+static sha512_lanes_e sha512_lanes_impl = SHA512_LANES_SERIAL;
+
+int SHA512_256_select_lanes(sha512_lanes_e impl) {
+    switch (impl) {
+        case SHA512_LANES_SERIAL:
+        case SHA512_LANES_PORTABLE:
+            sha512_lanes = sha512_lanes_portable;
+            break;
+#if defined(__x86_64__) && defined(__GNUC__)
+        case SHA512_LANES_AVX2:
+            __builtin_cpu_init();
+            if (!__builtin_cpu_supports("avx2")) {
+                return 0;
+            }
+            sha512_lanes = sha512_lanes_avx2;
+            break;
+        case SHA512_LANES_AVX512:
+            __builtin_cpu_init();
+            if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512vl")) {
+                return 0;
+            }
+            sha512_lanes = sha512_lanes_avx512;
+            break;
+#endif
+        default:
+            return 0;
+    }
+    sha512_lanes_impl = impl;
+    return 1;
+}
+
+sha512_lanes_e SHA512_256_lanes_impl(void) { return sha512_lanes_impl; }
+
+__attribute__((constructor)) static void sha512_select_default_lanes(void) {
+    if (!SHA512_256_select_lanes(SHA512_LANES_AVX512)) {
+        SHA512_256_select_lanes(SHA512_LANES_AVX2);
+    }
+}
+
+typedef struct {
+    const uint8_t *msg;
+    size_t len;
+    size_t index;  /* output slot, count when the lane is idle */
+    size_t block;  /* next block of the padded stream */
+    size_t blocks;
+    unsigned char scratch[128];
+} sha512_lane_t;
+
+/*
+ * Block b of prefix buffer || message || padding, pointing into the message
+ * when the block lies entirely within it
+ */
+static const unsigned char *sha512_lane_block(sha512_lane_t *lane, const sha512_256_state_t *prefix) {
+    const size_t left = (size_t) (prefix->total[0] & 0x7F);
+    const size_t end = left + lane->len;
+    const size_t pos = 128 * lane->block;
+
+    if (pos >= left && pos + 128 <= end) {
+        return lane->msg + (pos - left);
+    }
+
+    unsigned char *blk = lane->scratch;
+    memset(blk, 0, 128);
+    if (pos < left) {
+        memcpy(blk, prefix->buffer + pos, left - pos);
+    }
+    const size_t from = pos > left ? pos : left;
+    const size_t to = end < pos + 128 ? end : pos + 128;
+    if (from < to) {
+        memcpy(blk + (from - pos), lane->msg + (from - left), to - from);
+    }
+    if (end >= pos && end < pos + 128) {
+        blk[end - pos] = 0x80;
+    }
+    if (lane->block + 1 == lane->blocks) {
+        uint64_t total0 = prefix->total[0] + (uint64_t) lane->len;
+        uint64_t total1 = prefix->total[1] + (total0 < prefix->total[0]);
+        const uint64_t high = (total0 >> 61) | (total1 << 3);
+        const uint64_t low = total0 << 3;
+        PUT_UINT64_BE(high, blk, 112);
+        PUT_UINT64_BE(low, blk, 120);
+    }
+    return blk;
+}
+
+static void sha512_lane_start(sha512_lane_t *lane, sha512_lanes_t S[8], size_t l,
+                              const sha512_256_state_t *prefix, const uint8_t *const *in, const size_t *n,
+                              size_t *next, size_t count) {
+    lane->index = count;
+    if (*next == count) {
+        return;
+    }
+    lane->index = (*next)++;
+    lane->msg = in[lane->index];
+    lane->len = n[lane->index];
+    lane->block = 0;
+    /* data, the 0x80 byte and 16 bytes of length, rounded up to whole blocks */
+    lane->blocks = ((size_t) (prefix->total[0] & 0x7F) + lane->len + 17 + 127) / 128;
+    for (int j = 0; j < 8; j++) {
+        S[j][l] = prefix->state[j];
+    }
+}
+
+void SHA512_256_many(const sha512_256_state_t *prefix, const uint8_t *const *in, const size_t *n,
+                     size_t count, uint8_t *out) {
+    static const sha512_256_state_t empty = { {0, 0}, SHA512_256_IV, {0} };
+    static const unsigned char idle[128] = {0};
+    sha512_lane_t lanes[SHA512_LANES];
+    sha512_lanes_t S[8] = {0};
+    sha512_lanes_t W[16];
+    size_t next = 0;
+    size_t busy = 0;
+
+    if (prefix == NULL) {
+        prefix = &empty;
+    }
+    if (sha512_lanes_impl == SHA512_LANES_SERIAL) {
+        for (size_t i = 0; i < count; i++) {
+            SHA512_256_resume(prefix, in[i], n[i], out + SHA512_DIGEST_LENGTH * i);
+        }
+        return;
+    }
+
+    for (size_t l = 0; l < SHA512_LANES; l++) {
+        sha512_lane_start(&lanes[l], S, l, prefix, in, n, &next, count);
+        busy += lanes[l].index != count;
+    }
+
+    while (busy > 0) {
+        for (size_t l = 0; l < SHA512_LANES; l++) {
+            const unsigned char *blk = lanes[l].index != count ? sha512_lane_block(&lanes[l], prefix) : idle;
+            for (int j = 0; j < 16; j++) {
+                W[j][l] = SHA512_LOAD(blk + 8 * j);
+            }
+        }
+
+        sha512_lanes(S, W);
+
+        for (size_t l = 0; l < SHA512_LANES; l++) {
+            sha512_lane_t *lane = &lanes[l];
+            if (lane->index == count || ++lane->block < lane->blocks) {
+                continue;
+            }
+            for (int j = 0; j < 8; j++) {
+                PUT_UINT64_BE(S[j][l], out, SHA512_DIGEST_LENGTH * lane->index + 8 * j);
+            }
+            sha512_lane_start(lane, S, l, prefix, in, n, &next, count);
+            busy -= lane->index == count;
+        }
+    }
+
+    secure_wipe((uint8_t *) lanes, sizeof(lanes));
+    secure_wipe((uint8_t *) S, sizeof(S));
+    secure_wipe((uint8_t *) W, sizeof(W));
+}
+#endif
@@ -24,6 +24,24 @@
 #include <stdint.h>
 
 #define SHA512_DIGEST_LENGTH 64
+#define SHA512_BLOCK_LENGTH 128
+
+/*
+ * SHA-512/256 hash state, can be copied to resume hashing from a common prefix
+ */
+typedef struct {
+    uint64_t total[2];                    /*!< number of bytes processed  */
+    uint64_t state[8];                    /*!< intermediate digest state  */
+    uint8_t buffer[SHA512_BLOCK_LENGTH];  /*!< data block being processed */
+} sha512_256_state_t;
+
+#define SHA512_256_IV                                             \
+  {                                                               \
+    0x22312194fc2bf72cULL, 0x9f555fa3c84c64c2ULL,                 \
+    0x2393b86b6f53b151ULL, 0x963877195940eabdULL,                 \
+    0x96283ee2a88effe3ULL, 0xbe5e1e2553863992ULL,                 \
+    0x2b0199fc2c85b8aaULL, 0x0eb72ddc81c52ca2ULL                  \
+  }
 
 extern void SHA512_256(const uint8_t* in, size_t n,
                        uint8_t out[SHA512_DIGEST_LENGTH]);
@@ -34,6 +52,64 @@ void SHA512_256_with_context_version(const uint8_t *in_ctx, size_t n_ctx,
 
 void SHA512_256_with_context(const uint8_t *in_ctx, size_t n_ctx,
                              const uint8_t *in, size_t n, uint8_t out[SHA512_DIGEST_LENGTH]);
+
+void SHA512_256_init(sha512_256_state_t *st);
+
+void SHA512_256_update(sha512_256_state_t *st, const uint8_t *in, size_t n);
+
+// Writes the digest and wipes the state
+void SHA512_256_final(sha512_256_state_t *st, uint8_t out[SHA512_DIGEST_LENGTH]);
+
+// Hashes prefix || in, where prefix is whatever was absorbed into the given state
+void SHA512_256_resume(const sha512_256_state_t *prefix,
+                       const uint8_t *in, size_t n, uint8_t out[SHA512_DIGEST_LENGTH]);
+
+/*
+ * 64-bit hosts pick an unrolled compression function at runtime, the device
+ * build keeps the reference one
+ */
+#if defined(__x86_64__) || defined(__aarch64__)
+#define SHA512_HOST_ACCEL
+
+typedef enum {
+    SHA512_IMPL_REFERENCE = 0,
+    SHA512_IMPL_UNROLLED,
+    SHA512_IMPL_BMI2,
+} sha512_impl_e;
+
+// Implementation the next hashes use
+sha512_impl_e SHA512_256_impl(void);
+
+// Forces an implementation, returns 0 if this CPU cannot run it. The default is picked at load time,
+// this is for tests and benchmarks and must not race with hashing on other threads.
+int SHA512_256_select_impl(sha512_impl_e impl);
+
+/*
+ * Multi-buffer hashing: messages are spread over SHA512_LANES independent
+ * hashes advanced together, a lane takes the next message when its own ends
+ */
+#define SHA512_LANES 4
+
+typedef enum {
+    SHA512_LANES_SERIAL = 0,  /* one message after the other, without vector units it is faster */
+    SHA512_LANES_PORTABLE,
+    SHA512_LANES_AVX2,
+    SHA512_LANES_AVX512,
+} sha512_lanes_e;
+
+// Lane implementation the next SHA512_256_many calls use
+sha512_lanes_e SHA512_256_lanes_impl(void);
+
+// Forces a lane implementation, returns 0 if this CPU cannot run it. Same restriction as
+// SHA512_256_select_impl.
+int SHA512_256_select_lanes(sha512_lanes_e impl);
+
+// Hashes prefix || in[i] for count messages, digests are written SHA512_DIGEST_LENGTH bytes
+// apart in out. A NULL prefix is the empty one.
+void SHA512_256_many(const sha512_256_state_t *prefix, const uint8_t *const *in, const size_t *n,
+                     size_t count, uint8_t *out);
+#endif
+
 // Zero the memory pointed to by v; this will not be optimized away.
 extern void secure_wipe(uint8_t* v, uint32_t n);
 
@@ -0,0 +1,313 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "coin.h"
+#include "eth_utils.h"
+#include "parser.h"
+#include "tx_buffer.h"
+
+
+#ifdef NDEBUG
+#error "This fuzz target won't work correctly with NDEBUG defined, which will cause asserts to be eliminated"
+#endif
+
+
+using std::size_t;
+
+static char PARSER_KEY[16384];
+static char PARSER_VALUE[16384];
+
+////////////////////////////////////////////////////////////////////////////////
+// Host model of the sign APDU chunk state machine
+//
+// Mirrors process_chunk / process_chunk_eth in apdu_handler.c on top of the
+// real tx_buffer code, with THROW turned into an early return. State
+// survives a failed chunk exactly as it does on the device, so sequences of
+// out-of-order, truncated or oversized chunks are explored as well.
+//
+// Input layout: [mode][p1][p2][len][len bytes][p1][p2][len]...
+//   mode bit 0 selects the Ethereum (RLP) flow
+////////////////////////////////////////////////////////////////////////////////
+
+#define MODEL_RAM_BUFFER_SIZE 8192
+#define MODEL_FLASH_BUFFER_SIZE 32768
+
+static uint8_t model_ram_buffer[MODEL_RAM_BUFFER_SIZE];
+alignas(TX_BUFFER_PAGE_SIZE) static uint8_t model_flash_buffer[MODEL_FLASH_BUFFER_SIZE];
+
+typedef enum {
+    chunk_more,
+    chunk_last,
+    chunk_error,
+} chunk_result_e;
+
+typedef struct {
+    bool initialized;
+    bool header_checked;
+    tx_type_t tx_type;
+    uint32_t hdPath[MAX_BIP32_PATH];
+    uint32_t hdPathLen;
+} chunk_model_t;
+
+static chunk_model_t model;
+
+static void model_initialize(tx_type_t tx_type)
+{
+    model.tx_type = tx_type;
+    tx_buffer_init(model_ram_buffer, sizeof(model_ram_buffer), model_flash_buffer, sizeof(model_flash_buffer));
+    tx_buffer_reset();
+}
+
+static bool model_extract_path(const uint8_t *data, uint32_t len)
+{
+    memset(model.hdPath, 0, sizeof(model.hdPath));
+    if (len == sizeof(uint32_t) * HDPATH_LEN_ADR0008) {
+        model.hdPathLen = HDPATH_LEN_ADR0008;
+    } else if (len == sizeof(uint32_t) * HDPATH_LEN_DEFAULT) {
+        model.hdPathLen = HDPATH_LEN_DEFAULT;
+    } else {
+        return false;
+    }
+    memcpy(model.hdPath, data, sizeof(uint32_t) * model.hdPathLen);
+
+    const bool mainnet = model.hdPath[0] == HDPATH_0_DEFAULT &&
+                         (model.hdPath[1] == HDPATH_1_DEFAULT || model.hdPath[1] == HDPATH_1_ALTERNATIVE ||
+                          model.hdPath[1] == HDPATH_1_ALTERNATIVE2);
+    if (!mainnet) {
+        return false;
+    }
+
+    return !(model.hdPathLen == HDPATH_LEN_ADR0008 && model.hdPath[2] < 0x80000000);
+}
+
+static bool model_extract_eth_path(const uint8_t *data, uint32_t len)
+{
+    model.initialized = false;
+
+    const uint32_t path_len = data[0];
+    if (path_len > MAX_BIP32_PATH || path_len < 1) {
+        return false;
+    }
+    if (len - 1 < sizeof(uint32_t) * path_len) {
+        return false;
+    }
+
+    const uint8_t *path_data = data + 1;
+    for (uint32_t i = 0; i < path_len; i++) {
+        model.hdPath[i] = ((uint32_t)path_data[0] << 24) | ((uint32_t)path_data[1] << 16) |
+                          ((uint32_t)path_data[2] << 8) | path_data[3];
+        path_data += sizeof(uint32_t);
+    }
+
+    if (model.hdPath[0] != HDPATH_ETH_0_DEFAULT || model.hdPath[1] != HDPATH_ETH_1_DEFAULT) {
+        return false;
+    }
+
+    model.hdPathLen = path_len;
+    return true;
+}
+
+static bool model_check_header()
+{
+    if (model.header_checked) {
+        return true;
+    }
+
+    uint32_t length = 0;
+    const uint8_t *head = tx_buffer_head(&length);
+    parser_context_t ctx = {};
+    ctx.tx_type = model.tx_type;
+
+    const parser_error_t err = parser_parseHeader(&ctx, head, length);
+    if (err != parser_ok && err != parser_no_data) {
+        model.initialized = false;
+        return false;
+    }
+    model.header_checked = err == parser_ok;
+    return true;
+}
+
+static chunk_result_e model_process_chunk(uint8_t p1, uint8_t p2, uint8_t *data, uint32_t len)
+{
+    if (p2 != 0) {
+        return chunk_error;
+    }
+
+    switch (p1) {
+        case 0:
+            model_initialize(oasis_tx);
+            if (!model_extract_path(data, len)) {
+                return chunk_error;
+            }
+            model.initialized = true;
+            model.header_checked = false;
+            return chunk_more;
+        case 1:
+        case 2:
+            if (!model.initialized) {
+                return chunk_error;
+            }
+            if (tx_buffer_append(data, len) != len) {
+                model.initialized = false;
+                return chunk_error;
+            }
+            if (p1 == 1 && !model_check_header()) {
+                return chunk_error;
+            }
+            return p1 == 2 ? chunk_last : chunk_more;
+    }
+
+    model.initialized = false;
+    return chunk_error;
+}
+
+static chunk_result_e model_process_chunk_eth(uint8_t p1, uint8_t p2, uint8_t *data, uint32_t len)
+{
+    if (p2 != 0) {
+        return chunk_error;
+    }
+
+    uint64_t read = 0;
+    uint64_t to_read = 0;
+    uint64_t max_len = 0;
+
+    switch (p1) {
+        case P1_ETH_FIRST: {
+            model_initialize(eth_tx);
+            if (len == 0 || !model_extract_eth_path(data, len)) {
+                return chunk_error;
+            }
+
+            const uint32_t path_len = sizeof(uint32_t) * model.hdPathLen;
+            data += path_len + 1;
+            len -= path_len + 1;
+
+            if (get_tx_rlp_len(data, len, &read, &to_read) != rlp_ok) {
+                return chunk_error;
+            }
+
+            max_len = saturating_add(read, to_read);
+            max_len = max_len < len ? max_len : len;
+
+            if ((uint64_t)tx_buffer_append(data, (uint32_t)max_len) != max_len) {
+                return chunk_error;
+            }
+
+            model.initialized = true;
+            return saturating_add(read, to_read) - len == 0 ? chunk_last : chunk_more;
+        }
+        case P1_ETH_MORE: {
+            if (!model.initialized) {
+                return chunk_error;
+            }
+
+            uint8_t rlp_header[RLP_TX_HEADER_MAX_LEN] = {};
+            const uint32_t header_len = tx_buffer_read(0, rlp_header, sizeof(rlp_header));
+            if (get_tx_rlp_len(rlp_header, header_len, &read, &to_read) != rlp_ok) {
+                return chunk_error;
+            }
+
+            const uint64_t rlp_read = tx_buffer_length() - read;
+            const uint64_t missing = to_read - rlp_read;
+            max_len = missing < len ? missing : len;
+
+            if ((uint64_t)tx_buffer_append(data, (uint32_t)max_len) != max_len) {
+                model.initialized = false;
+                return chunk_error;
+            }
+
+            if (missing - len == 0) {
+                model.initialized = false;
+                return chunk_last;
+            }
+            return chunk_more;
+        }
+    }
+
+    return chunk_error;
+}
+
+static void model_parse()
+{
+    const uint32_t length = tx_buffer_length();
+    assert(length <= MODEL_FLASH_BUFFER_SIZE);
+
+    // The read cursor and the contiguous view must agree on every byte
+    std::vector<uint8_t> copy(length);
+    assert(tx_buffer_read(0, copy.data(), length) == length);
+    const uint8_t *buffer = tx_buffer_data();
+    assert(length == 0 || memcmp(copy.data(), buffer, length) == 0);
+
+    if (model.tx_type == eth_tx) {
+        // A completed RLP transaction is never longer than its own header says
+        uint64_t read = 0;
+        uint64_t to_read = 0;
+        if (get_tx_rlp_len(buffer, length, &read, &to_read) == rlp_ok) {
+            assert(length <= saturating_add(read, to_read));
+        }
+    }
+
+    parser_context_t ctx = {};
+    ctx.tx_type = model.tx_type;
+    if (parser_parse(&ctx, buffer, length) != parser_ok || parser_validate(&ctx) != parser_ok) {
+        return;
+    }
+
+    uint8_t num_items = 0;
+    if (parser_getNumItems(&ctx, &num_items) != parser_ok) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < num_items; i++) {
+        uint8_t page_count = 1;
+        const parser_error_t rc = parser_getItem(&ctx, i,
+                                                 PARSER_KEY, sizeof(PARSER_KEY),
+                                                 PARSER_VALUE, sizeof(PARSER_VALUE),
+                                                 0, &page_count);
+        if (rc != parser_ok) {
+            fprintf(stderr,
+                    "error getting item %u: %s\n",
+                    (unsigned)i,
+                    parser_getErrorDescription(rc));
+            assert(false);
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < 1) {
+        return 0;
+    }
+
+    const bool eth = (data[0] & 1) != 0;
+    size_t offset = 1;
+
+    memset(&model, 0, sizeof(model));
+    model_initialize(eth ? eth_tx : oasis_tx);
+
+    while (offset + 3 <= size) {
+        const uint8_t p1 = data[offset];
+        const uint8_t p2 = data[offset + 1];
+        size_t len = data[offset + 2];
+        offset += 3;
+        if (len > size - offset) {
+            len = size - offset;
+        }
+
+        // Exact-size copy so that reads past the APDU payload are caught by ASAN
+        std::vector<uint8_t> chunk(data + offset, data + offset + len);
+        offset += len;
+
+        const chunk_result_e result = eth ? model_process_chunk_eth(p1, p2, chunk.data(), len)
+                                          : model_process_chunk(p1, p2, chunk.data(), len);
+        if (result == chunk_last) {
+            model_parse();
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <cstdint>
+#include <cstdio>
+
+#include "emu.h"
+
+
+#ifdef NDEBUG
+#error "This fuzz target won't work correctly with NDEBUG defined, which will cause asserts to be eliminated"
+#endif
+
+
+using std::size_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Runs sequences of raw APDUs through the real handleApdu on the host emulator
+// (tests/emu), answering every review the app starts.
+//
+// Input layout: [flags][len][len bytes of APDU][flags][len]...
+//   flags bit 0 approves the review the APDU started, otherwise it is rejected
+//   flags bit 1 locks the device before the APDU
+////////////////////////////////////////////////////////////////////////////////
+
+#define FLAG_APPROVE 0x01
+#define FLAG_LOCKED 0x02
+
+static uint8_t reply[512];
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    emu_reset();
+
+    while (size >= 2) {
+        const uint8_t flags = data[0];
+        const size_t len = data[1];
+        data += 2;
+        size -= 2;
+        if (len > size) {
+            break;
+        }
+
+        emu_set_pin_validated((flags & FLAG_LOCKED) == 0);
+        emu_exchange(data, (uint16_t)len, reply, sizeof(reply));
+
+        if (emu_review_pending()) {
+            if ((flags & FLAG_APPROVE) != 0) {
+                emu_review_approve(reply, sizeof(reply));
+            } else {
+                emu_review_reject(reply, sizeof(reply));
+            }
+        }
+
+        data += len;
+        size -= len;
+    }
+
+    return 0;
+}
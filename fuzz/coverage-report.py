@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+
+# Replays the fuzz corpora on a coverage-instrumented build and reports
+# source coverage of app/src.
+#
+#   cmake -B build-coverage -DENABLE_FUZZING=ON -DENABLE_COVERAGE=ON \
+#         -DCMAKE_C_COMPILER=clang -DCMAKE_CXX_COMPILER=clang++
+#   cmake --build build-coverage
+#   fuzz/coverage-report.py --build-dir build-coverage
+
+import argparse
+import glob
+import os
+import shlex
+import shutil
+import subprocess
+
+from fuzz_common import corpus_dir, fuzz_path, sanitizer_env, select_configs
+
+SOURCES = [os.path.join('app', 'src')]
+
+
+def run(cmd, **kwargs):
+    print(' '.join(shlex.quote(c) for c in cmd), flush=True)
+    return subprocess.call(cmd, **kwargs)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate an LLVM coverage report from the fuzz corpora')
+    parser.add_argument('targets', nargs='*', help='fuzz targets to replay (default: all)')
+    parser.add_argument('--build-dir', default='build-coverage', help='build configured with ENABLE_COVERAGE=ON')
+    parser.add_argument('--output-dir', default=os.path.join('fuzz', 'coverage'), help='report output directory')
+    parser.add_argument('--llvm-suffix', default='', help='suffix of the llvm tools, e.g. -15')
+    args = parser.parse_args()
+
+    profdata_tool = f'llvm-profdata{args.llvm_suffix}'
+    cov_tool = f'llvm-cov{args.llvm_suffix}'
+
+    raw_dir = os.path.join(args.output_dir, 'raw')
+    shutil.rmtree(args.output_dir, ignore_errors=True)
+    os.makedirs(raw_dir)
+
+    env = sanitizer_env()
+    # crashing inputs must not stop the replay
+    env['ASAN_OPTIONS'] = 'halt_on_error=0:detect_leaks=0'
+    env['UBSAN_OPTIONS'] = 'halt_on_error=0'
+
+    binaries = []
+    for fuzzer, max_len, _ in select_configs(args.targets):
+        binary = fuzz_path(args.build_dir, fuzzer)
+        if not os.path.exists(binary) or not os.path.isdir(corpus_dir(fuzzer)):
+            print(f'skipping {fuzzer}: missing binary or corpus')
+            continue
+        binaries.append(binary)
+        env['LLVM_PROFILE_FILE'] = os.path.join(raw_dir, f'{fuzzer}-%p.profraw')
+        run([binary, '-runs=0', f'-max_len={max_len}', corpus_dir(fuzzer)], env=env)
+
+    if not binaries:
+        raise SystemExit('nothing to report')
+
+    profdata = os.path.join(args.output_dir, 'fuzz.profdata')
+    if run([profdata_tool, 'merge', '-sparse', '-o', profdata] + glob.glob(os.path.join(raw_dir, '*.profraw'))) != 0:
+        raise SystemExit('llvm-profdata merge failed')
+
+    objects = [binaries[0]] + [arg for b in binaries[1:] for arg in ('-object', b)]
+    common = [f'-instr-profile={profdata}'] + objects
+
+    with open(os.path.join(args.output_dir, 'summary.txt'), 'w') as summary:
+        run([cov_tool, 'report'] + common + SOURCES, stdout=summary)
+    run([cov_tool, 'show', '-format=html', f'-output-dir={os.path.join(args.output_dir, "html")}',
+         '-show-line-counts-or-regions'] + common + SOURCES)
+
+    with open(os.path.join(args.output_dir, 'summary.txt')) as summary:
+        print(summary.read())
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,55 @@
+# Shared configuration of the fuzzing scripts
+
+import os
+import subprocess
+
+# (fuzzer name, max length, max time scale factor)
+CONFIGS = [
+    ('parser_parse', 17000, 4),
+    ('parser_eth', 17000, 2),
+    ('parser_inspect', 17000, 2),
+    ('apdu_chunks', 20000, 2),
+    ('apdu_handler', 20000, 2),
+]
+
+FUZZ_DIR = 'fuzz'
+CORPORA_DIR = os.path.join(FUZZ_DIR, 'corpora')
+
+
+def select_configs(targets):
+    if not targets:
+        return CONFIGS
+    unknown = set(targets) - {c[0] for c in CONFIGS}
+    if unknown:
+        raise SystemExit(f'unknown fuzz targets: {", ".join(sorted(unknown))}')
+    return [c for c in CONFIGS if c[0] in targets]
+
+
+def corpus_dir(fuzzer):
+    return os.path.join(CORPORA_DIR, fuzzer)
+
+
+def artifact_dir(fuzzer):
+    return os.path.join(CORPORA_DIR, f'{fuzzer}-artifacts')
+
+
+def dict_path(fuzzer):
+    return os.path.join(FUZZ_DIR, 'dicts', f'{fuzzer}.dict')
+
+
+def fuzz_path(build_dir, fuzzer):
+    return os.path.join(build_dir, 'bin', f'fuzz-{fuzzer}')
+
+
+def sanitizer_env():
+    env = os.environ.copy()
+    env['ASAN_OPTIONS'] = 'halt_on_error=1:print_stacktrace=1'
+    env['UBSAN_OPTIONS'] = 'halt_on_error=1:print_stacktrace=1'
+    return env
+
+
+def prepare_dirs(fuzzer):
+    os.makedirs(artifact_dir(fuzzer), exist_ok=True)
+    os.makedirs(corpus_dir(fuzzer), exist_ok=True)
+    if not os.listdir(corpus_dir(fuzzer)):
+        subprocess.call(['python3', os.path.join(FUZZ_DIR, 'generate-seed-corpus.py'), fuzzer])
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+
+# Builds the seed corpora of every fuzz target from the JSON test vectors and
+# the zemu test blobs, so that the fuzzers start from well-formed consensus,
+# runtime and Ethereum transactions.
+
+import base64
+import glob
+import hashlib
+import json
+import os
+import re
+import struct
+import sys
+
+TESTVECTORS_DIR = os.path.join('tests', 'testvectors')
+ZEMU_TESTS_DIR = os.path.join('tests_zemu', 'tests')
+CORPORA_DIR = os.path.join('fuzz', 'corpora')
+
+CHUNK_SIZE = 250
+
+OASIS_PATH = struct.pack('<5I', 0x8000002c, 0x800001da, 0x80000000, 0, 0)
+ETH_PATH = bytes([5]) + struct.pack('>5I', 0x8000002c, 0x8000003c, 0x80000000, 0, 0)
+
+# navigation bytes for parser_inspect: enter, print, enter, print, back, print
+INSPECT_NAVIGATION = bytes([0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 1, 2])
+
+RUNTIME_BLOB_RE = re.compile(
+    r"const meta = Buffer\.from\(\s*'([A-Za-z0-9+/=]+)',\s*'base64',?\s*\)\s*"
+    r"const txBlob = Buffer\.from\(\s*'([A-Za-z0-9+/=]+)',\s*'base64',?\s*\)")
+ETH_BLOB_RE = re.compile(r"Buffer\.from\(\s*'([0-9a-fA-F]+)',\s*'hex',?\s*\)")
+
+
+def consensus_blob(tc):
+    encoded = tc.get('encoded_entity_meta', tc.get('encoded_tx'))
+    context = tc.get('signature_context', '').encode()
+    if encoded is None or len(context) >= 256:
+        return None
+    return bytes([len(context)]) + context + base64.b64decode(encoded)
+
+
+def read_consensus_blobs():
+    blobs = []
+    for path in sorted(glob.glob(os.path.join(TESTVECTORS_DIR, '*.json'))):
+        with open(path) as f:
+            for tc in json.load(f):
+                blob = consensus_blob(tc)
+                if blob is not None:
+                    blobs.append(blob)
+    return blobs
+
+
+def read_runtime_blobs():
+    blobs = []
+    for path in sorted(glob.glob(os.path.join(ZEMU_TESTS_DIR, '*.ts'))):
+        with open(path) as f:
+            for meta, tx in RUNTIME_BLOB_RE.findall(f.read()):
+                blobs.append(base64.b64decode(meta) + base64.b64decode(tx))
+    return blobs
+
+
+def read_eth_blobs():
+    blobs = []
+    for path in sorted(glob.glob(os.path.join(ZEMU_TESTS_DIR, 'eth_*.ts'))):
+        with open(path) as f:
+            blobs += [bytes.fromhex(h) for h in ETH_BLOB_RE.findall(f.read()) if len(h) % 2 == 0]
+    return blobs
+
+
+def chunk(p1, data):
+    return bytes([p1, 0, len(data)]) + data
+
+
+def oasis_chunks(blob):
+    out = bytes([0]) + chunk(0, OASIS_PATH)
+    parts = [blob[i:i + CHUNK_SIZE] for i in range(0, len(blob), CHUNK_SIZE)]
+    for i, part in enumerate(parts):
+        out += chunk(2 if i == len(parts) - 1 else 1, part)
+    return out
+
+
+def eth_chunks(blob):
+    first = ETH_PATH + blob[:CHUNK_SIZE - len(ETH_PATH)]
+    out = bytes([1]) + chunk(0x00, first)
+    rest = blob[CHUNK_SIZE - len(ETH_PATH):]
+    for i in range(0, len(rest), CHUNK_SIZE):
+        out += chunk(0x80, rest[i:i + CHUNK_SIZE])
+    return out
+
+
+def apdus(ins, blob):
+    # [flags][len][apdu] records for apdu_handler, the review is approved
+    out = bytes([0, 5 + len(OASIS_PATH), 0x05, ins, 0, 0, len(OASIS_PATH)]) + OASIS_PATH
+    parts = [blob[i:i + CHUNK_SIZE] for i in range(0, len(blob), CHUNK_SIZE)]
+    for i, part in enumerate(parts):
+        p1 = 2 if i == len(parts) - 1 else 1
+        out += bytes([1, 5 + len(part), 0x05, ins, p1, 0, len(part)]) + part
+    return out
+
+
+def write_corpus(target, blobs):
+    corpus_dir = os.path.join(CORPORA_DIR, target)
+    os.makedirs(corpus_dir, exist_ok=True)
+    for blob in blobs:
+        name = 'seed-' + hashlib.sha1(blob).hexdigest()
+        with open(os.path.join(corpus_dir, name), 'wb') as out:
+            out.write(blob)
+    print(f'{len(blobs)} seeds written to {corpus_dir}')
+
+
+def main(targets):
+    consensus = read_consensus_blobs()
+    runtime = read_runtime_blobs()
+    eth = read_eth_blobs()
+
+    seeds = {
+        'parser_parse': consensus + runtime,
+        'parser_eth': eth,
+        'parser_inspect': [bytes([len(INSPECT_NAVIGATION)]) + INSPECT_NAVIGATION + b for b in runtime],
+        'apdu_chunks': [oasis_chunks(b) for b in consensus + runtime] + [eth_chunks(b) for b in eth],
+        'apdu_handler': [apdus(0x02, b) for b in consensus] + [apdus(0x05, b) for b in runtime],
+    }
+
+    for target in targets or seeds.keys():
+        if target in seeds:
+            write_corpus(target, seeds[target])
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
@@ -0,0 +1,136 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+#include "parser.h"
+
+
+#ifdef NDEBUG
+#error "This fuzz target won't work correctly with NDEBUG defined, which will cause asserts to be eliminated"
+#endif
+
+
+using std::size_t;
+
+static char PARSER_KEY[16384];
+static char PARSER_VALUE[16384];
+
+// Input layout: [n][n navigation bytes][runtime blob]
+//
+// The runtime blob is parsed as usual. Every item that can be inspected (the
+// contracts "Data" field) is then walked the way the UI does it, with each
+// navigation byte choosing between entering a nested item, printing an item
+// at the current level or going back up one level.
+
+enum nav_op_e {
+    nav_enter = 0,
+    nav_print = 1,
+    nav_back = 2,
+};
+
+static void navigate(const uint8_t *ops, size_t opsLen)
+{
+    uint8_t trace[MAX_DEPTH] = {0};
+    uint8_t depth = 0;
+    uint8_t num_items = 0;
+
+    parser_init_innerNumItems();
+    if (parser_getInnerField(depth, trace) != parser_ok) {
+        return;
+    }
+
+    for (size_t i = 0; i + 1 < opsLen; i += 2) {
+        const uint8_t op = ops[i] % 3;
+        const uint8_t arg = ops[i + 1];
+
+        if (parser_getInnerNumItems(&num_items) != parser_ok || num_items == 0) {
+            return;
+        }
+        const uint8_t idx = arg % num_items;
+
+        switch (op) {
+            case nav_enter:
+                if (depth + 1 >= MAX_DEPTH || !parser_canInspectItem(depth + 1, trace, idx)) {
+                    break;
+                }
+                depth++;
+                trace[depth] = idx;
+                break;
+            case nav_print: {
+                uint8_t page_count = 0;
+                ui_field_t field = {};
+                field.displayIdx = idx;
+                field.outKey = PARSER_KEY;
+                field.outKeyLen = sizeof(PARSER_KEY);
+                field.outVal = PARSER_VALUE;
+                field.outValLen = sizeof(PARSER_VALUE);
+                field.pageIdx = arg >> 6;
+                field.pageCount = &page_count;
+                parser_printInnerField(&field);
+                break;
+            }
+            default:
+                if (depth > 0) {
+                    trace[depth] = 0;
+                    depth--;
+                }
+                break;
+        }
+
+        // printInnerField consumes the level iterator, re-enter every round
+        if (parser_getInnerField(depth, trace) != parser_ok) {
+            return;
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < 1 || (size_t)data[0] + 1 > size) {
+        return 0;
+    }
+    const uint8_t *ops = data + 1;
+    const size_t opsLen = data[0];
+    data += 1 + opsLen;
+    size -= 1 + opsLen;
+
+    parser_context_t ctx = {};
+    ctx.tx_type = oasis_tx;
+    parser_error_t rc;
+
+    rc = parser_parse(&ctx, data, size);
+    if (rc != parser_ok) {
+        return 0;
+    }
+
+    rc = parser_validate(&ctx);
+    if (rc != parser_ok) {
+        return 0;
+    }
+
+    uint8_t num_items;
+    rc = parser_getNumItems(&ctx, &num_items);
+    if (rc != parser_ok) {
+        fprintf(stderr,
+                "error in parser_getNumItems: %s\n",
+                parser_getErrorDescription(rc));
+        assert(false);
+    }
+
+    for (uint8_t i = 0; i < num_items; i += 1) {
+        uint8_t page_count = 1;
+        rc = parser_getItem(&ctx, i,
+                            PARSER_KEY, sizeof(PARSER_KEY),
+                            PARSER_VALUE, sizeof(PARSER_VALUE),
+                            0, &page_count);
+        assert(rc == parser_ok);
+
+        // Only true right after the data field has been displayed
+        const uint8_t trace[MAX_DEPTH] = {0};
+        if (parser_canInspectItem(0, trace, 0)) {
+            navigate(ops, opsLen);
+        }
+    }
+
+    return 0;
+}
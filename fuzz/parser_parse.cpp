@@ -1,7 +1,13 @@
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
 
+#include "coin.h"
 #include "parser.h"
 
 
@@ -15,9 +21,545 @@ using std::size_t;
 static char PARSER_KEY[16384];
 static char PARSER_VALUE[16384];
 
+extern "C" size_t LLVMFuzzerMutate(uint8_t *data, size_t size, size_t max_size);
+
+////////////////////////////////////////////////////////////////////////////////
+// Structure-aware mutator
+//
+// Blobs handed to parser_parse come in two shapes:
+//   consensus: [context length][context][CBOR body]
+//   runtime:   [CBOR meta map {chain_context, runtime_id, orig_to?}][CBOR body]
+//
+// Byte-level mutations almost always break the context prefix or the CBOR
+// framing, so the input is decoded into an item tree, mutated at item level
+// and re-encoded canonically (RFC 7049 3.9 key order, shortest heads), which
+// is what the Oasis signers produce. Inputs that cannot be decoded fall back
+// to the default libFuzzer mutator.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+constexpr size_t MUTATOR_MAX_DEPTH = 16;
+constexpr size_t MUTATOR_MAX_ITEMS = 512;
+
+constexpr uint8_t CBOR_UINT = 0;
+constexpr uint8_t CBOR_NINT = 1;
+constexpr uint8_t CBOR_BYTES = 2;
+constexpr uint8_t CBOR_TEXT = 3;
+constexpr uint8_t CBOR_ARRAY = 4;
+constexpr uint8_t CBOR_MAP = 5;
+constexpr uint8_t CBOR_SIMPLE = 7;
+
+const char *const CONTEXT_PREFIXES[] = {
+    "oasis-core/consensus: tx for chain ",
+    "oasis-core/registry: register entity",
+    "oasis-core/registry: register node",
+    "oasis-core/tendermint",
+    "oasis-metadata-registry: entity",
+};
+
+const char *const CHAIN_CONTEXTS[] = {
+    MAINNET_GENESIS_HASH,
+    TESTNET_GENESIS_HASH,
+};
+
+const char *const RUNTIME_IDS[] = {
+    CIPHER_MAIN_RUNID,   CIPHER_TEST_RUNID,   EMERALD_MAIN_RUNID,
+    EMERALD_TEST_RUNID,  SAPPHIRE_MAIN_RUNID, SAPPHIRE_TEST_RUNID,
+};
+
+const char *const METHODS[] = {
+    "staking.Transfer",
+    "staking.Burn",
+    "staking.Withdraw",
+    "staking.Allow",
+    "staking.AddEscrow",
+    "staking.ReclaimEscrow",
+    "staking.AmendCommissionSchedule",
+    "registry.DeregisterEntity",
+    "registry.UnfreezeNode",
+    "registry.RegisterEntity",
+    "governance.CastVote",
+    "governance.SubmitProposal",
+    "accounts.Transfer",
+    "consensus.Deposit",
+    "consensus.Withdraw",
+    "consensus.Delegate",
+    "consensus.Undelegate",
+    "contracts.Call",
+    "contracts.Instantiate",
+    "contracts.Upgrade",
+    "evm.Call",
+};
+
+const char *const KEYS[] = {
+    "v",         "ai",          "si",           "id",          "to",          "pk",
+    "fee",       "gas",         "url",          "call",        "body",        "data",
+    "from",      "name",        "rate",        "vote",        "epoch",       "nodes",
+    "nonce",     "email",       "major",        "minor",       "patch",       "rates",
+    "start",     "value",       "shares",       "amount",      "bounds",      "format",
+    "method",    "serial",      "target",       "tokens",      "address",     "code_id",
+    "handler",   "keybase",     "twitter",      "account",     "node_id",     "orig_to",
+    "upgrade",   "rate_max",    "rate_min",     "negative",    "amendment",   "signature",
+    "allowance", "public_key",  "runtime_id",   "proposal_id", "beneficiary", "address_spec",
+    "burn_tokens", "xfer_tokens", "amount_change", "chain_context", "escrow_tokens",
+    "cancel_upgrade", "reclaim_shares", "consensus_messages", "untrusted_raw_value",
+    "allow_entity_signed_nodes",
+};
+
+const uint64_t INTERESTING_UINTS[] = {
+    0, 1, 2, 3, 23, 24, 255, 256, 65535, 65536, 0xFFFFFFFFull, 0x100000000ull, 0x7FFFFFFFFFFFFFFFull,
+    0xFFFFFFFFFFFFFFFFull,
+};
+
+const size_t INTERESTING_LENGTHS[] = {0, 1, 2, 20, 21, 31, 32, 33, 40, 42, 50, 64, 65, 128, 255, 256};
+
+struct CborItem {
+    uint8_t major = CBOR_UINT;
+    uint64_t value = 0;              // integer, simple value or container length
+    std::string bytes;               // byte / text string payload
+    std::vector<CborItem> children;  // array elements, or map keys and values interleaved
+};
+
+struct TxInput {
+    bool runtime = false;
+    std::string context;  // consensus only
+    CborItem meta;        // runtime only
+    CborItem body;
+};
+
+using Rng = std::minstd_rand;
+
+template <typename T, size_t N>
+const T &pick(Rng &rng, const T (&arr)[N]) {
+    return arr[rng() % N];
+}
+
+class CborReader {
+   public:
+    CborReader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+    bool read(CborItem *item, size_t depth = 0) {
+        if (depth > MUTATOR_MAX_DEPTH || offset_ >= size_ || ++items_ > MUTATOR_MAX_ITEMS) {
+            return false;
+        }
+        const uint8_t head = data_[offset_++];
+        item->major = head >> 5;
+        const uint8_t info = head & 0x1F;
+
+        if (item->major == CBOR_SIMPLE) {
+            // Floats and indefinite breaks are not used by Oasis transactions
+            if (info >= 24) {
+                return false;
+            }
+            item->value = info;
+            return true;
+        }
+
+        if (!readArgument(info, &item->value)) {
+            return false;
+        }
+
+        switch (item->major) {
+            case CBOR_BYTES:
+            case CBOR_TEXT:
+                if (item->value > size_ - offset_) {
+                    return false;
+                }
+                item->bytes.assign(reinterpret_cast<const char *>(data_ + offset_), item->value);
+                offset_ += item->value;
+                return true;
+            case CBOR_ARRAY:
+            case CBOR_MAP: {
+                if (item->value > size_ - offset_) {
+                    return false;
+                }
+                const uint64_t count = item->major == CBOR_MAP ? item->value * 2 : item->value;
+                if (count > size_ - offset_) {
+                    return false;
+                }
+                item->children.resize(count);
+                for (auto &child : item->children) {
+                    if (!read(&child, depth + 1)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            case 6:
+                // Tags are not used by Oasis transactions
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    size_t offset() const { return offset_; }
+
+   private:
+    bool readArgument(uint8_t info, uint64_t *out) {
+        if (info < 24) {
+            *out = info;
+            return true;
+        }
+        if (info > 27) {
+            return false;
+        }
+        const size_t len = 1u << (info - 24);
+        if (len > size_ - offset_) {
+            return false;
+        }
+        *out = 0;
+        for (size_t i = 0; i < len; i++) {
+            *out = (*out << 8) | data_[offset_++];
+        }
+        return true;
+    }
+
+    const uint8_t *data_;
+    size_t size_;
+    size_t offset_ = 0;
+    size_t items_ = 0;
+};
+
+void writeHead(std::string *out, uint8_t major, uint64_t value) {
+    const uint8_t type = major << 5;
+    if (value < 24) {
+        out->push_back(static_cast<char>(type | value));
+        return;
+    }
+    size_t len = 8;
+    uint8_t info = 27;
+    if (value <= 0xFF) {
+        len = 1;
+        info = 24;
+    } else if (value <= 0xFFFF) {
+        len = 2;
+        info = 25;
+    } else if (value <= 0xFFFFFFFF) {
+        len = 4;
+        info = 26;
+    }
+    out->push_back(static_cast<char>(type | info));
+    for (size_t i = len; i > 0; i--) {
+        out->push_back(static_cast<char>((value >> (8 * (i - 1))) & 0xFF));
+    }
+}
+
+void encode(const CborItem &item, std::string *out) {
+    switch (item.major) {
+        case CBOR_BYTES:
+        case CBOR_TEXT:
+            writeHead(out, item.major, item.bytes.size());
+            out->append(item.bytes);
+            return;
+        case CBOR_ARRAY:
+            writeHead(out, item.major, item.children.size());
+            for (const auto &child : item.children) {
+                encode(child, out);
+            }
+            return;
+        case CBOR_MAP: {
+            // Canonical order: shorter encoded keys first, then bytewise
+            std::vector<std::pair<std::string, std::string>> entries;
+            for (size_t i = 0; i + 1 < item.children.size(); i += 2) {
+                std::pair<std::string, std::string> entry;
+                encode(item.children[i], &entry.first);
+                encode(item.children[i + 1], &entry.second);
+                entries.push_back(std::move(entry));
+            }
+            std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+                if (a.first.size() != b.first.size()) {
+                    return a.first.size() < b.first.size();
+                }
+                return a.first < b.first;
+            });
+            writeHead(out, item.major, entries.size());
+            for (const auto &entry : entries) {
+                out->append(entry.first);
+                out->append(entry.second);
+            }
+            return;
+        }
+        default:
+            writeHead(out, item.major, item.value);
+            return;
+    }
+}
+
+CborItem textItem(const std::string &s) {
+    CborItem item;
+    item.major = CBOR_TEXT;
+    item.bytes = s;
+    return item;
+}
+
+bool decodeInput(const uint8_t *data, size_t size, TxInput *input) {
+    if (size == 0) {
+        return false;
+    }
+
+    size_t bodyOffset = 0;
+    if ((data[0] >> 5) == CBOR_MAP) {
+        CborReader reader(data, size);
+        if (!reader.read(&input->meta)) {
+            return false;
+        }
+        input->runtime = true;
+        bodyOffset = reader.offset();
+    } else {
+        const size_t contextLen = data[0];
+        if (1 + contextLen > size) {
+            return false;
+        }
+        input->context.assign(reinterpret_cast<const char *>(data + 1), contextLen);
+        bodyOffset = 1 + contextLen;
+    }
+
+    CborReader reader(data + bodyOffset, size - bodyOffset);
+    return reader.read(&input->body);
+}
+
+std::string encodeInput(const TxInput &input) {
+    std::string out;
+    if (input.runtime) {
+        encode(input.meta, &out);
+    } else {
+        out.push_back(static_cast<char>(std::min<size_t>(input.context.size(), 255)));
+        out.append(input.context, 0, 255);
+    }
+    encode(input.body, &out);
+    return out;
+}
+
+std::string randomHex(Rng &rng, size_t len) {
+    static const char HEX[] = "0123456789abcdef";
+    std::string s(len, '0');
+    for (auto &c : s) {
+        c = HEX[rng() % 16];
+    }
+    return s;
+}
+
+void mutateContext(Rng &rng, TxInput *input) {
+    if (input->runtime) {
+        CborItem meta;
+        meta.major = CBOR_MAP;
+        meta.children.push_back(textItem("chain_context"));
+        meta.children.push_back(textItem(rng() % 4 ? pick(rng, CHAIN_CONTEXTS) : randomHex(rng, 64)));
+        meta.children.push_back(textItem("runtime_id"));
+        meta.children.push_back(textItem(rng() % 4 ? pick(rng, RUNTIME_IDS) : randomHex(rng, 64)));
+        if (rng() % 2) {
+            meta.children.push_back(textItem("orig_to"));
+            meta.children.push_back(textItem((rng() % 2 ? "0x" : "") + randomHex(rng, ORIG_TO_SIZE - 2)));
+        }
+        input->meta = std::move(meta);
+        return;
+    }
+
+    const std::string prefix = pick(rng, CONTEXT_PREFIXES);
+    switch (rng() % 3) {
+        case 0:
+            input->context = prefix + pick(rng, CHAIN_CONTEXTS);
+            break;
+        case 1:
+            input->context = prefix + randomHex(rng, 64);
+            break;
+        default:
+            input->context = prefix;
+            break;
+    }
+}
+
+void collect(CborItem *item, std::vector<CborItem *> *out) {
+    out->push_back(item);
+    for (auto &child : item->children) {
+        collect(&child, out);
+    }
+}
+
+CborItem randomScalar(Rng &rng) {
+    CborItem item;
+    switch (rng() % 6) {
+        case 0:
+            item.major = CBOR_UINT;
+            item.value = pick(rng, INTERESTING_UINTS);
+            break;
+        case 1:
+            item.major = CBOR_NINT;
+            item.value = pick(rng, INTERESTING_UINTS);
+            break;
+        case 2:
+            item.major = CBOR_BYTES;
+            item.bytes.assign(pick(rng, INTERESTING_LENGTHS), static_cast<char>(rng()));
+            break;
+        case 3:
+            item = textItem(pick(rng, METHODS));
+            break;
+        case 4:
+            item = textItem(pick(rng, KEYS));
+            break;
+        default:
+            item.major = CBOR_SIMPLE;
+            item.value = 20 + rng() % 3;  // false, true, null
+            break;
+    }
+    return item;
+}
+
+void mutateString(Rng &rng, CborItem *item) {
+    switch (rng() % 4) {
+        case 0:
+            item->bytes.resize(pick(rng, INTERESTING_LENGTHS), static_cast<char>(rng()));
+            break;
+        case 1:
+            if (item->major == CBOR_TEXT) {
+                item->bytes = item->bytes.find('.') != std::string::npos ? pick(rng, METHODS) : pick(rng, KEYS);
+                break;
+            }
+            // fall through
+        default: {
+            std::vector<uint8_t> tmp(item->bytes.begin(), item->bytes.end());
+            const size_t maxSize = tmp.size() + 16;
+            tmp.resize(maxSize);
+            tmp.resize(LLVMFuzzerMutate(tmp.data(), item->bytes.size(), maxSize));
+            item->bytes.assign(tmp.begin(), tmp.end());
+            break;
+        }
+    }
+}
+
+void mutateContainer(Rng &rng, CborItem *item) {
+    const size_t stride = item->major == CBOR_MAP ? 2 : 1;
+    const size_t entries = item->children.size() / stride;
+
+    switch (rng() % 4) {
+        case 0:
+            // Drop an entry
+            if (entries > 0) {
+                const size_t idx = (rng() % entries) * stride;
+                item->children.erase(item->children.begin() + idx, item->children.begin() + idx + stride);
+            }
+            break;
+        case 1:
+            // Duplicate an entry
+            if (entries > 0) {
+                const size_t idx = (rng() % entries) * stride;
+                std::vector<CborItem> copy(item->children.begin() + idx, item->children.begin() + idx + stride);
+                item->children.insert(item->children.end(), copy.begin(), copy.end());
+            }
+            break;
+        case 2:
+            // Rename a map key
+            if (stride == 2 && entries > 0) {
+                item->children[(rng() % entries) * 2] = textItem(pick(rng, KEYS));
+                break;
+            }
+            // fall through
+        default:
+            // Insert a new entry
+            if (stride == 2) {
+                item->children.push_back(textItem(pick(rng, KEYS)));
+            }
+            item->children.push_back(randomScalar(rng));
+            break;
+    }
+}
+
+void mutateBody(Rng &rng, CborItem *body) {
+    std::vector<CborItem *> items;
+    collect(body, &items);
+    CborItem *item = items[rng() % items.size()];
+
+    if (rng() % 8 == 0) {
+        // Change the item type altogether
+        *item = randomScalar(rng);
+        return;
+    }
+
+    switch (item->major) {
+        case CBOR_UINT:
+        case CBOR_NINT:
+            item->value = rng() % 2 ? pick(rng, INTERESTING_UINTS) : item->value + (rng() % 3) - 1;
+            break;
+        case CBOR_BYTES:
+        case CBOR_TEXT:
+            mutateString(rng, item);
+            break;
+        case CBOR_ARRAY:
+        case CBOR_MAP:
+            mutateContainer(rng, item);
+            break;
+        default:
+            item->value = 20 + rng() % 3;
+            break;
+    }
+}
+
+size_t writeOutput(const std::string &encoded, uint8_t *data, size_t max_size) {
+    if (encoded.empty() || encoded.size() > max_size) {
+        return 0;
+    }
+    memcpy(data, encoded.data(), encoded.size());
+    return encoded.size();
+}
+
+}  // namespace
+
+extern "C" size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size, size_t max_size, unsigned int seed)
+{
+    Rng rng(seed);
+    TxInput input;
+
+    if (!decodeInput(data, size, &input) || rng() % 16 == 0) {
+        return LLVMFuzzerMutate(data, size, max_size);
+    }
+
+    const size_t rounds = 1 + rng() % 3;
+    for (size_t i = 0; i < rounds; i++) {
+        if (rng() % 8 == 0) {
+            mutateContext(rng, &input);
+        } else {
+            mutateBody(rng, &input.body);
+        }
+    }
+
+    const size_t written = writeOutput(encodeInput(input), data, max_size);
+    return written != 0 ? written : LLVMFuzzerMutate(data, size, max_size);
+}
+
+extern "C" size_t LLVMFuzzerCustomCrossOver(const uint8_t *data1, size_t size1,
+                                            const uint8_t *data2, size_t size2,
+                                            uint8_t *out, size_t max_out_size,
+                                            unsigned int seed)
+{
+    Rng rng(seed);
+    TxInput first;
+    TxInput second;
+
+    if (!decodeInput(data1, size1, &first) || !decodeInput(data2, size2, &second)) {
+        return 0;
+    }
+
+    if (rng() % 2) {
+        // Keep the context of the first input, take the body of the second
+        first.body = second.body;
+    } else {
+        // Graft a subtree of the second body into the first one
+        std::vector<CborItem *> dst;
+        std::vector<CborItem *> src;
+        collect(&first.body, &dst);
+        collect(&second.body, &src);
+        *dst[rng() % dst.size()] = *src[rng() % src.size()];
+    }
+
+    return writeOutput(encodeInput(first), out, max_out_size);
+}
+
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
 {
-    parser_context_t ctx;
+    parser_context_t ctx = {};
+    ctx.tx_type = oasis_tx;
     parser_error_t rc;
 
     rc = parser_parse(&ctx, data, size);
@@ -1,41 +1,88 @@
 #!/usr/bin/env python3
 
+import argparse
+import hashlib
 import os
-import random
+import re
 import shlex
 import subprocess
 
-MAX_SECONDS_PER_RUN = 600
-MUTATE_DEPTH = random.randint(1, 20)
+from fuzz_common import artifact_dir, fuzz_path, sanitizer_env, select_configs
 
-# (fuzzer name, max length, max time scale factor)
-CONFIGS = [
-    ('parser_parse', 17000, 4),
-]
+# Frames considered when bucketing crashes
+STACK_DEPTH = 5
 
-for config in CONFIGS:
-    fuzzer, max_len, scale_factor = config
-    max_time = MAX_SECONDS_PER_RUN * scale_factor
-    print(f'######## {fuzzer} ########')
+# "    #3 0x55d0c1 in _readRuntimeFee /src/app/src/consumer/parser_impl_con.c:1234:5"
+FRAME_RE = re.compile(r'^\s*#(\d+) 0x[0-9a-f]+ in (.+?)(?: (\S+:\d+(?::\d+)?|\(\S+\)))?$')
+IGNORED_FRAMES = ('__asan', '__ubsan', '__sanitizer', 'fuzzer::', 'LLVMFuzzer', 'libc', '__libc', 'abort',
+                  'raise', '__assert')
 
-    artifact_dir = os.path.join('fuzz', 'corpora', f'{fuzzer}-artifacts')
-    corpus_dir = os.path.join('fuzz', 'corpora', f'{fuzzer}')
-    fuzz_path = os.path.join(f'build/bin/fuzz-{fuzzer}')
 
-    os.makedirs(artifact_dir, exist_ok=True)
-    os.makedirs(corpus_dir, exist_ok=True)
+def stack_signature(output):
+    """Returns a signature of the top application frames of the first report"""
+    frames = []
+    for line in output.splitlines():
+        m = FRAME_RE.match(line)
+        if m is None:
+            if frames:
+                break
+            continue
+        function, location = m.group(2), m.group(3) or ''
+        if function.startswith(IGNORED_FRAMES):
+            continue
+        # drop column numbers so trivial rebuilds do not split buckets
+        location = re.sub(r':\d+$', '', os.path.basename(location))
+        frames.append(f'{function} {location}')
+        if len(frames) == STACK_DEPTH:
+            break
 
-    env = os.environ.copy()
-    env['ASAN_OPTIONS'] = 'halt_on_error=1:print_stacktrace=1'
-    env['UBSAN_OPTIONS'] = 'halt_on_error=1:print_stacktrace=1'
+    kind = re.search(r'(ERROR: \w+Sanitizer: [\w-]+|runtime error: [^:\n]+|Assertion .* failed)', output)
+    header = re.sub(r'0x[0-9a-f]+', '', kind.group(1)) if kind else 'unknown'
+    return header, frames
 
-    crash_files = os.listdir(artifact_dir)
-    for c in crash_files:
-        c_full_path = os.path.join(artifact_dir, c)
-        cmd = [fuzz_path, f'{c_full_path}']
-        print(' '.join(shlex.quote(c) for c in cmd))
-        error_code = subprocess.call(cmd, env=env)
-        if error_code != 0:
-            exit(error_code)
 
+def main():
+    parser = argparse.ArgumentParser(description='Reproduce fuzzer artifacts and group them by stack')
+    parser.add_argument('targets', nargs='*', help='fuzz targets to check (default: all)')
+    parser.add_argument('--build-dir', default='build', help='build directory containing bin/fuzz-*')
+    args = parser.parse_args()
 
+    env = sanitizer_env()
+    buckets = {}
+
+    for fuzzer, _, _ in select_configs(args.targets):
+        print(f'######## {fuzzer} ########')
+        artifacts = artifact_dir(fuzzer)
+        if not os.path.isdir(artifacts):
+            continue
+
+        for c in sorted(os.listdir(artifacts)):
+            c_full_path = os.path.join(artifacts, c)
+            if not os.path.isfile(c_full_path):
+                continue
+            cmd = [fuzz_path(args.build_dir, fuzzer), c_full_path]
+            print(' '.join(shlex.quote(c) for c in cmd))
+            result = subprocess.run(cmd, env=env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                    universal_newlines=True, errors='replace')
+            if result.returncode == 0:
+                continue
+
+            header, frames = stack_signature(result.stdout)
+            key = hashlib.sha1('\n'.join([fuzzer, header] + frames).encode()).hexdigest()[:12]
+            bucket = buckets.setdefault(key, {'fuzzer': fuzzer, 'header': header, 'frames': frames, 'inputs': []})
+            bucket['inputs'].append(c_full_path)
+            if len(bucket['inputs']) == 1:
+                print(result.stdout)
+
+    print(f'######## {len(buckets)} unique crashes ########')
+    for key, bucket in buckets.items():
+        print(f'[{key}] {bucket["fuzzer"]}: {bucket["header"]} ({len(bucket["inputs"])} inputs)')
+        for frame in bucket['frames']:
+            print(f'    {frame}')
+        print(f'    reproducer: {bucket["inputs"][0]}')
+
+    exit(1 if buckets else 0)
+
+
+if __name__ == '__main__':
+    main()
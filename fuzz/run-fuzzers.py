@@ -1,39 +1,85 @@
 #!/usr/bin/env python3
 
+import argparse
 import os
 import random
 import shlex
+import shutil
 import subprocess
+import tempfile
+
+from fuzz_common import (artifact_dir, corpus_dir, dict_path, fuzz_path, prepare_dirs, sanitizer_env,
+                         select_configs)
 
 MAX_SECONDS_PER_RUN = 600
 MUTATE_DEPTH = random.randint(1, 20)
 
-# (fuzzer name, max length, max time scale factor)
-CONFIGS = [
-    ('parser_parse', 17000, 4),
-]
 
-for config in CONFIGS:
+def run(cmd, env=None):
+    print(' '.join(shlex.quote(c) for c in cmd), flush=True)
+    return subprocess.call(cmd, env=env)
+
+
+def minimize_corpus(binary, fuzzer, max_len, env):
+    """Merge the corpus into a fresh directory keeping only inputs that add coverage"""
+    corpus = corpus_dir(fuzzer)
+    before = len(os.listdir(corpus))
+
+    merged = tempfile.mkdtemp(prefix=f'{fuzzer}-merge-', dir=os.path.dirname(corpus))
+    rc = run([binary, '-merge=1', f'-max_len={max_len}', f'-artifact_prefix={artifact_dir(fuzzer)}/', merged, corpus],
+             env)
+    if rc != 0 or not os.listdir(merged):
+        shutil.rmtree(merged, ignore_errors=True)
+        return
+
+    shutil.rmtree(corpus)
+    os.rename(merged, corpus)
+    print(f'{fuzzer}: corpus minimized {before} -> {len(os.listdir(corpus))} inputs', flush=True)
+
+
+def fuzz(args, config):
     fuzzer, max_len, scale_factor = config
-    max_time = MAX_SECONDS_PER_RUN * scale_factor
-    print(f'######## {fuzzer} ########')
-
-    artifact_dir = os.path.join('fuzz', 'corpora', f'{fuzzer}-artifacts')
-    corpus_dir = os.path.join('fuzz', 'corpora', f'{fuzzer}')
-    fuzz_path = os.path.join(f'build/bin/fuzz-{fuzzer}')
-
-    os.makedirs(artifact_dir, exist_ok=True)
-    os.makedirs(corpus_dir, exist_ok=True)
-
-    env = os.environ.copy()
-    env['ASAN_OPTIONS'] = 'halt_on_error=1:print_stacktrace=1'
-    env['UBSAN_OPTIONS'] = 'halt_on_error=1:print_stacktrace=1'
-
-    cmd = [fuzz_path, f'-max_total_time={max_time}',
-           f'-jobs=16'
-           f'-max_len={max_len}',
-           f'-mutate_depth={MUTATE_DEPTH}',
-           f'-artifact_prefix={artifact_dir}/',
-           corpus_dir]
-    print(' '.join(shlex.quote(c) for c in cmd))
-    subprocess.call(cmd, env=env)
+    max_time = int(MAX_SECONDS_PER_RUN * scale_factor * args.time_scale)
+    print(f'######## {fuzzer} ########', flush=True)
+
+    binary = fuzz_path(args.build_dir, fuzzer)
+    prepare_dirs(fuzzer)
+    env = sanitizer_env()
+
+    # Every round uses all workers on the shared corpus, then the corpus is merged
+    # so the next round (and the other build servers) start from a minimal set.
+    elapsed = 0
+    while elapsed < max_time:
+        round_time = min(args.merge_interval, max_time - elapsed)
+        cmd = [binary,
+               f'-max_total_time={round_time}',
+               f'-jobs={args.jobs}',
+               f'-workers={args.jobs}',
+               f'-max_len={max_len}',
+               f'-mutate_depth={MUTATE_DEPTH}',
+               f'-artifact_prefix={artifact_dir(fuzzer)}/',
+               corpus_dir(fuzzer)]
+        if os.path.exists(dict_path(fuzzer)):
+            cmd.insert(-1, f'-dict={dict_path(fuzzer)}')
+        run(cmd, env)
+        elapsed += round_time
+
+        minimize_corpus(binary, fuzzer, max_len, env)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Run all fuzz targets in parallel on every core')
+    parser.add_argument('targets', nargs='*', help='fuzz targets to run (default: all)')
+    parser.add_argument('--build-dir', default='build', help='build directory containing bin/fuzz-*')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count(), help='libFuzzer jobs and workers per target')
+    parser.add_argument('--merge-interval', type=int, default=MAX_SECONDS_PER_RUN,
+                        help='seconds between corpus merges')
+    parser.add_argument('--time-scale', type=float, default=1.0, help='multiplier for the per-target fuzzing time')
+    args = parser.parse_args()
+
+    for config in select_configs(args.targets):
+        fuzz(args, config)
+
+
+if __name__ == '__main__':
+    main()
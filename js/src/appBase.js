@@ -2,6 +2,7 @@ import bech32 from "bech32";
 import Eth from '@ledgerhq/hw-app-eth'
 import { LedgerEthTransactionResolution, LoadConfig } from '@ledgerhq/hw-app-eth/lib/services/types'
 import {
+  ADDRESS_KIND,
   CHUNK_SIZE,
   DEFAULT_HRP,
   errorCodeToString,
@@ -9,9 +10,11 @@ import {
   P1_VALUES, PAYLOAD_TYPE,
   processErrorResponse,
   publicKeyv1,
+  TRACE_STAGES,
 } from "./common";
 
 const HARDENED = 0x80000000;
+const SIGNATURE_SIZE = 64;
 
 function processGetAddrEd25519Response(response) {
   const errorCodeData = response.slice(-2);
@@ -150,57 +153,68 @@ export class OasisAppBase {
     throw new Error("Path should be a string (e.g \"m/44'/474'/5'/0/3\") or an Array (e.g \"m/44'/474'/5'/0'/3'\")");
   }
 
-  static prepareChunks(serializedPathBuffer, context, message) {
-    const chunks = [];
+  // Lays out the whole payload once in a single buffer, every chunk is a view into it
+  static serializeChunks(serializedPathBuffer, header, message) {
+    const parts = [serializedPathBuffer, header, message].map((part) =>
+      typeof part === "string" ? Buffer.from(part) : part,
+    );
+    const buffer = Buffer.alloc(parts.reduce((total, part) => total + part.length, 0));
+
+    let offset = 0;
+    parts.forEach((part) => {
+      buffer.set(part, offset);
+      offset += part.length;
+    });
 
     // First chunk (only path)
-    chunks.push(serializedPathBuffer);
+    const chunks = [buffer.subarray(0, serializedPathBuffer.length)];
 
-    const contextSizeBuffer = Buffer.from([context.length]);
-    const contextBuffer = Buffer.from(context);
-    const messageBuffer = Buffer.from(message);
+    // Now split the payload into more chunks
+    for (let i = serializedPathBuffer.length; i < buffer.length; i += CHUNK_SIZE) {
+      chunks.push(buffer.subarray(i, Math.min(i + CHUNK_SIZE, buffer.length)));
+    }
 
+    return chunks;
+  }
+
+  static prepareChunks(serializedPathBuffer, context, message) {
     if (context.length > 255) {
       throw new Error("Maximum supported context size is 255 bytes");
     }
 
-    if (contextSizeBuffer.length > 1) {
-      throw new Error("Context size buffer should be exactly 1 byte");
-    }
-
-    // Now split context length + context + message into more chunks
-    const buffer = Buffer.concat([contextSizeBuffer, contextBuffer, messageBuffer]);
-    for (let i = 0; i < buffer.length; i += CHUNK_SIZE) {
-      let end = i + CHUNK_SIZE;
-      if (i > buffer.length) {
-        end = buffer.length;
-      }
-      chunks.push(buffer.slice(i, end));
-    }
+    const contextBuffer = Buffer.from(context);
+    const header = Buffer.alloc(1 + contextBuffer.length);
+    header[0] = contextBuffer.length;
+    contextBuffer.copy(header, 1);
 
-    return chunks;
+    return OasisAppBase.serializeChunks(serializedPathBuffer, header, message);
   }
 
-    static prepareMetaChunks(serializedPathBuffer, meta, message) {
-    const chunks = [];
-
-    // First chunk (only path)
-    chunks.push(serializedPathBuffer);
+  // Bundle of consensus transactions sharing a context: [count]([length (2 bytes, BE)][cbor])*count
+  static prepareBatchChunks(serializedPathBuffer, context, messages) {
+    if (messages.length === 0 || messages.length > 255) {
+      throw new Error("A batch holds between 1 and 255 transactions");
+    }
 
-    const MetaBuffer = Buffer.from(meta);
-    const messageBuffer = Buffer.from(message);
+    const txs = messages.map((message) => (typeof message === "string" ? Buffer.from(message) : message));
+    const bundle = Buffer.alloc(1 + txs.reduce((total, tx) => total + 2 + tx.length, 0));
+    bundle[0] = txs.length;
 
-    // Now split context context + message into more chunks
-    const buffer = Buffer.concat([MetaBuffer, messageBuffer]);
-    for (let i = 0; i < buffer.length; i += CHUNK_SIZE) {
-      let end = i + CHUNK_SIZE;
-      if (i > buffer.length) {
-        end = buffer.length;
+    let offset = 1;
+    txs.forEach((tx) => {
+      if (tx.length > 0xffff) {
+        throw new Error("Maximum supported transaction size in a batch is 65535 bytes");
       }
-      chunks.push(buffer.slice(i, end));
-    }
+      bundle.writeUInt16BE(tx.length, offset);
+      bundle.set(tx, offset + 2);
+      offset += 2 + tx.length;
+    });
 
-    return chunks;
+    return OasisAppBase.prepareChunks(serializedPathBuffer, context, bundle);
+  }
+
+  static prepareMetaChunks(serializedPathBuffer, meta, message) {
+    return OasisAppBase.serializeChunks(serializedPathBuffer, meta, message);
   }
 
   async signGetChunks(path, context, message, ins) {
@@ -382,6 +396,63 @@ export class OasisAppBase {
       .then(processGetAddrSr25519Response, processErrorResponse);
   }
 
+  // Account discovery without any review. The last path component is the first index, every reply carries as many
+  // accounts as fit and the next request starts from the first index missing
+  async getAddressRange(path, count, kind = ADDRESS_KIND.ED25519, pkOnly = false) {
+    if (count < 1 || count > 255) {
+      throw new Error("Between 1 and 255 accounts can be asked for");
+    }
+    const serializedPath = await this.serializePath(path);
+    const first = serializedPath.readUInt32LE(serializedPath.length - 4);
+    const pkLen = kind === ADDRESS_KIND.SECP256K1 ? 33 : 32;
+
+    const addresses = [];
+    let returnCode = 0x9000;
+    let errorMessage = errorCodeToString(returnCode);
+    while (addresses.length < count) {
+      const data = Buffer.alloc(1 + serializedPath.length);
+      data[0] = count - addresses.length;
+      serializedPath.copy(data, 1);
+      data.writeUInt32LE(first + addresses.length, data.length - 4);
+
+      // eslint-disable-next-line no-await-in-loop
+      const response = await this.transport
+        .send(this.CLA(), INS.GET_ADDR_RANGE, kind, pkOnly ? 1 : 0, data)
+        .then((r) => r, processErrorResponse);
+      if (response.return_code !== undefined) {
+        returnCode = response.return_code;
+        errorMessage = response.error_message;
+        break;
+      }
+      if (response.length <= 3 || response[0] === 0) {
+        returnCode = 0x6f00;
+        errorMessage = errorCodeToString(returnCode);
+        break;
+      }
+
+      let offset = 1;
+      for (let i = 0; i < response[0]; i += 1) {
+        const pk = Buffer.from(response.subarray(offset, offset + pkLen));
+        offset += pkLen;
+        let address = null;
+        if (!pkOnly) {
+          address = Buffer.from(response.subarray(offset + 1, offset + 1 + response[offset])).toString();
+          offset += 1 + response[offset];
+        } else if (kind !== ADDRESS_KIND.SECP256K1) {
+          address = OasisAppBase.getBech32FromPK(pk);
+        }
+        addresses.push({ pk, address });
+      }
+    }
+
+    return {
+      return_code: returnCode,
+      error_message: errorMessage,
+      // ///
+      addresses,
+    };
+  }
+
   async signSendChunk(chunkIdx, chunkNum, chunk, ins) {
     let payloadType = PAYLOAD_TYPE.ADD;
     if (chunkIdx === 1) {
@@ -415,112 +486,127 @@ export class OasisAppBase {
       }, processErrorResponse);
   }
 
+  // Sends all chunks back to back, the device acknowledges intermediate chunks with a bare status word
+  async signSendChunks(chunks, ins) {
+    const now = () => (typeof performance !== "undefined" ? performance.now() : Date.now());
+    const chunkTimings = [];
+
+    let result = {
+      return_code: 0x9000,
+      error_message: errorCodeToString(0x9000),
+      signature: null,
+    };
+
+    for (let i = 0; i < chunks.length; i += 1) {
+      const start = now();
+      // eslint-disable-next-line no-await-in-loop
+      result = await this.signSendChunk(1 + i, chunks.length, chunks[i], ins);
+      chunkTimings.push({ index: i, bytes: chunks[i].length, ms: now() - start });
+
+      if (result.return_code !== 0x9000) {
+        break;
+      }
+    }
+
+    return {
+      return_code: result.return_code,
+      error_message: result.error_message,
+      // ///
+      signature: result.signature,
+      chunk_timings: chunkTimings,
+    };
+  }
+
   async sign(path, context, message) {
     const chunks = await this.signGetChunks(path, context, message, INS.SIGN_ED25519);
+    return this.signSendChunks(chunks, INS.SIGN_ED25519);
+  }
 
-    return this.signSendChunk(1, chunks.length, chunks[0], INS.SIGN_ED25519).then(async (response) => {
-      let result = {
-        return_code: response.return_code,
-        error_message: response.error_message,
-        signature: null,
-      };
+  // The approval reply carries as many signatures as fit, the rest are read back starting at the first missing one
+  async signBatch(path, context, messages) {
+    const serializedPath = await this.serializePath(path);
+    const chunks = OasisAppBase.prepareBatchChunks(serializedPath, context, messages);
+    const result = await this.signSendChunks(chunks, INS.SIGN_BATCH_ED25519);
 
-      for (let i = 1; i < chunks.length; i += 1) {
-        // eslint-disable-next-line no-await-in-loop
-        result = await this.signSendChunk(1 + i, chunks.length, chunks[i], INS.SIGN_ED25519);
-        if (result.return_code !== 0x9000) {
-          break;
-        }
+    const signatures = [];
+    const collect = (data) => {
+      for (let i = 0; i + SIGNATURE_SIZE <= data.length; i += SIGNATURE_SIZE) {
+        signatures.push(Buffer.from(data.subarray(i, i + SIGNATURE_SIZE)));
       }
+    };
 
-      return {
-        return_code: result.return_code,
-        error_message: result.error_message,
-        // ///
-        signature: result.signature,
-      };
-    }, processErrorResponse);
-  }
+    let returnCode = result.return_code;
+    let errorMessage = result.error_message;
+    if (returnCode === 0x9000 && result.signature !== null) {
+      collect(result.signature);
+    }
 
-  async signRtEd25519(path, meta, message) {
-    const chunks = await this.signGetChunks(path, meta, message, INS.SIGN_RT_ED25519);
+    while (returnCode === 0x9000 && signatures.length < messages.length) {
+      // eslint-disable-next-line no-await-in-loop
+      const response = await this.transport
+        .send(this.CLA(), INS.SIGN_BATCH_ED25519, PAYLOAD_TYPE.SIGNATURES, 0, Buffer.from([signatures.length]))
+        .then((r) => r, processErrorResponse);
+      if (response.return_code !== undefined) {
+        returnCode = response.return_code;
+        errorMessage = response.error_message;
+        break;
+      }
+      if (response.length <= 2) {
+        returnCode = 0x6f01;
+        errorMessage = errorCodeToString(returnCode);
+        break;
+      }
+      collect(response.subarray(0, response.length - 2));
+    }
 
-    return this.signSendChunk(1, chunks.length, chunks[0], INS.SIGN_RT_ED25519).then(async (response) => {
-      let result = {
-        return_code: response.return_code,
-        error_message: response.error_message,
-        signature: null,
-      };
+    return {
+      return_code: returnCode,
+      error_message: errorMessage,
+      // ///
+      signatures,
+      chunk_timings: result.chunk_timings,
+    };
+  }
 
-      for (let i = 1; i < chunks.length; i += 1) {
-        // eslint-disable-next-line no-await-in-loop
-        result = await this.signSendChunk(1 + i, chunks.length, chunks[i], INS.SIGN_RT_ED25519);
-        if (result.return_code !== 0x9000) {
-          break;
-        }
+  // Only apps built with APP_TRACE answer, newest trace first; ticks come from the app clock
+  async getTraces(count = 0) {
+    return this.transport.send(this.CLA(), INS.GET_TRACES, count, 0).then((response) => {
+      const errorCodeData = response.slice(-2);
+      const returnCode = errorCodeData[0] * 256 + errorCodeData[1];
+
+      const traces = [];
+      const recordLen = 3 + 4 * TRACE_STAGES.length;
+      for (let i = 0; i < response[0] && 1 + (i + 1) * recordLen <= response.length - 2; i += 1) {
+        const record = response.subarray(1 + i * recordLen, 1 + (i + 1) * recordLen);
+        const ticks = {};
+        TRACE_STAGES.forEach((stage, s) => {
+          ticks[stage] = record.readUInt32BE(3 + 4 * s);
+        });
+        traces.push({ ins: record[0], return_code: record.readUInt16BE(1), ticks });
       }
 
       return {
-        return_code: result.return_code,
-        error_message: result.error_message,
+        return_code: returnCode,
+        error_message: errorCodeToString(returnCode),
         // ///
-        signature: result.signature,
+        traces,
       };
     }, processErrorResponse);
   }
 
+  async signRtEd25519(path, meta, message) {
+    const chunks = await this.signGetChunks(path, meta, message, INS.SIGN_RT_ED25519);
+    return this.signSendChunks(chunks, INS.SIGN_RT_ED25519);
+  }
+
   async signRtSecp256k1(path, meta, message) {
     const chunks = await this.signGetChunks(path, meta, message, INS.SIGN_RT_SECP256K1);
-
-    return this.signSendChunk(1, chunks.length, chunks[0], INS.SIGN_RT_SECP256K1).then(async (response) => {
-      let result = {
-        return_code: response.return_code,
-        error_message: response.error_message,
-        signature: null,
-      };
-
-      for (let i = 1; i < chunks.length; i += 1) {
-        // eslint-disable-next-line no-await-in-loop
-        result = await this.signSendChunk(1 + i, chunks.length, chunks[i], INS.SIGN_RT_SECP256K1);
-        if (result.return_code !== 0x9000) {
-          break;
-        }
-      }
-
-      return {
-        return_code: result.return_code,
-        error_message: result.error_message,
-        // ///
-        signature: result.signature,
-      };
-    }, processErrorResponse);
+    return this.signSendChunks(chunks, INS.SIGN_RT_SECP256K1);
   }
 
   async signRtSr25519(path, meta, message) {
     const chunks = await this.signGetChunks(path, meta, message, INS.SIGN_RT_SR25519);
-
-    return this.signSendChunk(1, chunks.length, chunks[0], INS.SIGN_RT_SR25519).then(async (response) => {
-      let result = {
-        return_code: response.return_code,
-        error_message: response.error_message,
-        signature: null,
-      };
-
-      for (let i = 1; i < chunks.length; i += 1) {
-        // eslint-disable-next-line no-await-in-loop
-        result = await this.signSendChunk(1 + i, chunks.length, chunks[i], INS.SIGN_RT_SR25519);
-        if (result.return_code !== 0x9000) {
-          break;
-        }
-      }
-
-      return {
-        return_code: result.return_code,
-        error_message: result.error_message,
-        // ///
-        signature: result.signature,
-      };
-    }, processErrorResponse);
+    return this.signSendChunks(chunks, INS.SIGN_RT_SR25519);
   }
 
   async signETHTransaction(
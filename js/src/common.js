@@ -9,16 +9,29 @@ export const INS = {
   SIGN_RT_ED25519: 0x05,
   SIGN_RT_SR25519: 0x06,
   SIGN_RT_SECP256K1: 0x07,
+  SIGN_BATCH_ED25519: 0x08,
+  GET_TRACES: 0x09,
+  GET_ADDR_RANGE: 0x0a,
 };
 
 export const DEFAULT_HRP = "oasis";
 
+export const ADDRESS_KIND = {
+  ED25519: 0x00,
+  SECP256K1: 0x01,
+  SR25519: 0x02,
+};
+
 export const PAYLOAD_TYPE = {
   INIT: 0x00,
   ADD: 0x01,
   LAST: 0x02,
+  SIGNATURES: 0x03,
 };
 
+// Sign path stages in the order the app reports them
+export const TRACE_STAGES = ["parse", "validate", "review", "hash", "derive", "sign"];
+
 export const P1_VALUES = {
   ONLY_RETRIEVE: 0x00,
   SHOW_ADDRESS_IN_DEVICE: 0x01,
@@ -56,3 +56,126 @@ test("Test prepareChunks with context bigger than 255 bytes", async () => {
     expect(e).toEqual(new Error("Maximum supported context size is 255 bytes"));
   }
 });
+
+test("prepareChunks lays out all chunks in a single buffer", async () => {
+  const serializedPath = serializePath([44, 123, 5, 0, 3]);
+  const message = Buffer.alloc(600, 7);
+
+  const chunks = OasisApp.prepareChunks(serializedPath, context, message);
+
+  expect(chunks.map((c) => c.length)).toEqual([serializedPath.length, 250, 250, 1 + context.length + 600 - 500]);
+  chunks.forEach((c) => expect(c.buffer).toBe(chunks[0].buffer));
+  expect(chunks[1][0]).toEqual(context.length);
+});
+
+test("sign sends every chunk and reports their timing", async () => {
+  const sent = [];
+  const transport = {
+    decorateAppAPIMethods() {},
+    async send(cla, ins, p1, p2, data) {
+      sent.push(p1);
+      return p1 === 2 ? Buffer.from([1, 2, 3, 0x90, 0x00]) : Buffer.from([0x90, 0x00]);
+    },
+  };
+  const app = new OasisApp(transport);
+
+  const response = await app.sign("m/44'/474'/0'/0/0", context, Buffer.alloc(600, 7));
+
+  expect(response.return_code).toEqual(0x9000);
+  expect(response.signature).toEqual(Buffer.from([1, 2, 3]));
+  expect(sent).toEqual([0, 1, 1, 2]);
+  expect(response.chunk_timings.map((t) => t.index)).toEqual([0, 1, 2, 3]);
+});
+
+test("signBatch frames the transactions and reads back the remaining signatures", async () => {
+  const count = 5;
+  const sent = [];
+  const transport = {
+    decorateAppAPIMethods() {},
+    async send(cla, ins, p1, p2, data) {
+      sent.push([ins, p1, Buffer.from(data)]);
+      // Two signatures fit in every reply
+      const first = p1 === 3 ? data[0] : 0;
+      if (p1 !== 2 && p1 !== 3) {
+        return Buffer.from([0x90, 0x00]);
+      }
+      const signatures = [];
+      for (let i = first; i < Math.min(count, first + 2); i += 1) {
+        signatures.push(Buffer.alloc(64, i));
+      }
+      return Buffer.concat([...signatures, Buffer.from([0x90, 0x00])]);
+    },
+  };
+  const app = new OasisApp(transport);
+  const messages = Array.from({ length: count }, (_, i) => Buffer.alloc(100, i));
+
+  const response = await app.signBatch("m/44'/474'/0'/0/0", context, messages);
+
+  expect(response.return_code).toEqual(0x9000);
+  expect(response.signatures.map((s) => s[0])).toEqual([0, 1, 2, 3, 4]);
+  expect(sent.every((s) => s[0] === 0x08)).toBe(true);
+  expect(sent.filter((s) => s[1] === 3).map((s) => s[2][0])).toEqual([2, 4]);
+
+  const bundle = Buffer.concat(sent.slice(1).filter((s) => s[1] !== 3).map((s) => s[2]));
+  expect(bundle[1 + context.length]).toEqual(count);
+  expect(bundle.readUInt16BE(2 + context.length)).toEqual(100);
+});
+
+test("getTraces decodes the stage ticks of every record", async () => {
+  const record = (ins, sw, base) => {
+    const out = Buffer.alloc(27);
+    out[0] = ins;
+    out.writeUInt16BE(sw, 1);
+    for (let s = 0; s < 6; s += 1) {
+      out.writeUInt32BE(base + s, 3 + 4 * s);
+    }
+    return out;
+  };
+  const transport = {
+    decorateAppAPIMethods() {},
+    async send(cla, ins, p1) {
+      expect(ins).toEqual(0x09);
+      expect(p1).toEqual(2);
+      return Buffer.concat([Buffer.from([2]), record(0x02, 0x6986, 10), record(0x05, 0x9000, 1000), Buffer.from([0x90, 0x00])]);
+    },
+  };
+  const app = new OasisApp(transport);
+
+  const response = await app.getTraces(2);
+
+  expect(response.return_code).toEqual(0x9000);
+  expect(response.traces.map((t) => [t.ins, t.return_code])).toEqual([
+    [0x02, 0x6986],
+    [0x05, 0x9000],
+  ]);
+  expect(response.traces[1].ticks).toEqual({ parse: 1000, validate: 1001, review: 1002, hash: 1003, derive: 1004, sign: 1005 });
+});
+
+test("getAddressRange asks again from the first index missing", async () => {
+  const firsts = [];
+  const transport = {
+    decorateAppAPIMethods() {},
+    async send(cla, ins, p1, p2, data) {
+      expect(ins).toEqual(0x0a);
+      expect(p1).toEqual(0);
+      // Three accounts fit in every reply
+      const first = data.readUInt32LE(data.length - 4) & 0x7fffffff;
+      firsts.push(first);
+      const n = Math.min(data[0], 3);
+      const entries = [];
+      for (let i = first; i < first + n; i += 1) {
+        const address = Buffer.from(`account${i}`);
+        entries.push(Buffer.alloc(32, i), Buffer.from([address.length]), address);
+      }
+      return Buffer.concat([Buffer.from([n]), ...entries, Buffer.from([0x90, 0x00])]);
+    },
+  };
+  const app = new OasisApp(transport);
+
+  const response = await app.getAddressRange("m/44'/474'/2'", 7);
+
+  expect(response.return_code).toEqual(0x9000);
+  expect(firsts).toEqual([2, 5, 8]);
+  expect(response.addresses.map((a) => a.address)).toEqual([2, 3, 4, 5, 6, 7, 8].map((i) => `account${i}`));
+  expect(response.addresses[6].pk).toEqual(Buffer.alloc(32, 8));
+});
@@ -0,0 +1,197 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include <gmock/gmock.h>
+#include <fmt/core.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "address_batch.h"
+#include "bech32.h"
+#include "crypto.h"
+#include "hexutils.h"
+#include "parser_impl_con.h"
+
+namespace {
+    std::vector<uint8_t> randomBytes(std::mt19937 &rng, size_t len) {
+        std::vector<uint8_t> out(len);
+        for (auto &b : out) {
+            b = rng() & 0xFF;
+        }
+        return out;
+    }
+
+    std::string at(const std::vector<char> &out, size_t i) {
+        return std::string(out.data() + i * ADDRESS_BECH32_STRIDE);
+    }
+
+    // What the app prints for a raw address
+    std::string singleRaw(const uint8_t *raw) {
+        char out[100] = {0};
+        bech32EncodeFromBytes(out, sizeof(out), COIN_HRP, raw, ADDR_RAW, 1, BECH32_ENCODING_BECH32);
+        return out;
+    }
+
+    // And for a public key
+    std::string singlePk(const uint8_t *pk, address_kind_e kind) {
+        char out[100] = {0};
+        crypto_encodeAddress(out, sizeof(out), const_cast<uint8_t *>(pk), kind);
+        return out;
+    }
+}
+
+TEST(AddressBatch, KnownAddresses) {
+    // Keys and addresses reported by the app in the zemu tests
+    const struct {
+        address_kind_e kind;
+        const char *pk;
+        const char *address;
+    } vectors[] = {
+        {addr_ed25519, "45601f761af17dba50243529e629732f1c58d08ffddaa8491238540475729d85",
+         "oasis1qqjkrr643qv7yzem6g4m8rrtceh42n46usfscpcf"},
+        {addr_ed25519, "ad55bbb7c192b8ecfeb6ad18bbd7681c0923f472d5b0c212fbde33008005ad61",
+         "oasis1qqx0wgxjwlw3jwatuwqj6582hdm9rjs4pcnvzz66"},
+        {addr_sr25519, "bcfd51e4c33347fafdae2732998a4f6c103d26f9a58b1773944616129c791316",
+         "oasis1qr9af6sfg3gmv5nefxkq7k7cxpz48r0wlu2j9frf"},
+    };
+
+    for (const auto &v : vectors) {
+        uint8_t pk[PK_LEN_ED25519] = {0};
+        parseHexString(pk, sizeof(pk), v.pk);
+        std::vector<char> out(ADDRESS_BECH32_STRIDE);
+        ASSERT_EQ(address_batch_encode_pk(out.data(), out.size(), pk, 1, v.kind), zxerr_ok);
+        EXPECT_EQ(at(out, 0), v.address);
+    }
+}
+
+TEST(AddressBatch, MatchesTheSingleAddressPath) {
+    std::mt19937 rng(7);
+    // Not a multiple of the lanes, the last group is partial
+    constexpr size_t count = 1003;
+
+    const auto raw = randomBytes(rng, count * ADDR_RAW);
+    std::vector<char> out(count * ADDRESS_BECH32_STRIDE);
+    ASSERT_EQ(address_batch_encode_raw(out.data(), out.size(), raw.data(), count), zxerr_ok);
+    for (size_t i = 0; i < count; i++) {
+        ASSERT_EQ(at(out, i), singleRaw(raw.data() + i * ADDR_RAW)) << i;
+    }
+
+    const auto pks = randomBytes(rng, count * PK_LEN_ED25519);
+    for (const auto kind : {addr_ed25519, addr_sr25519}) {
+        ASSERT_EQ(address_batch_encode_pk(out.data(), out.size(), pks.data(), count, kind), zxerr_ok);
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_EQ(at(out, i), singlePk(pks.data() + i * PK_LEN_ED25519, kind)) << kind << " " << i;
+        }
+    }
+}
+
+TEST(AddressBatch, DecodeRoundTrip) {
+    std::mt19937 rng(11);
+    constexpr size_t count = 100;
+
+    const auto raw = randomBytes(rng, count * ADDR_RAW);
+    std::vector<char> out(count * ADDRESS_BECH32_STRIDE);
+    ASSERT_EQ(address_batch_encode_raw(out.data(), out.size(), raw.data(), count), zxerr_ok);
+
+    std::vector<uint8_t> decoded(count * ADDR_RAW);
+    size_t failed = 0;
+    ASSERT_EQ(address_batch_decode(decoded.data(), decoded.size(), out.data(), count, &failed), zxerr_ok);
+    EXPECT_EQ(failed, count);
+    EXPECT_EQ(decoded, raw);
+
+    // A typo, upper case and another prefix are all rejected at the right index
+    auto bad = out;
+    bad[42 * ADDRESS_BECH32_STRIDE + 20] = bad[42 * ADDRESS_BECH32_STRIDE + 20] == 'q' ? 'p' : 'q';
+    EXPECT_EQ(address_batch_decode(decoded.data(), decoded.size(), bad.data(), count, &failed), zxerr_encoding_failed);
+    EXPECT_EQ(failed, 42u);
+
+    bad = out;
+    for (size_t i = 0; i < ADDRESS_BECH32_LEN; i++) {
+        bad[7 * ADDRESS_BECH32_STRIDE + i] = toupper(bad[7 * ADDRESS_BECH32_STRIDE + i]);
+    }
+    EXPECT_EQ(address_batch_decode(decoded.data(), decoded.size(), bad.data(), count, &failed), zxerr_encoding_failed);
+    EXPECT_EQ(failed, 7u);
+
+    bad = out;
+    bad[0] = 'b';
+    EXPECT_EQ(address_batch_decode(decoded.data(), decoded.size(), bad.data(), count, &failed), zxerr_encoding_failed);
+    EXPECT_EQ(failed, 0u);
+
+    // A valid checksum over a padding bit that is set is still rejected
+    uint8_t one[ADDR_RAW] = {0};
+    EXPECT_EQ(address_batch_decode(one, sizeof(one), "oasis1qqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq0ltrq9", 1, &failed),
+              zxerr_ok);
+    EXPECT_EQ(address_batch_decode(one, sizeof(one), "oasis1qqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqpjflkah", 1, &failed),
+              zxerr_encoding_failed);
+}
+
+TEST(AddressBatch, MapsEthereumAddresses) {
+    // The example of the Oasis docs
+    uint8_t eth[2 * ETH_ADDR_LEN] = {0};
+    parseHexString(eth, ETH_ADDR_LEN, "90adE3B7065fa715c7a150313877dF1d33e777D5");
+
+    uint8_t raw[2 * ADDR_RAW] = {0};
+    ASSERT_EQ(address_batch_map_eth(raw, sizeof(raw), eth, 2), zxerr_ok);
+    char out[2 * ADDRESS_BECH32_STRIDE] = {0};
+    ASSERT_EQ(address_batch_encode_raw(out, sizeof(out), raw, 2), zxerr_ok);
+    EXPECT_STREQ(out, "oasis1qpupfu7e2n6pkezeaw0yhj8mcem8anj64ytrayne");
+
+    // Same as the parser mapping, also for the zero address
+    uint8_t single[ADDR_RAW] = {0};
+    _mapEthToNative(eth + ETH_ADDR_LEN, single);
+    EXPECT_EQ(std::vector<uint8_t>(raw + ADDR_RAW, raw + 2 * ADDR_RAW), std::vector<uint8_t>(single, single + ADDR_RAW));
+    EXPECT_EQ(address_batch_map_eth(raw, sizeof(raw) - 1, eth, 2), zxerr_buffer_too_small);
+}
+
+TEST(AddressBatch, BufferChecks) {
+    uint8_t raw[2 * ADDR_RAW] = {0};
+    char out[2 * ADDRESS_BECH32_STRIDE] = {0};
+    size_t failed = 0;
+
+    EXPECT_EQ(address_batch_encode_raw(out, sizeof(out) - 1, raw, 2), zxerr_buffer_too_small);
+    EXPECT_EQ(address_batch_encode_pk(out, sizeof(out), raw, 1, addr_secp256k1), zxerr_invalid_crypto_settings);
+    ASSERT_EQ(address_batch_encode_raw(out, sizeof(out), raw, 2), zxerr_ok);
+    EXPECT_EQ(address_batch_decode(raw, sizeof(raw) - 1, out, 2, &failed), zxerr_buffer_too_small);
+    EXPECT_EQ(address_batch_encode_raw(nullptr, 0, raw, 0), zxerr_no_data);
+}
+
+TEST(AddressBatch, EncodeBenchmark) {
+    std::mt19937 rng(3);
+    constexpr size_t count = 20000;
+    const auto raw = randomBytes(rng, count * ADDR_RAW);
+    std::vector<char> out(count * ADDRESS_BECH32_STRIDE);
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(address_batch_encode_raw(out.data(), out.size(), raw.data(), count), zxerr_ok);
+    const auto batch = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    char single[100] = {0};
+    for (size_t i = 0; i < count; i++) {
+        bech32EncodeFromBytes(single, sizeof(single), COIN_HRP, raw.data() + i * ADDR_RAW, ADDR_RAW, 1,
+                              BECH32_ENCODING_BECH32);
+    }
+    const auto one = std::chrono::steady_clock::now() - start;
+
+    std::cout << fmt::format("bech32 raw address encoding: batch {:.0f} ns, one by one {:.0f} ns",
+                             std::chrono::duration<double, std::nano>(batch).count() / count,
+                             std::chrono::duration<double, std::nano>(one).count() / count)
+              << std::endl;
+}
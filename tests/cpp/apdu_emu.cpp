@@ -0,0 +1,543 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include <fmt/core.h>
+#include <gmock/gmock.h>
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base64.h"
+#include "crypto.h"
+#include "emu.h"
+#include "key_cache.h"
+#include "trace.h"
+
+extern "C" {
+#include "crypto_helper.h"
+#include "sha512.h"
+}
+
+// End to end runs of the APDU handler on the host emulator, see tests/emu
+namespace {
+    constexpr uint8_t P1_INIT = 0;
+    constexpr uint8_t P1_ADD = 1;
+    constexpr uint8_t P1_LAST = 2;
+    constexpr size_t CHUNK_SIZE = 250;
+
+    constexpr uint16_t SW_OK = 0x9000;
+    constexpr uint16_t SW_DATA_INVALID = 0x6984;
+    constexpr uint16_t SW_COMMAND_NOT_ALLOWED = 0x6986;
+    constexpr uint16_t SW_TX_NOT_INITIALIZED = 0x6987;
+    constexpr uint16_t SW_INVALIDP1P2 = 0x6B00;
+
+    const std::string context =
+        "oasis-core/consensus: tx for chain bc1c715319132305795fa86bd32e93291aaacbfb5b5955f3ba78bdba413af9e1";
+
+    // Escrows of 1 and 3 (x10^12) to two accounts and a reclaim of 1000 shares, all with fee 2000 and gas 1000
+    const std::vector<std::string> txs = {
+        "pGNmZWWiY2dhcxkD6GZhbW91bnRCB9BkYm9keaJmYW1vdW50RejUpRAAZ2FjY291bnRVABERERERERERERERERERERERERERZW5vbmNlAWZtZXRob2Rxc3Rha2luZy5BZGRFc2Nyb3c=",
+        "pGNmZWWiY2dhcxkD6GZhbW91bnRCB9BkYm9keaJmYW1vdW50RgK6fe8wAGdhY2NvdW50VQAiIiIiIiIiIiIiIiIiIiIiIiIiImVub25jZQNmbWV0aG9kcXN0YWtpbmcuQWRkRXNjcm93",
+        "pGNmZWWiY2dhcxkD6GZhbW91bnRCB9BkYm9keaJmc2hhcmVzQgPoZ2FjY291bnRVACIiIiIiIiIiIiIiIiIiIiIiIiIiZW5vbmNlBGZtZXRob2R1c3Rha2luZy5SZWNsYWltRXNjcm93",
+    };
+
+    // m/44'/474'/0'
+    const std::vector<uint32_t> path = {0x8000002c, 0x800001da, 0x80000000};
+
+    std::vector<uint8_t> decode(const std::string &b64) {
+        std::string raw;
+        macaron::Base64::Decode(b64, raw);
+        return std::vector<uint8_t>(raw.begin(), raw.end());
+    }
+
+    std::vector<uint8_t> pathBytes() {
+        std::vector<uint8_t> out;
+        for (auto p : path) {
+            for (int i = 0; i < 4; i++) {
+                out.push_back((p >> (8 * i)) & 0xFF);
+            }
+        }
+        return out;
+    }
+
+    // What the app signs for a consensus transaction: SHA512/256(context || cbor)
+    std::vector<uint8_t> expectedSignature(const std::vector<uint8_t> &cbor) {
+        uint8_t digest[SHA512_DIGEST_LENGTH] = {0};
+        SHA512_256_with_context((const uint8_t *) context.data(), context.size(), cbor.data(), cbor.size(), digest);
+
+        uint8_t signature[64] = {0};
+        emu_crypto_sign(addr_ed25519, digest, 32, signature);
+        return std::vector<uint8_t>(signature, signature + sizeof(signature));
+    }
+
+    struct reply_t {
+        std::vector<uint8_t> data;
+        uint16_t sw = 0;
+    };
+
+    reply_t toReply(const uint8_t *buffer, uint16_t len) {
+        reply_t r;
+        if (len >= 2) {
+            r.data.assign(buffer, buffer + len - 2);
+            r.sw = (buffer[len - 2] << 8) | buffer[len - 1];
+        }
+        return r;
+    }
+
+    class ApduEmu : public ::testing::Test {
+    protected:
+        void SetUp() override { emu_reset(); }
+
+        reply_t exchange(uint8_t ins, uint8_t p1, uint8_t p2, const std::vector<uint8_t> &data, uint8_t cla = CLA) {
+            std::vector<uint8_t> apdu = {cla, ins, p1, p2, (uint8_t) data.size()};
+            apdu.insert(apdu.end(), data.begin(), data.end());
+
+            uint8_t buffer[300] = {0};
+            return toReply(buffer, emu_exchange(apdu.data(), apdu.size(), buffer, sizeof(buffer)));
+        }
+
+        // Sends the path and the message in chunks, every chunk but the last is acknowledged
+        void sendChunks(uint8_t ins, const std::vector<uint8_t> &message) {
+            ASSERT_EQ(exchange(ins, P1_INIT, 0, pathBytes()).sw, SW_OK);
+            for (size_t offset = 0; offset < message.size(); offset += CHUNK_SIZE) {
+                const size_t n = std::min(CHUNK_SIZE, message.size() - offset);
+                const bool last = offset + n == message.size();
+                const std::vector<uint8_t> chunk(message.begin() + offset, message.begin() + offset + n);
+
+                const auto r = exchange(ins, last ? P1_LAST : P1_ADD, 0, chunk);
+                if (last) {
+                    ASSERT_EQ(r.sw, 0) << "a review should be pending";
+                    ASSERT_TRUE(emu_review_pending());
+                } else {
+                    ASSERT_EQ(r.sw, SW_OK);
+                }
+            }
+        }
+
+        reply_t approve() {
+            uint8_t buffer[300] = {0};
+            return toReply(buffer, emu_review_approve(buffer, sizeof(buffer)));
+        }
+
+        reply_t reject() {
+            uint8_t buffer[300] = {0};
+            return toReply(buffer, emu_review_reject(buffer, sizeof(buffer)));
+        }
+    };
+}
+
+TEST_F(ApduEmu, GetVersion) {
+    const auto r = exchange(0, 0, 0, {});
+    EXPECT_EQ(r.sw, SW_OK);
+    EXPECT_EQ(r.data.size(), 9u);
+}
+
+TEST_F(ApduEmu, GetAddressWithoutConfirmation) {
+    const auto r = exchange(INS_GET_ADDR_ED25519, 0, 0, pathBytes());
+    ASSERT_EQ(r.sw, SW_OK);
+    ASSERT_GT(r.data.size(), PK_LEN_ED25519);
+
+    uint8_t pk[32] = {0};
+    emu_crypto_publicKey(addr_ed25519, pk);
+    EXPECT_EQ(std::vector<uint8_t>(r.data.begin(), r.data.begin() + PK_LEN_ED25519), std::vector<uint8_t>(pk, pk + 32));
+    EXPECT_EQ(std::string(r.data.begin() + PK_LEN_ED25519, r.data.end()).rfind("oasis1", 0), 0u);
+}
+
+TEST_F(ApduEmu, AddressRangeMatchesSingleRequests) {
+    constexpr uint8_t count = 5;
+    const auto pathAt = [](uint32_t index) {
+        std::vector<uint8_t> out = pathBytes();
+        for (int i = 0; i < 4; i++) {
+            out[8 + i] = ((0x80000000 | index) >> (8 * i)) & 0xFF;
+        }
+        return out;
+    };
+
+    for (const auto kind : {addr_ed25519, addr_secp256k1, addr_sr25519}) {
+        const uint8_t ins = kind == addr_ed25519     ? INS_GET_ADDR_ED25519
+                            : kind == addr_secp256k1 ? INS_GET_ADDR_SECP256K1
+                                                     : INS_GET_ADDR_SR25519;
+        const size_t pkLen = kind == addr_secp256k1 ? PK_LEN_SECP256K1 : PK_LEN_ED25519;
+
+        // Three entries fit in a reply, the host asks again from the first index missing
+        std::vector<std::vector<uint8_t>> entries;
+        uint8_t rounds = 0;
+        while (entries.size() < count) {
+            std::vector<uint8_t> data = {(uint8_t) (count - entries.size())};
+            const auto path = pathAt(entries.size());
+            data.insert(data.end(), path.begin(), path.end());
+
+            const auto r = exchange(INS_GET_ADDR_RANGE, kind, 0, data);
+            ASSERT_EQ(r.sw, SW_OK);
+            ASSERT_GT(r.data[0], 0);
+            size_t offset = 1;
+            for (uint8_t i = 0; i < r.data[0]; i++) {
+                ASSERT_LE(offset + pkLen + 1, r.data.size());
+                const size_t len = pkLen + 1 + r.data[offset + pkLen];
+                ASSERT_LE(offset + len, r.data.size());
+                entries.emplace_back(r.data.begin() + offset, r.data.begin() + offset + len);
+                offset += len;
+            }
+            EXPECT_EQ(offset, r.data.size());
+            rounds++;
+        }
+        EXPECT_EQ(rounds, 2) << kind;
+
+        for (uint32_t i = 0; i < count; i++) {
+            const auto single = exchange(ins, 0, 0, pathAt(i));
+            ASSERT_EQ(single.sw, SW_OK);
+            std::vector<uint8_t> expected(single.data.begin(), single.data.begin() + pkLen);
+            expected.push_back(single.data.size() - pkLen);
+            expected.insert(expected.end(), single.data.begin() + pkLen, single.data.end());
+            EXPECT_EQ(entries[i], expected) << kind << " index " << i;
+        }
+    }
+
+    // Public keys only: eight of them fit
+    std::vector<uint8_t> data = {10};
+    const auto path = pathAt(0);
+    data.insert(data.end(), path.begin(), path.end());
+    const auto r = exchange(INS_GET_ADDR_RANGE, addr_ed25519, P2_ADDR_RANGE_PK_ONLY, data);
+    ASSERT_EQ(r.sw, SW_OK);
+    ASSERT_EQ(r.data.size(), 1 + 8 * PK_LEN_ED25519);
+    EXPECT_EQ(r.data[0], 8);
+    // The path is left as it was asked for
+    EXPECT_EQ(hdPath[hdPathLen - 1], 0x80000000u);
+    const auto single = exchange(INS_GET_ADDR_ED25519, 0, 0, pathAt(7));
+    EXPECT_EQ(std::vector<uint8_t>(r.data.end() - PK_LEN_ED25519, r.data.end()),
+              std::vector<uint8_t>(single.data.begin(), single.data.begin() + PK_LEN_ED25519));
+}
+
+TEST_F(ApduEmu, AddressRangeErrors) {
+    std::vector<uint8_t> data = {2};
+    auto path = pathBytes();
+    data.insert(data.end(), path.begin(), path.end());
+
+    EXPECT_EQ(exchange(INS_GET_ADDR_RANGE, addr_eth, 0, data).sw, SW_INVALIDP1P2);
+    EXPECT_EQ(exchange(INS_GET_ADDR_RANGE, addr_ed25519, 2, data).sw, SW_INVALIDP1P2);
+
+    data[0] = 0;
+    EXPECT_EQ(exchange(INS_GET_ADDR_RANGE, addr_ed25519, 0, data).sw, SW_DATA_INVALID);
+
+    // The range would leave the hardened indexes
+    data[0] = 2;
+    for (int i = 0; i < 4; i++) {
+        data[9 + i] = 0xFF;
+    }
+    EXPECT_EQ(exchange(INS_GET_ADDR_RANGE, addr_ed25519, 0, data).sw, SW_DATA_INVALID);
+    data[0] = 1;
+    EXPECT_EQ(exchange(INS_GET_ADDR_RANGE, addr_ed25519, 0, data).sw, SW_OK);
+    EXPECT_EQ(hdPath[hdPathLen - 1], 0xFFFFFFFFu);
+
+    emu_set_pin_validated(false);
+    EXPECT_EQ(exchange(INS_GET_ADDR_RANGE, addr_ed25519, 0, data).sw, SW_COMMAND_NOT_ALLOWED);
+}
+
+TEST_F(ApduEmu, SignEd25519AfterReview) {
+    const auto cbor = decode(txs[1]);
+    std::vector<uint8_t> message = {(uint8_t) context.size()};
+    message.insert(message.end(), context.begin(), context.end());
+    message.insert(message.end(), cbor.begin(), cbor.end());
+    sendChunks(INS_SIGN_ED25519, message);
+
+    char key[40] = {0};
+    char value[64] = {0};
+    uint8_t pageCount = 0;
+    ASSERT_EQ(emu_review_getItem(0, key, sizeof(key), value, sizeof(value), 0, &pageCount), zxerr_ok);
+    EXPECT_STREQ(key, "Type");
+
+    const auto r = approve();
+    ASSERT_EQ(r.sw, SW_OK);
+    EXPECT_EQ(r.data, expectedSignature(cbor));
+    EXPECT_FALSE(emu_review_pending());
+}
+
+TEST_F(ApduEmu, RejectedReviewSignsNothing) {
+    const auto cbor = decode(txs[0]);
+    std::vector<uint8_t> message = {(uint8_t) context.size()};
+    message.insert(message.end(), context.begin(), context.end());
+    message.insert(message.end(), cbor.begin(), cbor.end());
+    sendChunks(INS_SIGN_ED25519, message);
+
+    const auto r = reject();
+    EXPECT_EQ(r.sw, SW_COMMAND_NOT_ALLOWED);
+    EXPECT_TRUE(r.data.empty());
+}
+
+TEST_F(ApduEmu, ChunkStateMachineErrors) {
+    // An unknown payload type drops the transaction, later chunks need a new init
+    EXPECT_EQ(exchange(INS_SIGN_ED25519, 5, 0, {}).sw, SW_INVALIDP1P2);
+    EXPECT_EQ(exchange(INS_SIGN_ED25519, P1_ADD, 0, {1, 2, 3}).sw, SW_TX_NOT_INITIALIZED);
+    EXPECT_EQ(exchange(INS_SIGN_ED25519, P1_INIT, 1, pathBytes()).sw, SW_INVALIDP1P2);
+
+    // The header is rejected as soon as the context is known to be wrong
+    ASSERT_EQ(exchange(INS_SIGN_ED25519, P1_INIT, 0, pathBytes()).sw, SW_OK);
+    EXPECT_EQ(exchange(INS_SIGN_ED25519, P1_ADD, 0, {4, 'a', 'b', 'c', 'd', 0xa4}).sw, SW_DATA_INVALID);
+    EXPECT_FALSE(emu_review_pending());
+}
+
+TEST_F(ApduEmu, LockedDeviceRefusesToSign) {
+    emu_set_pin_validated(false);
+    EXPECT_EQ(exchange(INS_SIGN_ED25519, P1_INIT, 0, pathBytes()).sw, SW_COMMAND_NOT_ALLOWED);
+    EXPECT_EQ(exchange(INS_GET_ADDR_ED25519, 0, 0, pathBytes()).sw, SW_COMMAND_NOT_ALLOWED);
+}
+
+TEST_F(ApduEmu, BatchSignaturesArePaged) {
+    // Five transactions, only four signatures fit in one reply
+    const std::vector<size_t> indexes = {0, 1, 2, 0, 1};
+    std::vector<uint8_t> message = {(uint8_t) context.size()};
+    message.insert(message.end(), context.begin(), context.end());
+    message.push_back(indexes.size());
+    for (auto i : indexes) {
+        const auto cbor = decode(txs[i]);
+        message.push_back(cbor.size() >> 8);
+        message.push_back(cbor.size() & 0xFF);
+        message.insert(message.end(), cbor.begin(), cbor.end());
+    }
+
+    // Nothing to hand out before the batch is approved
+    EXPECT_EQ(exchange(INS_SIGN_BATCH_ED25519, P1_BATCH_SIGNATURES, 0, {0}).sw, SW_COMMAND_NOT_ALLOWED);
+
+    sendChunks(INS_SIGN_BATCH_ED25519, message);
+    auto r = approve();
+    ASSERT_EQ(r.sw, SW_OK);
+    ASSERT_EQ(r.data.size(), 4 * ED25519_SIGNATURE_SIZE);
+
+    auto rest = exchange(INS_SIGN_BATCH_ED25519, P1_BATCH_SIGNATURES, 0, {4});
+    ASSERT_EQ(rest.sw, SW_OK);
+    r.data.insert(r.data.end(), rest.data.begin(), rest.data.end());
+    ASSERT_EQ(r.data.size(), indexes.size() * ED25519_SIGNATURE_SIZE);
+
+    for (size_t i = 0; i < indexes.size(); i++) {
+        const std::vector<uint8_t> signature(r.data.begin() + i * ED25519_SIGNATURE_SIZE,
+                                             r.data.begin() + (i + 1) * ED25519_SIGNATURE_SIZE);
+        EXPECT_EQ(signature, expectedSignature(decode(txs[indexes[i]]))) << "signature " << i;
+    }
+
+    // Any new chunk withdraws the approval
+    EXPECT_EQ(exchange(INS_SIGN_BATCH_ED25519, P1_INIT, 0, pathBytes()).sw, SW_OK);
+    EXPECT_EQ(exchange(INS_SIGN_BATCH_ED25519, P1_BATCH_SIGNATURES, 0, {0}).sw, SW_COMMAND_NOT_ALLOWED);
+}
+
+TEST_F(ApduEmu, BatchSignaturesKeepTheApprovedPath) {
+    const std::vector<size_t> indexes = {0, 1, 2, 0, 1};
+    std::vector<uint8_t> message = {(uint8_t) context.size()};
+    message.insert(message.end(), context.begin(), context.end());
+    message.push_back(indexes.size());
+    for (auto i : indexes) {
+        const auto cbor = decode(txs[i]);
+        message.push_back(cbor.size() >> 8);
+        message.push_back(cbor.size() & 0xFF);
+        message.insert(message.end(), cbor.begin(), cbor.end());
+    }
+
+    sendChunks(INS_SIGN_BATCH_ED25519, message);
+    ASSERT_EQ(approve().sw, SW_OK);
+
+    // Asking for another account in between withdraws the approval
+    auto otherPath = pathBytes();
+    otherPath[8] = 1;
+    ASSERT_EQ(exchange(INS_GET_ADDR_ED25519, 0, 0, otherPath).sw, SW_OK);
+    EXPECT_EQ(exchange(INS_SIGN_BATCH_ED25519, P1_BATCH_SIGNATURES, 0, {4}).sw, SW_COMMAND_NOT_ALLOWED);
+
+    sendChunks(INS_SIGN_BATCH_ED25519, message);
+    ASSERT_EQ(approve().sw, SW_OK);
+    const auto approvedPath = std::vector<uint32_t>(hdPath, hdPath + hdPathLen);
+
+    // Even with hdPath changed behind its back, the rest of the batch is signed for the approved account
+    hdPath[2] = 0x80000001;
+    const auto rest = exchange(INS_SIGN_BATCH_ED25519, P1_BATCH_SIGNATURES, 0, {4});
+    ASSERT_EQ(rest.sw, SW_OK);
+    ASSERT_EQ(std::vector<uint32_t>(hdPath, hdPath + hdPathLen), approvedPath);
+    EXPECT_EQ(rest.data, expectedSignature(decode(txs[indexes[4]])));
+}
+
+TEST_F(ApduEmu, BytesToSignManyMatchDeviceSignatures) {
+    std::vector<std::vector<uint8_t>> cbors;
+    std::vector<const uint8_t *> messages;
+    std::vector<size_t> lens;
+    for (const auto &tx : txs) {
+        cbors.push_back(decode(tx));
+    }
+    for (const auto &cbor : cbors) {
+        messages.push_back(cbor.data());
+        lens.push_back(cbor.size());
+    }
+
+    std::vector<uint8_t> digests(cbors.size() * SHA512_DIGEST_LENGTH);
+    ASSERT_EQ(crypto_getBytesToSignMany((const uint8_t *) context.data(), context.size(), messages.data(), lens.data(),
+                                        cbors.size(), digests.data(), digests.size()),
+              zxerr_ok);
+    EXPECT_EQ(crypto_getBytesToSignMany((const uint8_t *) context.data(), context.size(), messages.data(), lens.data(),
+                                        cbors.size(), digests.data(), digests.size() - 1),
+              zxerr_buffer_too_small);
+
+    // Each digest signs to what the device returns for the transaction sent alone
+    for (size_t i = 0; i < cbors.size(); i++) {
+        std::vector<uint8_t> message = {(uint8_t) context.size()};
+        message.insert(message.end(), context.begin(), context.end());
+        message.insert(message.end(), cbors[i].begin(), cbors[i].end());
+        sendChunks(INS_SIGN_ED25519, message);
+        const auto r = approve();
+        ASSERT_EQ(r.sw, SW_OK);
+
+        uint8_t signature[ED25519_SIGNATURE_SIZE] = {0};
+        emu_crypto_sign(addr_ed25519, digests.data() + i * SHA512_DIGEST_LENGTH, 32, signature);
+        EXPECT_EQ(r.data, std::vector<uint8_t>(signature, signature + sizeof(signature))) << i;
+    }
+}
+
+TEST_F(ApduEmu, RepeatedSigningReusesTheDerivedKey) {
+    const auto cbor = decode(txs[1]);
+    std::vector<uint8_t> message = {(uint8_t) context.size()};
+    message.insert(message.end(), context.begin(), context.end());
+    message.insert(message.end(), cbor.begin(), cbor.end());
+
+    const uint32_t start = emu_crypto_derivations();
+    for (int i = 0; i < 3; i++) {
+        sendChunks(INS_SIGN_ED25519, message);
+        const auto r = approve();
+        ASSERT_EQ(r.sw, SW_OK);
+        EXPECT_EQ(r.data, expectedSignature(cbor));
+    }
+    EXPECT_EQ(emu_crypto_derivations() - start, 1u);
+
+    // Locking the device drops the key
+    emu_set_pin_validated(false);
+    EXPECT_EQ(exchange(INS_SIGN_ED25519, P1_INIT, 0, pathBytes()).sw, SW_COMMAND_NOT_ALLOWED);
+    emu_set_pin_validated(true);
+    sendChunks(INS_SIGN_ED25519, message);
+    ASSERT_EQ(approve().sw, SW_OK);
+    EXPECT_EQ(emu_crypto_derivations() - start, 2u);
+
+    // And so does asking for another key
+    EXPECT_EQ(exchange(INS_GET_ADDR_SR25519, 0, 0, pathBytes()).sw, SW_OK);
+    sendChunks(INS_SIGN_ED25519, message);
+    ASSERT_EQ(approve().sw, SW_OK);
+    EXPECT_EQ(emu_crypto_derivations() - start, 4u);
+}
+
+TEST_F(ApduEmu, IdleOrLockedDeviceDropsTheKeyWithoutAnApdu) {
+    const auto cbor = decode(txs[1]);
+    std::vector<uint8_t> message = {(uint8_t) context.size()};
+    message.insert(message.end(), context.begin(), context.end());
+    message.insert(message.end(), cbor.begin(), cbor.end());
+
+    const auto sign = [&]() {
+        sendChunks(INS_SIGN_ED25519, message);
+        ASSERT_EQ(approve().sw, SW_OK);
+    };
+
+    const uint32_t start = emu_crypto_derivations();
+    sign();
+    emu_ticker(KEY_CACHE_MAX_IDLE_MS / KEY_CACHE_TICKER_MS - 1);
+    sign();
+    EXPECT_EQ(emu_crypto_derivations() - start, 1u);
+
+    // Left alone, the app forgets the key on time
+    emu_ticker(KEY_CACHE_MAX_IDLE_MS / KEY_CACHE_TICKER_MS);
+    sign();
+    EXPECT_EQ(emu_crypto_derivations() - start, 2u);
+
+    // Locked and unlocked between two APDUs, the first ticker while locked already dropped it
+    emu_set_pin_validated(false);
+    emu_ticker(1);
+    emu_set_pin_validated(true);
+    sign();
+    EXPECT_EQ(emu_crypto_derivations() - start, 3u);
+}
+
+#if defined(APP_TRACE)
+TEST_F(ApduEmu, TracesRecordTheSignPath) {
+    const auto cbor = decode(txs[2]);
+    std::vector<uint8_t> message = {(uint8_t) context.size()};
+    message.insert(message.end(), context.begin(), context.end());
+    message.insert(message.end(), cbor.begin(), cbor.end());
+
+    sendChunks(INS_SIGN_ED25519, message);
+    ASSERT_EQ(approve().sw, SW_OK);
+    sendChunks(INS_SIGN_ED25519, message);
+    ASSERT_EQ(reject().sw, SW_COMMAND_NOT_ALLOWED);
+
+    auto r = exchange(INS_GET_TRACES, 0, 0, {});
+    ASSERT_EQ(r.sw, SW_OK);
+    ASSERT_EQ(r.data.size(), 1u + 2 * TRACE_RECORD_LEN);
+    EXPECT_EQ(r.data[0], 2);
+
+    // Newest first: the rejected review never got to hash or sign
+    const auto ticks = [&](size_t record, trace_stage_e stage) {
+        const uint8_t *p = r.data.data() + 1 + record * TRACE_RECORD_LEN + 3 + 4 * stage;
+        return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+    };
+    EXPECT_EQ(r.data[1], INS_SIGN_ED25519);
+    EXPECT_EQ(r.data[2] << 8 | r.data[3], SW_COMMAND_NOT_ALLOWED);
+    EXPECT_GT(ticks(0, trace_parse), 0u);
+    EXPECT_EQ(ticks(0, trace_sign), 0u);
+
+    const uint8_t *approved = r.data.data() + 1 + TRACE_RECORD_LEN;
+    EXPECT_EQ(approved[1] << 8 | approved[2], SW_OK);
+    for (int stage = 0; stage < TRACE_STAGES; stage++) {
+        EXPECT_GT(ticks(1, (trace_stage_e) stage), 0u) << "stage " << stage;
+    }
+
+    // P1 caps how many come back
+    r = exchange(INS_GET_TRACES, 1, 0, {});
+    ASSERT_EQ(r.sw, SW_OK);
+    EXPECT_EQ(r.data.size(), 1u + TRACE_RECORD_LEN);
+}
+
+namespace {
+    std::array<uint64_t, TRACE_STAGES> stageTicks = {};
+    std::array<uint64_t, TRACE_STAGES> stageEvents = {};
+
+    void recordStage(trace_stage_e stage, uint32_t ticks) {
+        stageTicks[stage] += ticks;
+        stageEvents[stage]++;
+    }
+}
+
+TEST_F(ApduEmu, SignPathBenchmark) {
+    const auto cbor = decode(txs[0]);
+    std::vector<uint8_t> message = {(uint8_t) context.size()};
+    message.insert(message.end(), context.begin(), context.end());
+    message.insert(message.end(), cbor.begin(), cbor.end());
+
+    stageTicks.fill(0);
+    stageEvents.fill(0);
+    trace_set_hook(recordStage);
+
+    constexpr int rounds = 500;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        sendChunks(INS_SIGN_ED25519, message);
+        ASSERT_EQ(approve().sw, SW_OK);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    trace_set_hook(nullptr);
+
+    const char *names[TRACE_STAGES] = {"parse", "validate", "review", "hash", "derive", "sign"};
+    std::string stages;
+    for (int stage = 0; stage < TRACE_STAGES; stage++) {
+        EXPECT_EQ(stageEvents[stage], (uint64_t) rounds) << names[stage];
+        stages += fmt::format(" {} {:.1f}", names[stage], (double) stageTicks[stage] / rounds / 1000);
+    }
+    std::cout << fmt::format("sign path: {:.1f} us/tx, per stage (us):{}",
+                             std::chrono::duration<double, std::micro>(elapsed).count() / rounds, stages) << std::endl;
+}
+#endif
@@ -19,6 +19,7 @@
 #include <cbor.h>
 #include <hexutils.h>
 #include <zxmacros.h>
+#include "consumer/cbor_helper.h"
 
 // Basic CBOR test cases generated with http://cbor.me/
 
@@ -190,4 +191,41 @@ namespace {
         err = cbor_value_leave_container(&it, &contents);
         EXPECT_EQ(err, CborNoError);
     }
+
+    TEST(CBORParserTest, ValidateOnce) {
+        // [1,[2,3],4]
+        uint8_t inBuffer[100];
+        auto inBufferLen = parseHexString(inBuffer, sizeof(inBuffer), "830182020304");
+
+        CborParser parser;
+        CborValue it;
+        cbor_validated_range_t range;
+        MEMZERO(&range, sizeof(range));
+
+        EXPECT_EQ(cbor_parser_init(inBuffer, inBufferLen, 0, &parser, &it), CborNoError);
+        EXPECT_EQ(_validateOnce(&range, &it), parser_ok);
+        EXPECT_EQ(range.start, inBuffer);
+        EXPECT_EQ(range.end, inBuffer + inBufferLen);
+
+        // The inner array is part of the validated tree and is not walked again
+        CborValue contents;
+        EXPECT_EQ(cbor_value_enter_container(&it, &contents), CborNoError);
+        EXPECT_EQ(cbor_value_advance_fixed(&contents), CborNoError);
+        EXPECT_EQ(_validateOnce(&range, &contents), parser_ok);
+        EXPECT_EQ(range.start, inBuffer);
+
+        // A different buffer is validated and becomes the new range
+        uint8_t otherBuffer[100];
+        auto otherBufferLen = parseHexString(otherBuffer, sizeof(otherBuffer), "820102");
+        EXPECT_EQ(cbor_parser_init(otherBuffer, otherBufferLen, 0, &parser, &it), CborNoError);
+        EXPECT_EQ(_validateOnce(&range, &it), parser_ok);
+        EXPECT_EQ(range.start, otherBuffer);
+        EXPECT_EQ(range.end, otherBuffer + otherBufferLen);
+
+        // Malformed items are still rejected
+        auto truncatedLen = parseHexString(otherBuffer, sizeof(otherBuffer), "830182");
+        MEMZERO(&range, sizeof(range));
+        EXPECT_EQ(cbor_parser_init(otherBuffer, truncatedLen, 0, &parser, &it), CborNoError);
+        EXPECT_EQ(_validateOnce(&range, &it), parser_cbor_unexpected_EOF);
+    }
 }
@@ -19,6 +19,11 @@
 #include <zxmacros.h>
 #include <zxformat.h>
 
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
 extern "C" {
 #include "sha512.h"
 }
@@ -35,3 +40,190 @@ TEST(SHA512_256, API_Check) {
 
     EXPECT_STREQ(s, "aaa731e500eab8062b5f95830900872a4a4a85560fdf56cecfa0242036299ac7");
 }
+
+namespace {
+    using digest = std::vector<uint8_t>;
+
+    digest oneShot(const std::string &msg) {
+        digest out(SHA512_DIGEST_LENGTH);
+        SHA512_256(reinterpret_cast<const uint8_t *>(msg.data()), msg.size(), out.data());
+        return out;
+    }
+
+    digest resumed(const sha512_256_state_t &prefix, const std::string &msg) {
+        digest out(SHA512_DIGEST_LENGTH);
+        SHA512_256_resume(&prefix, reinterpret_cast<const uint8_t *>(msg.data()), msg.size(), out.data());
+        return out;
+    }
+
+    std::string pattern(size_t len) {
+        std::string out(len, 0);
+        for (size_t i = 0; i < len; i++) {
+            out[i] = static_cast<char>(i * 7 + 3);
+        }
+        return out;
+    }
+}
+
+TEST(SHA512_256, ShortPrefixMatchesHashingEverything) {
+    sha512_256_state_t empty;
+    SHA512_256_init(&empty);
+    const std::string prefix = pattern(40);
+    sha512_256_state_t partial;
+    SHA512_256_init(&partial);
+    SHA512_256_update(&partial, reinterpret_cast<const uint8_t *>(prefix.data()), prefix.size());
+
+    // Messages around the block boundaries, what is left after the prefix can end anywhere in a block
+    for (size_t len : {0, 1, 32, 60, 87, 88, 111, 112, 128, 200, 255, 256, 1000}) {
+        const auto msg = pattern(len);
+        EXPECT_EQ(resumed(empty, msg), oneShot(msg)) << len;
+        EXPECT_EQ(resumed(partial, msg), oneShot(prefix + msg)) << len;
+    }
+}
+
+TEST(SHA512_256, SnapshotAfterLongPrefix) {
+    // A prefix spanning more than a block, absorbed at runtime once and resumed for every message
+    const auto prefix = pattern(300);
+    sha512_256_state_t state;
+    SHA512_256_init(&state);
+    SHA512_256_update(&state, reinterpret_cast<const uint8_t *>(prefix.data()), 100);
+    SHA512_256_update(&state, reinterpret_cast<const uint8_t *>(prefix.data()) + 100, prefix.size() - 100);
+    const sha512_256_state_t snapshot = state;
+
+    digest out(SHA512_DIGEST_LENGTH);
+    SHA512_256_final(&state, out.data());
+    EXPECT_EQ(out, oneShot(prefix));
+
+    for (size_t len : {0, 5, 84, 128, 500}) {
+        const auto msg = pattern(len);
+        EXPECT_EQ(resumed(snapshot, msg), oneShot(prefix + msg)) << len;
+    }
+}
+
+#if defined(SHA512_HOST_ACCEL)
+TEST(SHA512_256, ImplementationsMatchReference) {
+    const auto defaultImpl = SHA512_256_impl();
+    // Whole messages and the same ones absorbed in uneven pieces, across several blocks
+    std::vector<digest> expected;
+    ASSERT_TRUE(SHA512_256_select_impl(SHA512_IMPL_REFERENCE));
+    for (size_t len = 0; len < 700; len += 13) {
+        expected.push_back(oneShot(pattern(len)));
+    }
+
+    for (const auto impl : {SHA512_IMPL_UNROLLED, SHA512_IMPL_BMI2}) {
+        if (!SHA512_256_select_impl(impl)) {
+            std::cout << "sha512 implementation " << impl << " not supported on this CPU" << std::endl;
+            continue;
+        }
+        for (size_t len = 0, i = 0; len < 700; len += 13, i++) {
+            const auto msg = pattern(len);
+            EXPECT_EQ(oneShot(msg), expected[i]) << impl << " " << len;
+
+            sha512_256_state_t state;
+            SHA512_256_init(&state);
+            for (size_t off = 0; off < len; off += 37) {
+                SHA512_256_update(&state, reinterpret_cast<const uint8_t *>(msg.data()) + off, std::min<size_t>(37, len - off));
+            }
+            digest out(SHA512_DIGEST_LENGTH);
+            SHA512_256_final(&state, out.data());
+            EXPECT_EQ(out, expected[i]) << impl << " " << len;
+        }
+    }
+    ASSERT_TRUE(SHA512_256_select_impl(defaultImpl));
+}
+
+TEST(SHA512_256, CompressionBenchmark) {
+    const auto defaultImpl = SHA512_256_impl();
+    const auto msg = pattern(64 * 1024);
+    digest out(SHA512_DIGEST_LENGTH);
+
+    for (const auto impl : {SHA512_IMPL_REFERENCE, SHA512_IMPL_UNROLLED, SHA512_IMPL_BMI2}) {
+        if (!SHA512_256_select_impl(impl)) {
+            continue;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 20; i++) {
+            SHA512_256(reinterpret_cast<const uint8_t *>(msg.data()), msg.size(), out.data());
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << fmt::format("sha512 implementation {}{}: {:.0f} ns per block", static_cast<int>(impl),
+                                 impl == defaultImpl ? " (default)" : "",
+                                 std::chrono::duration<double, std::nano>(elapsed).count() / (20 * msg.size() / 128))
+                  << std::endl;
+    }
+    ASSERT_TRUE(SHA512_256_select_impl(defaultImpl));
+}
+
+TEST(SHA512_256, ManyMatchesOneByOne) {
+    const auto defaultLanes = SHA512_256_lanes_impl();
+    // Lengths around block boundaries mixed with longer ones, not a multiple of the lanes
+    std::vector<std::string> msgs;
+    for (size_t len = 0; len < 300; len += 7) {
+        msgs.push_back(pattern(len));
+        msgs.push_back(pattern(1000 - 3 * len));
+    }
+    std::vector<const uint8_t *> in;
+    std::vector<size_t> lens;
+    for (const auto &m : msgs) {
+        in.push_back(reinterpret_cast<const uint8_t *>(m.data()));
+        lens.push_back(m.size());
+    }
+
+    // No prefix, one shorter than a block and one spanning more than a block
+    for (const size_t prefixLen : {0, 99, 150}) {
+        const auto prefix = pattern(prefixLen);
+        sha512_256_state_t state;
+        SHA512_256_init(&state);
+        SHA512_256_update(&state, reinterpret_cast<const uint8_t *>(prefix.data()), prefix.size());
+
+        for (const auto impl : {SHA512_LANES_SERIAL, SHA512_LANES_PORTABLE, SHA512_LANES_AVX2, SHA512_LANES_AVX512}) {
+            if (!SHA512_256_select_lanes(impl)) {
+                std::cout << "sha512 lanes " << impl << " not supported on this CPU" << std::endl;
+                continue;
+            }
+            std::vector<uint8_t> out(msgs.size() * SHA512_DIGEST_LENGTH);
+            SHA512_256_many(prefixLen > 0 ? &state : nullptr, in.data(), lens.data(), msgs.size(), out.data());
+            for (size_t i = 0; i < msgs.size(); i++) {
+                ASSERT_EQ(digest(out.begin() + i * SHA512_DIGEST_LENGTH, out.begin() + (i + 1) * SHA512_DIGEST_LENGTH),
+                          oneShot(prefix + msgs[i]))
+                    << impl << " " << prefixLen << " " << i;
+            }
+        }
+    }
+
+    // Nothing to hash writes nothing
+    uint8_t untouched[SHA512_DIGEST_LENGTH] = {0xAA};
+    SHA512_256_many(nullptr, nullptr, nullptr, 0, untouched);
+    EXPECT_EQ(untouched[0], 0xAA);
+    ASSERT_TRUE(SHA512_256_select_lanes(defaultLanes));
+}
+
+TEST(SHA512_256, ManyBenchmark) {
+    const auto defaultLanes = SHA512_256_lanes_impl();
+    // Consensus context and transactions of a typical size
+    constexpr size_t count = 2000;
+    const auto context = pattern(99);
+    const auto tx = pattern(200);
+    const std::vector<const uint8_t *> in(count, reinterpret_cast<const uint8_t *>(tx.data()));
+    const std::vector<size_t> lens(count, tx.size());
+    std::vector<uint8_t> out(count * SHA512_DIGEST_LENGTH);
+
+    sha512_256_state_t state;
+    SHA512_256_init(&state);
+    SHA512_256_update(&state, reinterpret_cast<const uint8_t *>(context.data()), context.size());
+
+    for (const auto impl : {SHA512_LANES_SERIAL, SHA512_LANES_PORTABLE, SHA512_LANES_AVX2, SHA512_LANES_AVX512}) {
+        if (!SHA512_256_select_lanes(impl)) {
+            continue;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        SHA512_256_many(&state, in.data(), lens.data(), count, out.data());
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << fmt::format("sha512 lanes {}{}: {:.0f} ns per transaction", static_cast<int>(impl),
+                                 impl == defaultLanes ? " (default)" : "",
+                                 std::chrono::duration<double, std::nano>(elapsed).count() / count)
+                  << std::endl;
+    }
+    ASSERT_TRUE(SHA512_256_select_lanes(defaultLanes));
+}
+#endif
@@ -25,6 +25,11 @@
 #include "testcases.h"
 #include "hexutils.h"
 
+#include <json/json.h>
+#include <chrono>
+#include <fstream>
+#include <random>
+
 TEST(EntityMetadataUrl, EntityMetadataUrlsNotStartingWithHTTPS) {
     url_t url;
     char buffer[] = "OK";
@@ -133,4 +138,189 @@ TEST(EntityMetadataHandle, EntityMetadataHandleNotAllowChar2) {
     handle.len = strlen(buffer);
     auto err = _isValidHandle(&handle);
     ASSERT_EQ(err, parser_invalid_handle_format) << parser_getErrorDescription(err);
-}
\ No newline at end of file
+}
+
+namespace {
+    // Multi-pass validators the single pass implementation replaced, kept as a reference
+    parser_error_t legacyIsValidUrl(url_t *url) {
+        // Verify they are all printable char
+        for (uint8_t i = 0; i < (uint8_t)url->len; i++) {
+            uint8_t c = *(url->buffer + i);
+            // 33  because no space in url
+            if (c < 33 || c > 127) {
+                return parser_invalid_url_format;
+            }
+        }
+
+        const char https_prefix[] = "https://";
+        if (strncmp(https_prefix, (const char *)url->buffer, strlen(https_prefix)) != 0) {
+            return parser_invalid_url_format;
+        }
+
+        // Dectect query by lookin for the `?` separator
+        char query_separator = '?';
+        if (strchr((const char *)url->buffer, query_separator) != NULL) {
+            return parser_invalid_url_format;
+        }
+
+        // Dectect fragment by looking for the `#` the fragment identifier
+        char fragment_identifier = '#';
+        if (strchr((const char *)url->buffer, fragment_identifier) != NULL) {
+            return parser_invalid_url_format;
+        }
+
+        return parser_ok;
+    }
+
+    parser_error_t legacyIsValidEmail(email_t *email) {
+        uint8_t arobase_count = 0;
+        uint8_t punct_count = 0;
+
+        for (uint8_t i = 0; i < (uint8_t)email->len; i++) {
+            uint8_t c = *(email->buffer + i);
+            // Verify they are all printable char
+            if (c < 33 || c > 127) {
+                return parser_invalid_email_format;
+            }
+
+            // Should have exactly one @
+            if (c == '@') {
+                arobase_count++;
+                continue;
+            }
+
+            // We are in the second part of the email
+            if (arobase_count == 1) {
+                if (c == '.') {
+                    punct_count++;
+                    continue;
+                }
+                if ((c < 48 || c > 57) && (c < 65 || c > 90) && (c < 97 || c > 122) && c != '-') {
+                    return parser_invalid_email_format;
+                }
+            }
+        }
+
+        if (arobase_count > 1 || punct_count < 1) {
+            return parser_invalid_email_format;
+        }
+
+        return parser_ok;
+    }
+
+    parser_error_t legacyIsValidHandle(handle_t *handle) {
+        // Verify they are all printable char
+        for (uint8_t i = 0; i < (uint8_t)handle->len; i++) {
+            uint8_t c = *(handle->buffer + i);
+            if ((c < 48 || c > 57) && (c < 65 || c > 90) && (c < 97 || c > 122) && c != '-' && c != '_') {
+                return parser_invalid_handle_format;
+            }
+        }
+
+        return parser_ok;
+    }
+
+
+    struct metadata_fields_t {
+        std::vector<std::string> urls;
+        std::vector<std::string> emails;
+        std::vector<std::string> handles;
+    };
+
+    metadata_fields_t loadMetadataFields() {
+        metadata_fields_t fields;
+
+        std::ifstream inFile(std::string(TESTVECTORS_DIR) + "testvectors/generated_entity_metadata.json");
+        Json::CharReaderBuilder builder;
+        Json::Value obj;
+        JSONCPP_STRING errs;
+        if (!Json::parseFromStream(builder, inFile, &obj, &errs)) {
+            return fields;
+        }
+
+        for (const auto &tc : obj) {
+            const auto &meta = tc["entity_meta"];
+            if (meta.isMember("url")) fields.urls.push_back(meta["url"].asString());
+            if (meta.isMember("email")) fields.emails.push_back(meta["email"].asString());
+            if (meta.isMember("keybase")) fields.handles.push_back(meta["keybase"].asString());
+            if (meta.isMember("twitter")) fields.handles.push_back(meta["twitter"].asString());
+        }
+        return fields;
+    }
+
+    template<typename T>
+    T makeField(const std::string &s) {
+        T field;
+        MEMZERO(&field, sizeof(T));
+        const size_t len = std::min(s.size(), sizeof(field.buffer) - 1);
+        MEMCPY(field.buffer, s.data(), len);
+        field.len = len;
+        return field;
+    }
+
+    std::string randomField(std::mt19937 &rng) {
+        static const char alphabet[] = "https://@.-_?#aZ9 \x7f\x80!";
+        std::string s = rng() % 2 ? "https://" : "";
+        const size_t len = rng() % 24;
+        for (size_t i = 0; i < len; i++) {
+            s.push_back(alphabet[rng() % (sizeof(alphabet) - 1)]);
+        }
+        return s;
+    }
+}
+
+TEST(EntityMetadataValidator, MatchesReference) {
+    auto fields = loadMetadataFields();
+    ASSERT_FALSE(fields.urls.empty());
+
+    std::mt19937 rng(1234);
+    std::vector<std::string> inputs;
+    inputs.insert(inputs.end(), fields.urls.begin(), fields.urls.end());
+    inputs.insert(inputs.end(), fields.emails.begin(), fields.emails.end());
+    inputs.insert(inputs.end(), fields.handles.begin(), fields.handles.end());
+    for (int i = 0; i < 200000; i++) {
+        inputs.push_back(randomField(rng));
+    }
+
+    for (const auto &input : inputs) {
+        auto url = makeField<url_t>(input);
+        auto email = makeField<email_t>(input);
+        auto handle = makeField<handle_t>(input);
+        ASSERT_EQ(_isValidUrl(&url), legacyIsValidUrl(&url)) << input;
+        ASSERT_EQ(_isValidEmail(&email), legacyIsValidEmail(&email)) << input;
+        ASSERT_EQ(_isValidHandle(&handle), legacyIsValidHandle(&handle)) << input;
+    }
+}
+
+TEST(EntityMetadataValidator, Benchmark) {
+    auto fields = loadMetadataFields();
+    ASSERT_FALSE(fields.urls.empty());
+
+    std::vector<url_t> urls;
+    std::vector<email_t> emails;
+    std::vector<handle_t> handles;
+    for (const auto &s : fields.urls) urls.push_back(makeField<url_t>(s));
+    for (const auto &s : fields.emails) emails.push_back(makeField<email_t>(s));
+    for (const auto &s : fields.handles) handles.push_back(makeField<handle_t>(s));
+
+    constexpr int rounds = 200;
+    auto measure = [&](auto isValidUrl, auto isValidEmail, auto isValidHandle) {
+        uint64_t ok = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (auto &f : urls) ok += isValidUrl(&f) == parser_ok;
+            for (auto &f : emails) ok += isValidEmail(&f) == parser_ok;
+            for (auto &f : handles) ok += isValidHandle(&f) == parser_ok;
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto count = rounds * (urls.size() + emails.size() + handles.size());
+        return std::make_pair(ok, std::chrono::duration<double, std::nano>(elapsed).count() / count);
+    };
+
+    const auto reference = measure(legacyIsValidUrl, legacyIsValidEmail, legacyIsValidHandle);
+    const auto current = measure(_isValidUrl, _isValidEmail, _isValidHandle);
+    std::cout << fmt::format("metadata validation: reference {:.1f} ns/field, single pass {:.1f} ns/field",
+                             reference.second, current.second) << std::endl;
+
+    EXPECT_EQ(reference.first, current.first);
+}
@@ -0,0 +1,222 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "coin.h"
+#include "crypto.h"
+#include "crypto_derive.h"
+#include "emu.h"
+#include "key_cache.h"
+
+extern "C" {
+#include "ristretto.h"
+}
+
+namespace {
+    // m/44'/474'/0'
+    const std::vector<uint32_t> path = {0x8000002c, 0x800001da, 0x80000000};
+    const std::vector<uint32_t> otherPath = {0x8000002c, 0x800001da, 0x80000001};
+
+    // Ticker events until an unused entry is wiped
+    constexpr uint32_t IDLE_TICKS = KEY_CACHE_MAX_IDLE_MS / KEY_CACHE_TICKER_MS;
+
+    class KeyCacheTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            emu_reset();
+            for (size_t i = 0; i < key.size(); i++) {
+                key[i] = (uint8_t) (i * 5 + 1);
+            }
+            key_cache_put(key_cache_ed25519, 1, path.data(), path.size(), key.data(), key.size());
+        }
+
+        bool get(key_cache_kind_e kind, uint8_t mode, const std::vector<uint32_t> &p) {
+            out.fill(0);
+            return key_cache_get(kind, mode, p.data(), p.size(), out.data(), out.size());
+        }
+
+        std::array<uint8_t, KEY_CACHE_MAX_LEN> key = {};
+        std::array<uint8_t, KEY_CACHE_MAX_LEN> out = {};
+    };
+}
+
+TEST_F(KeyCacheTest, HitOnTheSameAccount) {
+    ASSERT_TRUE(get(key_cache_ed25519, 1, path));
+    EXPECT_EQ(out, key);
+    EXPECT_TRUE(get(key_cache_ed25519, 1, path));
+}
+
+TEST_F(KeyCacheTest, AnyOtherRequestWipesTheEntry) {
+    EXPECT_FALSE(get(key_cache_ed25519, 1, otherPath));
+    EXPECT_FALSE(get(key_cache_ed25519, 1, path));
+
+    SetUp();
+    EXPECT_FALSE(get(key_cache_sr25519, 1, path));
+    EXPECT_FALSE(get(key_cache_ed25519, 1, path));
+
+    SetUp();
+    EXPECT_FALSE(get(key_cache_ed25519, 0, path));
+    EXPECT_FALSE(get(key_cache_ed25519, 1, path));
+
+    SetUp();
+    EXPECT_FALSE(get(key_cache_ed25519, 1, std::vector<uint32_t>(path.begin(), path.end() - 1)));
+    EXPECT_FALSE(get(key_cache_ed25519, 1, path));
+}
+
+TEST_F(KeyCacheTest, ExpiresWhenIdle) {
+    emu_ticker(IDLE_TICKS - 1);
+    // Using the key restarts the clock
+    ASSERT_TRUE(get(key_cache_ed25519, 1, path));
+    emu_ticker(IDLE_TICKS - 1);
+    ASSERT_TRUE(get(key_cache_ed25519, 1, path));
+
+    emu_ticker(IDLE_TICKS);
+    EXPECT_FALSE(get(key_cache_ed25519, 1, path));
+}
+
+TEST_F(KeyCacheTest, LockingWipesOnTheNextTicker) {
+    emu_set_pin_validated(false);
+    emu_ticker(1);
+    emu_set_pin_validated(true);
+    EXPECT_FALSE(get(key_cache_ed25519, 1, path));
+}
+
+TEST_F(KeyCacheTest, RejectsWrongSizes) {
+    uint8_t small[32] = {0};
+    EXPECT_FALSE(key_cache_get(key_cache_ed25519, 1, path.data(), path.size(), small, sizeof(small)));
+
+    std::vector<uint32_t> longPath(MAX_BIP32_PATH + 1, 0x80000000);
+    key_cache_put(key_cache_ed25519, 1, longPath.data(), longPath.size(), key.data(), key.size());
+    EXPECT_FALSE(get(key_cache_ed25519, 1, path));
+}
+
+namespace {
+    // m/44'/474'/0' and m/44'/474'/0'/0'/0'
+    const std::vector<uint32_t> adr0008Path = {0x8000002c, 0x800001da, 0x80000000};
+    const std::vector<uint32_t> legacyPath = {0x8000002c, 0x800001da, 0x80000000, 0x80000000, 0x80000000};
+
+    // Drives the derivation the app runs, with the emulated SDK underneath counting what really gets derived
+    class DeriveKeyTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            emu_reset();
+            usePath(adr0008Path);
+        }
+
+        void usePath(const std::vector<uint32_t> &p) {
+            std::copy(p.begin(), p.end(), hdPath);
+            hdPathLen = p.size();
+        }
+
+        uint32_t derive(int mode, std::array<uint8_t, 64> &privateKey) {
+            const uint32_t start = emu_crypto_derivations();
+            EXPECT_EQ(crypto_deriveKey(key_cache_ed25519, mode, CX_CURVE_Ed25519, hdPathLen, privateKey.data(), NULL),
+                      zxerr_ok);
+            return emu_crypto_derivations() - start;
+        }
+
+        uint32_t sr25519Keys(std::array<uint8_t, SK_LEN_25519> &sk, std::array<uint8_t, PK_LEN_SR25519> &pk) {
+            const uint32_t start = emu_crypto_derivations();
+            EXPECT_EQ(crypto_sr25519Keys(sk.data(), pk.data()), zxerr_ok);
+            return emu_crypto_derivations() - start;
+        }
+    };
+}
+
+TEST_F(DeriveKeyTest, SecondCallOnTheSameAccountHitsTheCache) {
+    std::array<uint8_t, 64> first = {};
+    std::array<uint8_t, 64> second = {};
+    EXPECT_EQ(derive(HDW_ED25519_SLIP10, first), 1u);
+    EXPECT_EQ(derive(HDW_ED25519_SLIP10, second), 0u);
+    EXPECT_EQ(first, second);
+
+    // The chain code comes from the same cached entry
+    std::array<uint8_t, 32> chainCode = {};
+    const uint32_t start = emu_crypto_derivations();
+    ASSERT_EQ(crypto_deriveKey(key_cache_ed25519, HDW_ED25519_SLIP10, CX_CURVE_Ed25519, hdPathLen, second.data(),
+                               chainCode.data()),
+              zxerr_ok);
+    EXPECT_EQ(emu_crypto_derivations(), start);
+    EXPECT_NE(chainCode, (std::array<uint8_t, 32>{}));
+}
+
+TEST_F(DeriveKeyTest, PathChangeWipesTheCache) {
+    std::array<uint8_t, 64> first = {};
+    std::array<uint8_t, 64> other = {};
+    EXPECT_EQ(derive(HDW_ED25519_SLIP10, first), 1u);
+
+    hdPath[hdPathLen - 1]++;
+    EXPECT_EQ(derive(HDW_ED25519_SLIP10, other), 1u);
+    EXPECT_NE(first, other);
+
+    usePath(adr0008Path);
+    EXPECT_EQ(derive(HDW_ED25519_SLIP10, other), 1u);
+    EXPECT_EQ(first, other);
+}
+
+TEST_F(DeriveKeyTest, ModeChangeWipesTheCache) {
+    std::array<uint8_t, 64> slip10 = {};
+    std::array<uint8_t, 64> normal = {};
+    EXPECT_EQ(derive(HDW_ED25519_SLIP10, slip10), 1u);
+    EXPECT_EQ(derive(HDW_NORMAL, normal), 1u);
+    EXPECT_NE(slip10, normal);
+    EXPECT_EQ(derive(HDW_ED25519_SLIP10, slip10), 1u);
+}
+
+TEST_F(DeriveKeyTest, IdleTimeoutWipesTheCache) {
+    std::array<uint8_t, 64> privateKey = {};
+    EXPECT_EQ(derive(HDW_ED25519_SLIP10, privateKey), 1u);
+    emu_ticker(IDLE_TICKS - 1);
+    EXPECT_EQ(derive(HDW_ED25519_SLIP10, privateKey), 0u);
+
+    emu_ticker(IDLE_TICKS);
+    EXPECT_EQ(derive(HDW_ED25519_SLIP10, privateKey), 1u);
+}
+
+TEST_F(DeriveKeyTest, Sr25519KeysAreCachedWithThePublicKey) {
+    for (const auto &p : {adr0008Path, legacyPath}) {
+        key_cache_clear();
+        usePath(p);
+
+        std::array<uint8_t, SK_LEN_25519> sk = {};
+        std::array<uint8_t, PK_LEN_SR25519> pk = {};
+        EXPECT_EQ(sr25519Keys(sk, pk), 1u);
+
+        std::array<uint8_t, PK_LEN_SR25519> expected = {};
+        ASSERT_EQ(crypto_scalarmult_ristretto255_base_sdk(expected.data(), sk.data()), CX_OK);
+        EXPECT_EQ(pk, expected);
+
+        std::array<uint8_t, SK_LEN_25519> cachedSk = {};
+        std::array<uint8_t, PK_LEN_SR25519> cachedPk = {};
+        EXPECT_EQ(sr25519Keys(cachedSk, cachedPk), 0u);
+        EXPECT_EQ(cachedSk, sk);
+        EXPECT_EQ(cachedPk, pk);
+
+        // Same account under another curve is a different key
+        std::array<uint8_t, 64> ed25519 = {};
+        derive(p.size() == HDPATH_LEN_ADR0008 ? HDW_ED25519_SLIP10 : HDW_NORMAL, ed25519);
+        EXPECT_EQ(sr25519Keys(cachedSk, cachedPk), 1u);
+
+        emu_ticker(IDLE_TICKS);
+        EXPECT_EQ(sr25519Keys(cachedSk, cachedPk), 1u);
+        EXPECT_EQ(cachedPk, pk);
+    }
+}
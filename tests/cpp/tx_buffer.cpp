@@ -0,0 +1,142 @@
+/*******************************************************************************
+*   (c) 2018 - 2024 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "tx_buffer.h"
+
+namespace {
+    constexpr uint32_t WINDOW_SIZE = 4 * TX_BUFFER_PAGE_SIZE;
+    constexpr uint32_t FLASH_SIZE = 16 * TX_BUFFER_PAGE_SIZE;
+
+    class TxBufferTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            tx_buffer_init(window, sizeof(window), flash, sizeof(flash));
+        }
+
+        // Appends length bytes of a known pattern in APDU-sized chunks
+        std::vector<uint8_t> appendPattern(uint32_t length, uint32_t chunkSize) {
+            std::vector<uint8_t> data(length);
+            for (uint32_t i = 0; i < length; i++) {
+                data[i] = (uint8_t) (i * 7 + 3);
+            }
+            for (uint32_t offset = 0; offset < length; offset += chunkSize) {
+                const uint32_t n = std::min(chunkSize, length - offset);
+                EXPECT_EQ(tx_buffer_append(data.data() + offset, n), n);
+            }
+            return data;
+        }
+
+        alignas(TX_BUFFER_PAGE_SIZE) uint8_t window[WINDOW_SIZE]{};
+        alignas(TX_BUFFER_PAGE_SIZE) uint8_t flash[FLASH_SIZE]{};
+    };
+}
+
+TEST_F(TxBufferTest, FitsInWindowNeverTouchesFlash) {
+    const auto data = appendPattern(WINDOW_SIZE, 37);
+
+    EXPECT_EQ(tx_buffer_length(), WINDOW_SIZE);
+    EXPECT_EQ(tx_buffer_data(), window);
+    EXPECT_EQ(tx_buffer_stats()->flashPages, 0u);
+    EXPECT_EQ(std::vector<uint8_t>(window, window + WINDOW_SIZE), data);
+}
+
+TEST_F(TxBufferTest, SpillsIntoFlashInWholePages) {
+    const uint32_t length = 2 * WINDOW_SIZE + 3 * TX_BUFFER_PAGE_SIZE - 5;
+    const auto data = appendPattern(length, 37);
+
+    // Two full windows went to flash, the rest is still staged
+    EXPECT_EQ(tx_buffer_stats()->flashPages, 2 * WINDOW_SIZE / TX_BUFFER_PAGE_SIZE);
+
+    const uint8_t *contiguous = tx_buffer_data();
+    EXPECT_EQ(contiguous, flash);
+    EXPECT_EQ(tx_buffer_stats()->flashPages, 2 * WINDOW_SIZE / TX_BUFFER_PAGE_SIZE + 3);
+    EXPECT_EQ(std::vector<uint8_t>(contiguous, contiguous + length), data);
+
+    // Asking again does not write again
+    tx_buffer_data();
+    EXPECT_EQ(tx_buffer_stats()->flashPages, 2 * WINDOW_SIZE / TX_BUFFER_PAGE_SIZE + 3);
+}
+
+TEST_F(TxBufferTest, ReadCursorSpansFlashAndWindow) {
+    const uint32_t length = WINDOW_SIZE + 100;
+    const auto data = appendPattern(length, 250);
+    const uint32_t pages = tx_buffer_stats()->flashPages;
+
+    uint8_t out[64] = {0};
+    EXPECT_EQ(tx_buffer_read(WINDOW_SIZE - 20, out, sizeof(out)), sizeof(out));
+    EXPECT_EQ(std::vector<uint8_t>(out, out + sizeof(out)),
+              std::vector<uint8_t>(data.begin() + WINDOW_SIZE - 20, data.begin() + WINDOW_SIZE + 44));
+
+    // Reads are clamped to the data and never flush
+    EXPECT_EQ(tx_buffer_read(length - 10, out, sizeof(out)), 10u);
+    EXPECT_EQ(tx_buffer_read(length, out, sizeof(out)), 0u);
+    EXPECT_EQ(tx_buffer_stats()->flashPages, pages);
+}
+
+TEST_F(TxBufferTest, AppendAfterDataKeepsStreaming) {
+    const auto first = appendPattern(WINDOW_SIZE + 10, 250);
+    tx_buffer_data();
+
+    std::vector<uint8_t> second(WINDOW_SIZE, 0xAB);
+    EXPECT_EQ(tx_buffer_append(second.data(), second.size()), second.size());
+
+    auto expected = first;
+    expected.insert(expected.end(), second.begin(), second.end());
+    const uint8_t *contiguous = tx_buffer_data();
+    EXPECT_EQ(std::vector<uint8_t>(contiguous, contiguous + expected.size()), expected);
+}
+
+TEST_F(TxBufferTest, RejectsWhatDoesNotFit) {
+    appendPattern(FLASH_SIZE - 1, 250);
+
+    uint8_t extra[2] = {1, 2};
+    EXPECT_EQ(tx_buffer_append(extra, sizeof(extra)), 0u);
+    EXPECT_EQ(tx_buffer_length(), FLASH_SIZE - 1);
+    EXPECT_EQ(tx_buffer_append(extra, 1), 1u);
+    EXPECT_EQ(tx_buffer_length(), FLASH_SIZE);
+}
+
+TEST_F(TxBufferTest, HighWaterMarksSurviveReset) {
+    appendPattern(FLASH_SIZE, 250);
+    tx_buffer_data();
+    tx_buffer_reset();
+    appendPattern(10, 250);
+
+    const tx_buffer_stats_t *stats = tx_buffer_stats();
+    EXPECT_EQ(tx_buffer_length(), 10u);
+    EXPECT_GE(stats->maxLength, FLASH_SIZE);
+    EXPECT_GE(stats->maxStaged, WINDOW_SIZE);
+    EXPECT_EQ(stats->flashPages, 0u);
+    EXPECT_GE(stats->maxFlashPages, FLASH_SIZE / TX_BUFFER_PAGE_SIZE);
+}
+
+TEST_F(TxBufferTest, WindowLargerThanFlashIsClamped) {
+    // Only the first two pages of flash exist, the window must not let more than that in
+    tx_buffer_init(window, sizeof(window), flash, 2 * TX_BUFFER_PAGE_SIZE);
+    const auto data = appendPattern(2 * TX_BUFFER_PAGE_SIZE, 37);
+    const uint8_t extra = 0xAA;
+    EXPECT_EQ(tx_buffer_append(&extra, 1), 0u);
+    EXPECT_EQ(tx_buffer_length(), 2 * TX_BUFFER_PAGE_SIZE);
+
+    const uint8_t *contiguous = tx_buffer_data();
+    EXPECT_EQ(std::vector<uint8_t>(contiguous, contiguous + data.size()), data);
+    EXPECT_TRUE(std::all_of(flash + 2 * TX_BUFFER_PAGE_SIZE, flash + FLASH_SIZE, [](uint8_t b) { return b == 0; }));
+}
@@ -19,6 +19,7 @@
 
 #include <zxmacros.h>
 #include "common/parser.h"
+#include "consumer/parser_impl_con.h"
 #include "base64.h"
 #include "common.h"
 #include "testcases.h"
@@ -49,3 +50,244 @@ TEST(TxParser, MissingLastByte) {
     auto err = parser_parse(&ctx, buffer.data(), buffer.size() - 1);
     ASSERT_EQ(err, parser_context_unknown_prefix) << parser_getErrorDescription(err);
 }
+
+TEST(TxParser, DataHashCoversAllChunks) {
+    // h'0102030405' and the same bytes as the indefinite length string (_ h'0102', h'030405')
+    uint8_t definite[16];
+    uint8_t chunked[16];
+    const auto definiteLen = parseHexString(definite, sizeof(definite), "450102030405");
+    const auto chunkedLen = parseHexString(chunked, sizeof(chunked), "5f42010243030405ff");
+
+    data_hash_t definiteHash = {};
+    data_hash_t chunkedHash = {};
+    ASSERT_EQ(cbor_parser_init(definite, definiteLen, 0, &definiteHash.cborState.parser,
+                               &definiteHash.cborState.startValue), CborNoError);
+    ASSERT_EQ(cbor_parser_init(chunked, chunkedLen, 0, &chunkedHash.cborState.parser,
+                               &chunkedHash.cborState.startValue), CborNoError);
+
+    ASSERT_EQ(_getDataHash(&definiteHash), parser_ok);
+    ASSERT_EQ(_getDataHash(&chunkedHash), parser_ok);
+    EXPECT_TRUE(chunkedHash.hashed);
+
+    uint8_t expected[32];
+    parseHexString(expected, sizeof(expected), "74f81fe167d99b4cb41d6d0ccda82278caee9f3e2f25d5e5a3936ff3dcec60d0");
+    EXPECT_EQ(memcmp(definiteHash.hash, expected, sizeof(expected)), 0);
+    EXPECT_EQ(memcmp(chunkedHash.hash, expected, sizeof(expected)), 0);
+}
+
+TEST(TxParser, QuantitiesAreViewsIntoTheBuffer) {
+    parser_context_t ctx = {};
+
+    std::string context = "oasis-core/consensus: tx for chain bc1c715319132305795fa86bd32e93291aaacbfb5b5955f3ba78bdba413af9e1";
+    // staking.Burn with body amount h'01'
+    std::string cborString = "pGNmZWWiY2dhcwBmYW1vdW50QGRib2R5oWZhbW91bnRBAWVub25jZQBmbWV0aG9kbHN0YWtpbmcuQnVybg==";
+    auto buffer = utils::prepareBlob(context, cborString);
+    auto err = parser_parse(&ctx, buffer.data(), buffer.size());
+    ASSERT_EQ(err, parser_ok) << parser_getErrorDescription(err);
+
+    const quantity_t &amount = parser_tx_obj.oasis.tx.body.stakingBurn.amount;
+    ASSERT_EQ(amount.len, 1);
+    EXPECT_GE(amount.buffer, buffer.data());
+    EXPECT_LT(amount.buffer, buffer.data() + buffer.size());
+    EXPECT_EQ(amount.buffer[0], 0x01);
+}
+
+TEST(TxParser, IndefiniteLengthQuantity) {
+    parser_context_t ctx = {};
+
+    std::string context = "oasis-core/consensus: tx for chain bc1c715319132305795fa86bd32e93291aaacbfb5b5955f3ba78bdba413af9e1";
+    // staking.Burn with body amount (_ h'01')
+    std::string cborString = "pGNmZWWiY2dhcwBmYW1vdW50QGRib2R5oWZhbW91bnRfQQH/ZW5vbmNlAGZtZXRob2Rsc3Rha2luZy5CdXJu";
+    auto buffer = utils::prepareBlob(context, cborString);
+    auto err = parser_parse(&ctx, buffer.data(), buffer.size());
+    ASSERT_EQ(err, parser_cbor_not_canonical) << parser_getErrorDescription(err);
+}
+
+TEST(TxParser, HeaderIsCheckedWhileChunksArrive) {
+    parser_context_t ctx = {};
+
+    std::string context = "oasis-core/consensus: tx for chain bc1c715319132305795fa86bd32e93291aaacbfb5b5955f3ba78bdba413af9e1";
+    std::string cborString = "pGNmZWWiY2dhcwBmYW1vdW50QGRib2R5oWZhbW91bnRBAWVub25jZQBmbWV0aG9kbHN0YWtpbmcuQnVybg==";
+    auto buffer = utils::prepareBlob(context, cborString);
+
+    // Undecided until the root map header is in, fine from then on
+    const size_t headerLen = 1 + context.size() + 1;
+    for (size_t len = 0; len <= buffer.size(); len++) {
+        auto err = parser_parseHeader(&ctx, buffer.data(), len);
+        ASSERT_EQ(err, len < headerLen ? parser_no_data : parser_ok) << len << " " << parser_getErrorDescription(err);
+    }
+
+    auto err = parser_parse(&ctx, buffer.data(), buffer.size());
+    ASSERT_EQ(err, parser_ok) << parser_getErrorDescription(err);
+}
+
+TEST(TxParser, HeaderFailsFast) {
+    parser_context_t ctx = {};
+    std::string cborString = "pGNmZWWiY2dhcwBmYW1vdW50QGRib2R5oWZhbW91bnRBAWVub25jZQBmbWV0aG9kbHN0YWtpbmcuQnVybg==";
+
+    // Unknown context, known as soon as the context is in
+    std::string unknown = "oasis-core/unknown: tx for chain bc1c715319132305795fa86bd32e93291aaacbfb5b5955f3ba78bdba413af9e1";
+    auto buffer = utils::prepareBlob(unknown, cborString);
+    auto err = parser_parseHeader(&ctx, buffer.data(), 1 + unknown.size());
+    ASSERT_EQ(err, parser_context_unknown_prefix) << parser_getErrorDescription(err);
+
+    // Root item is not a map, known from its first byte
+    std::string context = "oasis-core/consensus: tx for chain bc1c715319132305795fa86bd32e93291aaacbfb5b5955f3ba78bdba413af9e1";
+    buffer = utils::prepareBlob(context, cborString);
+    buffer[1 + context.size()] = 0x84;
+    err = parser_parseHeader(&ctx, buffer.data(), 1 + context.size() + 1);
+    ASSERT_EQ(err, parser_root_item_should_be_a_map) << parser_getErrorDescription(err);
+}
+
+TEST(TxParser, RuntimeHeaderNeedsCompleteMeta) {
+    parser_context_t ctx = {};
+
+    std::string metaString = "ompydW50aW1lX2lkeEAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDBlMmVhYTk5ZmMwMDhmODdmbWNoYWluX2NvbnRleHR4QGJiM2Q3NDhkZWY1NWJkZmI3OTdhMmFjNTNlZTZlZTE0MWU1NGNkMmFiMmRjMjM3NWY0YTA3MDNhMTc4ZTZlNTU=";
+    auto meta = utils::prepareRuntimeBlob(metaString, "");
+
+    for (size_t len = 1; len < meta.size(); len++) {
+        auto err = parser_parseHeader(&ctx, meta.data(), len);
+        ASSERT_EQ(err, parser_no_data) << len << " " << parser_getErrorDescription(err);
+    }
+
+    auto err = parser_parseHeader(&ctx, meta.data(), meta.size());
+    ASSERT_EQ(err, parser_ok) << parser_getErrorDescription(err);
+    EXPECT_EQ(parser_tx_obj.type, runtimeType);
+}
+
+TEST(TxParser, RuntimeMetaMapsOrigToOnce) {
+    // m/44'/60'/0'/0/0 of the Oasis docs and its native address
+    // oasis1qpupfu7e2n6pkezeaw0yhj8mcem8anj64ytrayne
+    uint8_t expected[ADDR_RAW] = {0};
+    parseHexString(expected, sizeof(expected), "007814f3d954f41b6459eb9e4bc8fbc6767ece5aa9");
+
+    // Meta of RuntimeHeaderNeedsCompleteMeta with orig_to, with and without 0x, and with a bad hex digit
+    const std::string metas[] = {
+        "o2pydW50aW1lX2lkeEAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDBlMmVhYTk5ZmMwMDhmODdmbWNoYWluX2NvbnRleHR4QGJiM2Q3NDhkZWY1NWJkZmI3OTdhMmFjNTNlZTZlZTE0MWU1NGNkMmFiMmRjMjM3NWY0YTA3MDNhMTc4ZTZlNTVnb3JpZ190b3gqMHg5MGFkRTNCNzA2NWZhNzE1YzdhMTUwMzEzODc3ZEYxZDMzZTc3N0Q1",
+        "o2pydW50aW1lX2lkeEAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDBlMmVhYTk5ZmMwMDhmODdmbWNoYWluX2NvbnRleHR4QGJiM2Q3NDhkZWY1NWJkZmI3OTdhMmFjNTNlZTZlZTE0MWU1NGNkMmFiMmRjMjM3NWY0YTA3MDNhMTc4ZTZlNTVnb3JpZ190b3goOTBhZEUzQjcwNjVmYTcxNWM3YTE1MDMxMzg3N2RGMWQzM2U3NzdENQ==",
+        "o2pydW50aW1lX2lkeEAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDAwMDBlMmVhYTk5ZmMwMDhmODdmbWNoYWluX2NvbnRleHR4QGJiM2Q3NDhkZWY1NWJkZmI3OTdhMmFjNTNlZTZlZTE0MWU1NGNkMmFiMmRjMjM3NWY0YTA3MDNhMTc4ZTZlNTVnb3JpZ190b3gqMHg5MGFkRTNCNzA2NWZhNzE1YzdhMTUwMzEzODc3ZEYxZDMzZTc3N1p6",
+    };
+
+    for (size_t i = 0; i < 2; i++) {
+        parser_context_t ctx = {};
+        auto meta = utils::prepareRuntimeBlob(metas[i], "");
+        auto err = parser_parseHeader(&ctx, meta.data(), meta.size());
+        ASSERT_EQ(err, parser_ok) << i << " " << parser_getErrorDescription(err);
+
+        const auto &m = parser_tx_obj.oasis.runtime.meta;
+        EXPECT_TRUE(m.has_orig_to) << i;
+        EXPECT_EQ(std::vector<uint8_t>(m.orig_to_native, m.orig_to_native + ADDR_RAW),
+                  std::vector<uint8_t>(expected, expected + ADDR_RAW)) << i;
+    }
+
+    // A malformed orig_to is rejected while parsing, nothing is mapped from the partial decode
+    parser_context_t ctx = {};
+    auto meta = utils::prepareRuntimeBlob(metas[2], "");
+    EXPECT_EQ(parser_parseHeader(&ctx, meta.data(), meta.size()), parser_invalid_eth_mapping);
+    EXPECT_EQ(std::vector<uint8_t>(parser_tx_obj.oasis.runtime.meta.orig_to_native,
+                                   parser_tx_obj.oasis.runtime.meta.orig_to_native + ADDR_RAW),
+              std::vector<uint8_t>(ADDR_RAW, 0));
+}
+
+namespace {
+    const std::string batchContext =
+        "oasis-core/consensus: tx for chain bc1c715319132305795fa86bd32e93291aaacbfb5b5955f3ba78bdba413af9e1";
+
+    // Escrows of 1, 0.5 and 3 (x10^12) to two accounts, a reclaim of 1000 shares and a burn, all with fee 2000 and gas 1000
+    const std::vector<std::string> batchTxs = {
+        "pGNmZWWiY2dhcxkD6GZhbW91bnRCB9BkYm9keaJmYW1vdW50RejUpRAAZ2FjY291bnRVABERERERERERERERERERERERERERZW5vbmNlAWZtZXRob2Rxc3Rha2luZy5BZGRFc2Nyb3c=",
+        "pGNmZWWiY2dhcxkD6GZhbW91bnRCB9BkYm9keaJmYW1vdW50RXRqUogAZ2FjY291bnRVABERERERERERERERERERERERERERZW5vbmNlAmZtZXRob2Rxc3Rha2luZy5BZGRFc2Nyb3c=",
+        "pGNmZWWiY2dhcxkD6GZhbW91bnRCB9BkYm9keaJmYW1vdW50RgK6fe8wAGdhY2NvdW50VQAiIiIiIiIiIiIiIiIiIiIiIiIiImVub25jZQNmbWV0aG9kcXN0YWtpbmcuQWRkRXNjcm93",
+        "pGNmZWWiY2dhcxkD6GZhbW91bnRCB9BkYm9keaJmc2hhcmVzQgPoZ2FjY291bnRVACIiIiIiIiIiIiIiIiIiIiIiIiIiZW5vbmNlBGZtZXRob2R1c3Rha2luZy5SZWNsYWltRXNjcm93",
+        "pGNmZWWiY2dhcxkD6GZhbW91bnRCB9BkYm9keaFmYW1vdW50QQFlbm9uY2UFZm1ldGhvZGxzdGFraW5nLkJ1cm4=",
+    };
+
+    // [ctxLen][ctx][count]([txLen (2 bytes, BE)][cbor])*count
+    std::vector<uint8_t> prepareBatchBlob(const std::vector<size_t> &indexes) {
+        std::vector<uint8_t> buffer;
+        buffer.push_back(batchContext.size());
+        buffer.insert(buffer.end(), batchContext.begin(), batchContext.end());
+        buffer.push_back(indexes.size());
+        for (auto i : indexes) {
+            std::string cbor;
+            macaron::Base64::Decode(batchTxs[i], cbor);
+            buffer.push_back(cbor.size() >> 8);
+            buffer.push_back(cbor.size() & 0xFF);
+            buffer.insert(buffer.end(), cbor.begin(), cbor.end());
+        }
+        return buffer;
+    }
+
+    std::vector<uint8_t> amountTail(const uint8_t *amount, size_t len) {
+        return std::vector<uint8_t>(amount + BATCH_AMOUNT_LEN - len, amount + BATCH_AMOUNT_LEN);
+    }
+}
+
+TEST(TxParser, BatchAggregatesTotals) {
+    parser_context_t ctx = {};
+    ctx.tx_type = oasis_batch_tx;
+
+    auto buffer = prepareBatchBlob({0, 1, 2, 3});
+    auto err = parser_parse(&ctx, buffer.data(), buffer.size());
+    ASSERT_EQ(err, parser_ok) << parser_getErrorDescription(err);
+    err = parser_validate(&ctx);
+    ASSERT_EQ(err, parser_ok) << parser_getErrorDescription(err);
+
+    const batch_summary_t &b = parser_batch_obj;
+    EXPECT_EQ(b.count, 4);
+    EXPECT_EQ(b.gas, 4000u);
+    EXPECT_EQ(amountTail(b.fee, 2), std::vector<uint8_t>({0x1F, 0x40}));
+
+    ASSERT_EQ(b.methodsLen, 2);
+    EXPECT_EQ(b.methods[0].method, stakingEscrow);
+    EXPECT_EQ(b.methods[0].count, 3);
+    EXPECT_EQ(amountTail(b.methods[0].total, 6), std::vector<uint8_t>({0x04, 0x17, 0xBC, 0xE6, 0xC8, 0x00}));
+    EXPECT_EQ(b.methods[1].method, stakingReclaimEscrow);
+    EXPECT_EQ(b.methods[1].count, 1);
+
+    // Both escrows to the same account end up in a single destination
+    ASSERT_EQ(b.destinationsLen, 3);
+    EXPECT_EQ(amountTail(b.destinations[0].amount, 6), std::vector<uint8_t>({0x01, 0x5D, 0x3E, 0xF7, 0x98, 0x00}));
+
+    // Type, 2 x (method, total), 3 x (address, amount), fee, gas and network
+    uint8_t numItems = 0;
+    ASSERT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+    EXPECT_EQ(numItems, 14);
+
+    char key[40];
+    char value[40];
+    uint8_t pageCount = 0;
+    ASSERT_EQ(parser_getItem(&ctx, 0, key, sizeof(key), value, sizeof(value), 0, &pageCount), parser_ok);
+    EXPECT_STREQ(value, "Batch (4 txs)");
+    ASSERT_EQ(parser_getItem(&ctx, 7, key, sizeof(key), value, sizeof(value), 0, &pageCount), parser_ok);
+    EXPECT_STREQ(key, "Reclaim escrow");
+    EXPECT_STREQ(value, "1 tx");
+}
+
+TEST(TxParser, BatchRejectsWhatCannotBeReviewed) {
+    parser_context_t ctx = {};
+    ctx.tx_type = oasis_batch_tx;
+
+    auto buffer = prepareBatchBlob({0, 4});
+    auto err = parser_parse(&ctx, buffer.data(), buffer.size());
+    EXPECT_EQ(err, parser_unexpected_method) << parser_getErrorDescription(err);
+
+    buffer = prepareBatchBlob({});
+    err = parser_parse(&ctx, buffer.data(), buffer.size());
+    EXPECT_EQ(err, parser_unexpected_number_items) << parser_getErrorDescription(err);
+
+    buffer = prepareBatchBlob({0, 1});
+    err = parser_parse(&ctx, buffer.data(), buffer.size() - 1);
+    EXPECT_EQ(err, parser_unexpected_buffer_end) << parser_getErrorDescription(err);
+
+    // Bytes outside of every transaction, or after the root item inside one, would be signed without being shown
+    buffer.push_back(0);
+    err = parser_parse(&ctx, buffer.data(), buffer.size());
+    EXPECT_EQ(err, parser_unexpected_characters) << parser_getErrorDescription(err);
+
+    buffer = prepareBatchBlob({0});
+    buffer[1 + batchContext.size() + 2]++;
+    buffer.push_back(0);
+    err = parser_parse(&ctx, buffer.data(), buffer.size());
+    EXPECT_EQ(err, parser_unexpected_characters) << parser_getErrorDescription(err);
+}
@@ -0,0 +1,586 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+// Differential testing of the transaction parser
+//
+// The `tx` objects of the JSON test vectors are used as templates: their
+// leaves are replaced with random values, the result is encoded canonically
+// the way the Oasis signers do it, parsed through app_lib and rendered with
+// dumpUI. The rendering is compared against GenerateExpectedUIOutput() for
+// the same randomized object, and the first mismatch per method is reported.
+//
+// The parser keeps its state in globals, so parallelism comes from forked
+// worker processes rather than threads.
+//
+//   differential [--iterations N] [--workers N] [--seed S] file.json...
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <bech32.h>
+#include <json/json.h>
+
+#include "base64.h"
+#include "coin.h"
+#include "common.h"
+#include "common/parser.h"
+#include "testcases.h"
+
+namespace {
+
+using Rng = std::mt19937_64;
+
+enum class field_kind_e {
+    keep,
+    uint,
+    quantity,
+    address,
+    bytes,
+    text,
+};
+
+// Fields kept verbatim: versions and enums whose values are validated or drive the layout
+const char *const KEEP_KEYS[] = {"v", "format", "vote", "major", "minor", "patch", "rate", "rate_min", "rate_max",
+                                 "negative", "Denomination"};
+const char *const QUANTITY_KEYS[] = {"amount", "shares", "amount_change", "Amount"};
+const char *const TEXT_KEYS[] = {"method", "handler", "target", "name", "url", "email", "keybase", "twitter",
+                                 "chain_context", "runtime_id", "orig_to"};
+
+template <size_t N>
+bool contains(const char *const (&keys)[N], const std::string &key) {
+    return std::any_of(keys, keys + N, [&](const char *k) { return key == k; });
+}
+
+field_kind_e classify(const std::string &key, const Json::Value &value) {
+    if (contains(KEEP_KEYS, key)) {
+        return field_kind_e::keep;
+    }
+    if (value.isIntegral()) {
+        return field_kind_e::uint;
+    }
+    if (contains(QUANTITY_KEYS, key)) {
+        return field_kind_e::quantity;
+    }
+    if (contains(TEXT_KEYS, key)) {
+        return field_kind_e::text;
+    }
+    if (value.isString() && value.asString().rfind(COIN_HRP "1", 0) == 0) {
+        return field_kind_e::address;
+    }
+    return value.isString() ? field_kind_e::bytes : field_kind_e::keep;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Value conversions
+
+std::string decimalToBytes(const std::string &decimal) {
+    std::vector<uint8_t> digits;
+    for (char c : decimal) {
+        digits.push_back(c - '0');
+    }
+
+    std::string out;
+    while (!digits.empty()) {
+        std::vector<uint8_t> quotient;
+        uint32_t remainder = 0;
+        for (uint8_t d : digits) {
+            remainder = remainder * 10 + d;
+            if (!quotient.empty() || remainder >= 256) {
+                quotient.push_back(remainder / 256);
+            }
+            remainder %= 256;
+        }
+        out.insert(out.begin(), static_cast<char>(remainder));
+        digits = quotient;
+    }
+    // zero is encoded as an empty byte string
+    while (!out.empty() && out[0] == 0) {
+        out.erase(out.begin());
+    }
+    return out;
+}
+
+std::string bytesToDecimal(const std::string &bytes) {
+    std::vector<uint8_t> digits = {0};  // little endian decimal digits
+    for (unsigned char b : bytes) {
+        uint32_t carry = b;
+        for (auto &d : digits) {
+            const uint32_t v = d * 256 + carry;
+            d = v % 10;
+            carry = v / 10;
+        }
+        while (carry > 0) {
+            digits.push_back(carry % 10);
+            carry /= 10;
+        }
+    }
+    while (digits.size() > 1 && digits.back() == 0) {
+        digits.pop_back();
+    }
+    std::string out;
+    for (auto it = digits.rbegin(); it != digits.rend(); ++it) {
+        out.push_back(static_cast<char>('0' + *it));
+    }
+    return out;
+}
+
+std::string bech32Decode(const std::string &address) {
+    static const std::string CHARSET = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+    const size_t sep = address.rfind('1');
+    if (sep == std::string::npos || address.size() < sep + 7) {
+        return "";
+    }
+
+    uint32_t acc = 0;
+    int bits = 0;
+    std::string out;
+    // skip the 6 checksum characters
+    for (size_t i = sep + 1; i < address.size() - 6; i++) {
+        const size_t v = CHARSET.find(address[i]);
+        if (v == std::string::npos) {
+            return "";
+        }
+        acc = (acc << 5) | v;
+        bits += 5;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((acc >> bits) & 0xFF));
+        }
+    }
+    return out;
+}
+
+std::string bech32Encode(const std::string &raw) {
+    char out[100] = {0};
+    bech32EncodeFromBytes(out, sizeof(out), COIN_HRP, (const uint8_t *)raw.data(), raw.size(), 1,
+                          BECH32_ENCODING_BECH32);
+    return out;
+}
+
+std::string randomBytes(Rng &rng, size_t len) {
+    std::string out(len, '\0');
+    for (auto &c : out) {
+        c = static_cast<char>(rng());
+    }
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Canonical CBOR encoding of the JSON objects
+
+void writeHead(std::string *out, uint8_t major, uint64_t value) {
+    const uint8_t type = major << 5;
+    if (value < 24) {
+        out->push_back(static_cast<char>(type | value));
+        return;
+    }
+    uint8_t len = 8;
+    uint8_t info = 27;
+    if (value <= 0xFF) {
+        len = 1;
+        info = 24;
+    } else if (value <= 0xFFFF) {
+        len = 2;
+        info = 25;
+    } else if (value <= 0xFFFFFFFF) {
+        len = 4;
+        info = 26;
+    }
+    out->push_back(static_cast<char>(type | info));
+    for (uint8_t i = len; i > 0; i--) {
+        out->push_back(static_cast<char>((value >> (8 * (i - 1))) & 0xFF));
+    }
+}
+
+void writeBytes(std::string *out, uint8_t major, const std::string &bytes) {
+    writeHead(out, major, bytes.size());
+    out->append(bytes);
+}
+
+void encode(const std::string &key, const Json::Value &value, std::string *out);
+
+void encodeObject(const Json::Value &value, std::string *out) {
+    // Runtime amounts are serialized as [amount, denomination]
+    if (value.isMember("Amount") && value.size() == 2 && value.isMember("Denomination")) {
+        writeHead(out, 4, 2);
+        writeBytes(out, 2, decimalToBytes(value["Amount"].asString()));
+        writeBytes(out, 2, value["Denomination"].asString());
+        return;
+    }
+
+    std::vector<std::pair<std::string, std::string>> entries;
+    for (const auto &name : value.getMemberNames()) {
+        // empty structs are omitted by the encoder
+        if (value[name].isObject() && value[name].empty()) {
+            continue;
+        }
+        std::pair<std::string, std::string> entry;
+        writeBytes(&entry.first, 3, name);
+        encode(name, value[name], &entry.second);
+        entries.push_back(std::move(entry));
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+        return a.first.size() != b.first.size() ? a.first.size() < b.first.size() : a.first < b.first;
+    });
+
+    writeHead(out, 5, entries.size());
+    for (const auto &entry : entries) {
+        out->append(entry.first);
+        out->append(entry.second);
+    }
+}
+
+void encode(const std::string &key, const Json::Value &value, std::string *out) {
+    if (value.isObject()) {
+        if (key == "untrusted_raw_value") {
+            // signed envelopes carry the CBOR of the inner object as a byte string
+            std::string inner;
+            encodeObject(value, &inner);
+            writeBytes(out, 2, inner);
+            return;
+        }
+        encodeObject(value, out);
+        return;
+    }
+    if (value.isArray()) {
+        writeHead(out, 4, value.size());
+        for (const auto &item : value) {
+            encode(key, item, out);
+        }
+        return;
+    }
+    if (value.isBool()) {
+        out->push_back(static_cast<char>(value.asBool() ? 0xF5 : 0xF4));
+        return;
+    }
+    if (value.isIntegral()) {
+        writeHead(out, 0, value.asUInt64());
+        return;
+    }
+
+    switch (classify(key, value)) {
+        case field_kind_e::quantity:
+            writeBytes(out, 2, decimalToBytes(value.asString()));
+            return;
+        case field_kind_e::address:
+            writeBytes(out, 2, bech32Decode(value.asString()));
+            return;
+        case field_kind_e::bytes: {
+            std::string decoded;
+            macaron::Base64::Decode(value.asString(), decoded);
+            writeBytes(out, 2, decoded);
+            return;
+        }
+        default:
+            writeBytes(out, 3, value.asString());
+            return;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Randomization
+
+void randomize(Rng &rng, const std::string &key, Json::Value *value) {
+    if (value->isObject()) {
+        for (const auto &name : value->getMemberNames()) {
+            randomize(rng, name, &(*value)[name]);
+        }
+        return;
+    }
+    if (value->isArray()) {
+        for (auto &item : *value) {
+            randomize(rng, key, &item);
+        }
+        return;
+    }
+
+    switch (classify(key, *value)) {
+        case field_kind_e::uint:
+            *value = Json::UInt64(rng() % 2 ? rng() : rng() % 1000);
+            break;
+        case field_kind_e::quantity: {
+            std::string raw = randomBytes(rng, rng() % 17);
+            while (!raw.empty() && raw[0] == 0) {
+                raw.erase(raw.begin());
+            }
+            *value = bytesToDecimal(raw);
+            break;
+        }
+        case field_kind_e::address:
+            *value = bech32Encode(std::string(1, '\0') + randomBytes(rng, ADDR_RAW - 1));
+            break;
+        case field_kind_e::bytes: {
+            std::string decoded;
+            macaron::Base64::Decode(value->asString(), decoded);
+            *value = macaron::Base64::Encode(randomBytes(rng, decoded.size()));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct template_t {
+    Json::Value testcase;
+    std::string method;
+};
+
+struct method_report_t {
+    uint64_t cases = 0;
+    uint64_t failures = 0;
+    Json::Value first;
+};
+
+std::vector<uint8_t> buildBlob(const Json::Value &tc) {
+    std::string body;
+    encode("", tc["tx"], &body);
+
+    std::string blob;
+    if (tc.isMember("meta")) {
+        encodeObject(tc["meta"], &blob);
+    } else {
+        const std::string context = tc["signature_context"].asString();
+        blob.push_back(static_cast<char>(context.size()));
+        blob.append(context);
+    }
+    blob.append(body);
+    return std::vector<uint8_t>(blob.begin(), blob.end());
+}
+
+std::string toHex(const std::vector<uint8_t> &data) {
+    static const char HEX[] = "0123456789abcdef";
+    std::string out;
+    for (uint8_t b : data) {
+        out.push_back(HEX[b >> 4]);
+        out.push_back(HEX[b & 0xF]);
+    }
+    return out;
+}
+
+Json::Value checkCase(const Json::Value &tc) {
+    const auto blob = buildBlob(tc);
+
+    parser_context_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+
+    Json::Value mismatch;
+    parser_error_t err = parser_parse(&ctx, blob.data(), blob.size());
+    if (err == parser_ok) {
+        err = parser_validate(&ctx);
+    }
+    if (err != parser_ok) {
+        mismatch["error"] = parser_getErrorDescription(err);
+    } else {
+        const auto expected = utils::GenerateExpectedUIOutput(tc["signature_context"].asString(), tc);
+        const auto actual = dumpUI(&ctx, 40, 40);
+        for (size_t i = 0; i < std::max(expected.size(), actual.size()); i++) {
+            const std::string e = i < expected.size() ? expected[i] : "<missing>";
+            const std::string a = i < actual.size() ? actual[i] : "<missing>";
+            if (e != a) {
+                mismatch["expected"] = e;
+                mismatch["actual"] = a;
+                break;
+            }
+        }
+    }
+
+    if (!mismatch.isNull()) {
+        mismatch["tx"] = tc["tx"];
+        mismatch["blob"] = toHex(blob);
+    }
+    return mismatch;
+}
+
+Json::Value runWorker(const std::vector<template_t> &templates, uint64_t iterations, uint64_t seed) {
+    Rng rng(seed);
+    std::map<std::string, method_report_t> reports;
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        const auto &tpl = templates[rng() % templates.size()];
+        Json::Value tc = tpl.testcase;
+        randomize(rng, "", &tc["tx"]);
+
+        auto &report = reports[tpl.method];
+        report.cases++;
+        const Json::Value mismatch = checkCase(tc);
+        if (!mismatch.isNull()) {
+            if (report.failures++ == 0) {
+                report.first = mismatch;
+            }
+        }
+    }
+
+    Json::Value out(Json::objectValue);
+    for (const auto &it : reports) {
+        out[it.first]["cases"] = Json::UInt64(it.second.cases);
+        out[it.first]["failures"] = Json::UInt64(it.second.failures);
+        out[it.first]["first"] = it.second.first;
+    }
+    return out;
+}
+
+std::vector<template_t> loadTemplates(const std::vector<std::string> &files) {
+    std::vector<template_t> templates;
+    for (const auto &file : files) {
+        std::ifstream in(file);
+        Json::Value root;
+        Json::CharReaderBuilder builder;
+        JSONCPP_STRING errs;
+        if (!Json::parseFromStream(builder, in, &root, &errs)) {
+            std::cerr << "could not read " << file << ": " << errs << std::endl;
+            continue;
+        }
+
+        for (const auto &tc : root) {
+            if (!tc.isMember("tx") || !tc["valid"].asBool() || !utils::TestcaseIsValid(tc)) {
+                continue;
+            }
+            const auto &tx = tc["tx"];
+            if (tc.isMember("encoded_tx")) {
+                // only use vectors the canonical encoder reproduces byte for byte
+                std::string encoded;
+                std::string reencoded;
+                macaron::Base64::Decode(tc["encoded_tx"].asString(), encoded);
+                encode("", tx, &reencoded);
+                if (encoded != reencoded) {
+                    continue;
+                }
+            }
+            const std::string method = tx.isMember("call") ? tx["call"]["method"].asString() : tx["method"].asString();
+            templates.push_back({tc, method});
+        }
+    }
+    return templates;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    uint64_t iterations = 100000;
+    uint64_t seed = std::random_device{}();
+    unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::stoull(argv[++i]);
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        files.push_back(std::string(TESTVECTORS_DIR) + "testvectors/manual.json");
+        files.push_back(std::string(TESTVECTORS_DIR) + "testvectors/registry.json");
+    }
+
+    const auto templates = loadTemplates(files);
+    if (templates.empty()) {
+        std::cerr << "no usable templates" << std::endl;
+        return 2;
+    }
+    std::cout << templates.size() << " templates, " << iterations << " cases, " << workers << " workers, seed "
+              << seed << std::endl;
+
+    std::vector<std::pair<pid_t, int>> children;
+    for (unsigned w = 0; w < workers; w++) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            return 2;
+        }
+        const pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            const uint64_t share = iterations / workers + (w < iterations % workers ? 1 : 0);
+            Json::StreamWriterBuilder writer;
+            writer["indentation"] = "";
+            const std::string out = Json::writeString(writer, runWorker(templates, share, seed + w));
+            size_t written = 0;
+            while (written < out.size()) {
+                const ssize_t n = write(fds[1], out.data() + written, out.size() - written);
+                if (n <= 0) {
+                    _exit(2);
+                }
+                written += n;
+            }
+            close(fds[1]);
+            _exit(0);
+        }
+        close(fds[1]);
+        children.emplace_back(pid, fds[0]);
+    }
+
+    std::map<std::string, method_report_t> reports;
+    for (const auto &child : children) {
+        std::string data;
+        char buf[4096];
+        ssize_t n;
+        while ((n = read(child.second, buf, sizeof(buf))) > 0) {
+            data.append(buf, n);
+        }
+        close(child.second);
+        int status = 0;
+        waitpid(child.first, &status, 0);
+
+        Json::Value result;
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+            !reader->parse(data.data(), data.data() + data.size(), &result, nullptr)) {
+            std::cerr << "worker " << child.first << " crashed" << std::endl;
+            return 2;
+        }
+
+        for (const auto &method : result.getMemberNames()) {
+            auto &report = reports[method];
+            report.cases += result[method]["cases"].asUInt64();
+            report.failures += result[method]["failures"].asUInt64();
+            if (report.first.isNull()) {
+                report.first = result[method]["first"];
+            }
+        }
+    }
+
+    uint64_t failures = 0;
+    for (const auto &it : reports) {
+        std::cout << it.first << ": " << it.second.cases << " cases, " << it.second.failures << " mismatches"
+                  << std::endl;
+        if (!it.second.first.isNull()) {
+            std::cout << it.second.first.toStyledString() << std::endl;
+        }
+        failures += it.second.failures;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
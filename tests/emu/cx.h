@@ -0,0 +1,65 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+// Host stand-in for the Ledger SDK cx.h, only the sizes the APDU layer refers to
+// and the key derivation crypto_derive.c calls
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef CX_SHA256_SIZE
+#define CX_SHA256_SIZE 32
+#endif
+
+#ifndef CX_SHA512_SIZE
+#define CX_SHA512_SIZE 64
+#endif
+
+typedef uint32_t cx_err_t;
+#define CX_OK 0x00000000
+#define CX_INVALID_PARAMETER 0xFFFFFF82
+
+typedef enum {
+    CX_CURVE_256K1 = 0x21,
+    CX_CURVE_Ed25519 = 0x71,
+} cx_curve_t;
+
+#define HDW_NORMAL 0
+#define HDW_ED25519_SLIP10 1
+
+/// Emulated keys come from a fixed seed, curve, mode and path, see emu_crypto.c
+cx_err_t os_derive_bip32_with_seed_no_throw(unsigned int derivation_mode, cx_curve_t curve, const uint32_t *path,
+                                            size_t path_len, uint8_t raw_privkey[64], uint8_t *chain_code,
+                                            unsigned char *seed_key, size_t seed_key_length);
+
+// Same as the zxlib macro for Ledger builds
+#ifndef CATCH_CXERROR
+#define CATCH_CXERROR(CALL)      \
+    do {                         \
+        if ((CALL) != CX_OK) {   \
+            goto catch_cx_error; \
+        }                        \
+    } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
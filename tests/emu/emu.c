@@ -0,0 +1,222 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#include "emu.h"
+
+#include <os.h>
+#include <os_io_seproxyhal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "actions.h"
+#include "app_main.h"
+#include "app_mode.h"
+#include "emu_view.h"
+#include "key_cache.h"
+#include "trace.h"
+#include "zxmacros.h"
+
+// Big enough for what a Nano screen shows of one item, values longer than this are paged
+#define EMU_SCREEN_KEY_LEN 40
+#define EMU_SCREEN_VALUE_LEN 64
+
+uint8_t G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
+
+static try_context_t *emu_try_context = NULL;
+
+static bool emu_pin_validated = true;
+static bool emu_expert_mode = false;
+
+// Last reply the app sent through io_exchange
+static uint8_t emu_reply[IO_APDU_BUFFER_SIZE];
+static uint16_t emu_replyLen = 0;
+static bool emu_replied = false;
+
+try_context_t *try_context_get(void) { return emu_try_context; }
+
+try_context_t *try_context_set(try_context_t *ctx) {
+    try_context_t *previous = emu_try_context;
+    emu_try_context = ctx;
+    return previous;
+}
+
+void os_longjmp(unsigned int exception) {
+    if (emu_try_context == NULL) {
+        // The device would reboot, a test has nothing sensible to continue with
+        fprintf(stderr, "emu: uncaught exception 0x%04x\n", exception);
+        abort();
+    }
+    longjmp(emu_try_context->jmp_buf, (int)exception);
+}
+
+unsigned int os_global_pin_is_validated(void) { return emu_pin_validated ? BOLOS_UX_OK : BOLOS_FALSE; }
+
+bool app_mode_expert() { return emu_expert_mode; }
+
+unsigned short io_exchange(unsigned char channel_and_flags, unsigned short tx_len) {
+    if ((channel_and_flags & IO_RETURN_AFTER_TX) == 0 || tx_len > sizeof(emu_reply)) {
+        THROW(EXCEPTION_IO_RESET);
+    }
+    MEMCPY(emu_reply, G_io_apdu_buffer, tx_len);
+    emu_replyLen = tx_len;
+    emu_replied = true;
+    return 0;
+}
+
+static uint16_t emu_copy_reply(const uint8_t *data, uint16_t dataLen, uint8_t *reply, uint16_t replyMaxLen) {
+    if (reply == NULL || dataLen > replyMaxLen) {
+        return 0;
+    }
+    MEMCPY(reply, data, dataLen);
+    return dataLen;
+}
+
+void emu_reset() {
+    MEMZERO(G_io_apdu_buffer, sizeof(G_io_apdu_buffer));
+    emu_try_context = NULL;
+    emu_pin_validated = true;
+    emu_expert_mode = false;
+    emu_replyLen = 0;
+    emu_replied = false;
+    emu_view_clear();
+    app_batch_reset();
+    key_cache_clear();
+#if defined(APP_TRACE)
+    trace_reset();
+    trace_set_hook(NULL);
+#endif
+}
+
+void emu_set_pin_validated(bool validated) { emu_pin_validated = validated; }
+
+void emu_set_expert_mode(bool enabled) { emu_expert_mode = enabled; }
+
+void emu_ticker(uint32_t count) {
+    // What src/common/main.c does with ticker events on the device
+    for (uint32_t i = 0; i < count; i++) {
+        key_cache_ticker();
+    }
+}
+
+uint16_t emu_exchange(const uint8_t *apdu, uint16_t apduLen, uint8_t *reply, uint16_t replyMaxLen) {
+    if (apdu == NULL || apduLen > IO_APDU_BUFFER_SIZE) {
+        return 0;
+    }
+
+    MEMZERO(G_io_apdu_buffer, sizeof(G_io_apdu_buffer));
+    MEMCPY(G_io_apdu_buffer, apdu, apduLen);
+
+    volatile uint32_t flags = 0;
+    volatile uint32_t tx = 0;
+    volatile bool reset = false;
+
+    BEGIN_TRY {
+        TRY { handleApdu(&flags, &tx, apduLen); }
+        CATCH_OTHER(e) {
+            // handleApdu answers everything but a transport reset itself
+            UNUSED(e);
+            reset = true;
+        }
+        FINALLY {}
+    }
+    END_TRY;
+
+    if (reset || (flags & IO_ASYNCH_REPLY) != 0 || tx > IO_APDU_BUFFER_SIZE) {
+        return 0;
+    }
+    return emu_copy_reply(G_io_apdu_buffer, (uint16_t)tx, reply, replyMaxLen);
+}
+
+bool emu_review_pending() { return emu_view.pending; }
+
+zxerr_t emu_review_getNumItems(uint8_t *numItems) {
+    if (!emu_view.pending || emu_view.error) {
+        return zxerr_no_data;
+    }
+    return emu_view.getNumItems(numItems);
+}
+
+zxerr_t emu_review_getItem(uint8_t displayIdx, char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen,
+                           uint8_t pageIdx, uint8_t *pageCount) {
+    if (!emu_view.pending || emu_view.error) {
+        return zxerr_no_data;
+    }
+    return emu_view.getItem((int8_t)displayIdx, outKey, outKeyLen, outVal, outValLen, pageIdx, pageCount);
+}
+
+// Renders every page of every item, the user has to scroll to the end before approving
+static void emu_review_scroll() {
+    char key[EMU_SCREEN_KEY_LEN];
+    char value[EMU_SCREEN_VALUE_LEN];
+
+    uint8_t numItems = 0;
+    if (emu_review_getNumItems(&numItems) != zxerr_ok) {
+        return;
+    }
+
+    for (uint8_t idx = 0; idx < numItems; idx++) {
+        uint8_t pageCount = 1;
+        for (uint8_t page = 0; page < pageCount; page++) {
+            if (emu_review_getItem(idx, key, sizeof(key), value, sizeof(value), page, &pageCount) != zxerr_ok) {
+                break;
+            }
+        }
+    }
+}
+
+static uint16_t emu_review_finish(emu_accept_t callback, uint8_t *reply, uint16_t replyMaxLen) {
+    emu_view_clear();
+    emu_replied = false;
+
+    volatile bool reset = false;
+
+    BEGIN_TRY {
+        TRY { callback(); }
+        CATCH(EXCEPTION_IO_RESET) { reset = true; }
+        CATCH_OTHER(e) {
+            // On the device the main loop replies with the status word
+            G_io_apdu_buffer[0] = e >> 8;
+            G_io_apdu_buffer[1] = e & 0xFF;
+            io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
+        }
+        FINALLY {}
+    }
+    END_TRY;
+
+    if (reset || !emu_replied) {
+        return 0;
+    }
+    return emu_copy_reply(emu_reply, emu_replyLen, reply, replyMaxLen);
+}
+
+uint16_t emu_review_approve(uint8_t *reply, uint16_t replyMaxLen) {
+    if (!emu_view.pending) {
+        return 0;
+    }
+    if (emu_view.error) {
+        return emu_review_finish(app_reply_error, reply, replyMaxLen);
+    }
+
+    emu_review_scroll();
+    return emu_review_finish(emu_view.accept, reply, replyMaxLen);
+}
+
+uint16_t emu_review_reject(uint8_t *reply, uint16_t replyMaxLen) {
+    if (!emu_view.pending) {
+        return 0;
+    }
+    return emu_review_finish(emu_view.error ? app_reply_error : app_reject, reply, replyMaxLen);
+}
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+// Drives the real APDU handler in-process: the SDK transport, exceptions, screens,
+// flash and key derivation are replaced by host stand-ins
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "coin.h"
+#include "zxerror.h"
+
+/// Powers the emulated device back on: unlocked, expert mode off, nothing pending
+void emu_reset();
+
+void emu_set_pin_validated(bool validated);
+void emu_set_expert_mode(bool enabled);
+
+/// Delivers count SEPROXYHAL ticker events, as the SDK does every KEY_CACHE_TICKER_MS with or without APDUs
+void emu_ticker(uint32_t count);
+
+/// Runs one APDU through handleApdu
+/// \return reply length including the status word, 0 if the app started a review
+/// instead (the reply then comes from emu_review_approve or emu_review_reject)
+/// or if the APDU made the app reset the transport
+uint16_t emu_exchange(const uint8_t *apdu, uint16_t apduLen, uint8_t *reply, uint16_t replyMaxLen);
+
+/// Whether a review screen is waiting for the user
+bool emu_review_pending();
+
+/// Reads the pending review like the screens do
+zxerr_t emu_review_getNumItems(uint8_t *numItems);
+zxerr_t emu_review_getItem(uint8_t displayIdx, char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen,
+                           uint8_t pageIdx, uint8_t *pageCount);
+
+/// Scrolls through every page of the pending review and approves it
+/// \return reply length including the status word, 0 if nothing was pending
+uint16_t emu_review_approve(uint8_t *reply, uint16_t replyMaxLen);
+/// Rejects the pending review
+uint16_t emu_review_reject(uint8_t *reply, uint16_t replyMaxLen);
+
+/// Signature the emulated key at the current path gives over message
+/// It is NOT a real Ed25519/secp256k1/sr25519 signature, only a deterministic function of
+/// curve, path and message so tests can check what was signed
+void emu_crypto_sign(address_kind_e kind, const uint8_t *message, size_t messageLen, uint8_t signature[64]);
+
+/// Public key of the emulated key at the current path
+void emu_crypto_publicKey(address_kind_e kind, uint8_t publicKey[32]);
+
+/// Keys derived by the app since start, emulated or through crypto_derive.c, key cache hits are not counted
+uint32_t emu_crypto_derivations();
+
+#ifdef __cplusplus
+}
+#endif
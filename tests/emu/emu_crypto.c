@@ -0,0 +1,326 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+// Software stand-in for crypto.c. Keys are derived from a fixed seed, curve and path
+// with SHA-512/256, and "signatures" are keyed hashes of the message. Replies keep the
+// exact layouts of the device so the APDU and view code around them is exercised as is.
+
+#include <bech32.h>
+#include <string.h>
+
+#include "coin.h"
+#include "crypto.h"
+#include "emu.h"
+#include "key_cache.h"
+#include "ristretto.h"
+#include "rslib.h"
+#include "sha512.h"
+#include "trace.h"
+#include "tx.h"
+#include "zxformat.h"
+#include "zxmacros.h"
+
+uint32_t hdPath[MAX_BIP32_PATH];
+uint8_t hdPathLen;
+uint8_t chain_code;
+
+#define EMU_KEY_LEN 32
+#define EMU_SECP256K1_SIGNATURE_LEN 65
+
+static const uint8_t emu_seed[] = "oasis host emulator seed";
+static const uint8_t emu_public_context[] = "public";
+
+// First half of SHA-512/256(context || message), the sha512 helpers always write the full 64 bytes
+static void emu_crypto_hash(const uint8_t *context, size_t contextLen, const uint8_t *message, size_t messageLen,
+                            uint8_t out[CX_SHA256_SIZE]) {
+    uint8_t digest[SHA512_DIGEST_LENGTH] = {0};
+    SHA512_256_with_context(context, contextLen, message, messageLen, digest);
+    MEMCPY(out, digest, CX_SHA256_SIZE);
+}
+
+static void emu_crypto_key(address_kind_e kind, uint8_t key[EMU_KEY_LEN]) {
+    // The Ethereum flow shares the secp256k1 key
+    uint8_t derivation[1 + sizeof(hdPath)] = {0};
+    derivation[0] = (kind == addr_eth) ? addr_secp256k1 : (uint8_t)kind;
+    MEMCPY(derivation + 1, hdPath, sizeof(uint32_t) * hdPathLen);
+
+    emu_crypto_hash(emu_seed, sizeof(emu_seed) - 1, derivation, 1 + sizeof(uint32_t) * hdPathLen, key);
+}
+
+static uint32_t emu_derivations = 0;
+
+uint32_t emu_crypto_derivations() { return emu_derivations; }
+
+// Stand-ins for the SDK derivation and the rslib key expansion, so crypto_derive.c runs as it does on the device
+cx_err_t os_derive_bip32_with_seed_no_throw(unsigned int derivation_mode, cx_curve_t curve, const uint32_t *path,
+                                            size_t path_len, uint8_t raw_privkey[64], uint8_t *chain_code,
+                                            unsigned char *seed_key, size_t seed_key_length) {
+    UNUSED(seed_key);
+    UNUSED(seed_key_length);
+    if (path == NULL || raw_privkey == NULL || path_len > MAX_BIP32_PATH) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    uint8_t derivation[2 + sizeof(hdPath)] = {0};
+    derivation[0] = (uint8_t)derivation_mode;
+    derivation[1] = (uint8_t)curve;
+    MEMCPY(derivation + 2, path, sizeof(uint32_t) * path_len);
+
+    emu_derivations++;
+    emu_crypto_hash(emu_seed, sizeof(emu_seed) - 1, derivation, 2 + sizeof(uint32_t) * path_len, raw_privkey);
+    emu_crypto_hash(emu_seed, sizeof(emu_seed) - 1, raw_privkey, EMU_KEY_LEN, raw_privkey + EMU_KEY_LEN);
+    if (chain_code != NULL) {
+        emu_crypto_hash(emu_seed, sizeof(emu_seed) - 1, raw_privkey + EMU_KEY_LEN, EMU_KEY_LEN, chain_code);
+    }
+    return CX_OK;
+}
+
+static void emu_crypto_clamp(uint8_t *sk) {
+    sk[0] &= 248;
+    sk[31] &= 63;
+    sk[31] |= 64;
+}
+
+// Not schnorrkel's expansion, only a scalar the ristretto base point multiplication accepts
+void get_sr25519_sk(uint8_t *sk_ed25519_expanded) { emu_crypto_clamp(sk_ed25519_expanded); }
+
+void expanded_sr25519_sk(uint8_t *sk_ed25519, uint8_t *sk_ed25519_expanded) {
+    emu_crypto_hash(emu_seed, sizeof(emu_seed) - 1, sk_ed25519, EMU_KEY_LEN, sk_ed25519_expanded);
+    emu_crypto_hash(emu_seed, sizeof(emu_seed) - 1, sk_ed25519_expanded, EMU_KEY_LEN,
+                    sk_ed25519_expanded + EMU_KEY_LEN);
+    emu_crypto_clamp(sk_ed25519_expanded);
+}
+
+// Not a ristretto255 point, only a deterministic public part for the scalar
+cx_err_t crypto_scalarmult_ristretto255_base_sdk(unsigned char *q, const unsigned char *n) {
+    emu_crypto_hash(emu_public_context, sizeof(emu_public_context) - 1, n, ED25519_SCALAR_BYTES, q);
+    return CX_OK;
+}
+
+// Like crypto.c, only derives when the key cache does not hold the key already
+static void emu_crypto_deviceKey(address_kind_e kind, uint8_t key[EMU_KEY_LEN]) {
+    key_cache_kind_e cacheKind = key_cache_secp256k1;
+    uint8_t mode = 0;
+    if (kind == addr_ed25519 || kind == addr_sr25519) {
+        cacheKind = (kind == addr_ed25519) ? key_cache_ed25519 : key_cache_sr25519;
+        mode = (hdPathLen == HDPATH_LEN_ADR0008) ? 1 : 0;
+    }
+
+    if (key_cache_get(cacheKind, mode, hdPath, hdPathLen, key, EMU_KEY_LEN)) {
+        return;
+    }
+    emu_derivations++;
+    emu_crypto_key(kind, key);
+    key_cache_put(cacheKind, mode, hdPath, hdPathLen, key, EMU_KEY_LEN);
+}
+
+static void emu_crypto_publicKeyOf(const uint8_t key[EMU_KEY_LEN], uint8_t publicKey[32]) {
+    emu_crypto_hash(emu_public_context, sizeof(emu_public_context) - 1, key, EMU_KEY_LEN, publicKey);
+}
+
+void emu_crypto_publicKey(address_kind_e kind, uint8_t publicKey[32]) {
+    uint8_t key[EMU_KEY_LEN] = {0};
+    emu_crypto_key(kind, key);
+    emu_crypto_publicKeyOf(key, publicKey);
+    MEMZERO(key, sizeof(key));
+}
+
+static void emu_crypto_devicePublicKey(address_kind_e kind, uint8_t publicKey[32]) {
+    uint8_t key[EMU_KEY_LEN] = {0};
+    emu_crypto_deviceKey(kind, key);
+    emu_crypto_publicKeyOf(key, publicKey);
+    MEMZERO(key, sizeof(key));
+}
+
+static void emu_crypto_signWithKey(const uint8_t key[EMU_KEY_LEN], const uint8_t *message, size_t messageLen,
+                                   uint8_t signature[64]) {
+    emu_crypto_hash(key, EMU_KEY_LEN, message, messageLen, signature);
+    emu_crypto_hash(signature, CX_SHA256_SIZE, message, messageLen, signature + CX_SHA256_SIZE);
+}
+
+void emu_crypto_sign(address_kind_e kind, const uint8_t *message, size_t messageLen, uint8_t signature[64]) {
+    uint8_t key[EMU_KEY_LEN] = {0};
+    emu_crypto_key(kind, key);
+    emu_crypto_signWithKey(key, message, messageLen, signature);
+    MEMZERO(key, sizeof(key));
+}
+
+// Same as emu_crypto_sign, with the derivation and signing stages traced like on the device
+static void emu_crypto_sign_traced(address_kind_e kind, const uint8_t *message, size_t messageLen,
+                                   uint8_t signature[64]) {
+    uint8_t key[EMU_KEY_LEN] = {0};
+    TRACE_START(trace_derive)
+    emu_crypto_deviceKey(kind, key);
+    TRACE_STOP(trace_derive)
+
+    TRACE_START(trace_sign)
+    emu_crypto_signWithKey(key, message, messageLen, signature);
+    TRACE_STOP(trace_sign)
+    MEMZERO(key, sizeof(key));
+}
+
+typedef union {
+    uint8_t address[21];
+    struct {
+        uint8_t padding;
+        uint8_t pkHash[CX_SHA512_SIZE];
+    };
+} emu_address_t;
+
+uint16_t crypto_encodeAddress(char *addr_out, uint16_t addr_out_max, uint8_t *pubkey, address_kind_e kind) {
+    emu_address_t tmp = {0};
+
+    const char *context = (kind == addr_ed25519) ? COIN_ADDRESS_ED25519_CONTEXT : COIN_ADDRESS_SR25519_CONTEXT;
+    SHA512_256_with_context_version((uint8_t *)context, strlen(context), COIN_ADDRESS_VERSION, pubkey, PK_LEN_ED25519,
+                                    tmp.pkHash);
+    tmp.address[0] = COIN_ADDRESS_VERSION;
+
+    if (bech32EncodeFromBytes(addr_out, addr_out_max, COIN_HRP, tmp.address, sizeof(tmp.address), 1,
+                              BECH32_ENCODING_BECH32) != zxerr_ok) {
+        return 0;
+    }
+    return strnlen(addr_out, addr_out_max);
+}
+
+// Stand-in for the Ethereum address: hex of 20 bytes of a hash of the public key
+static void emu_crypto_ethAddress(const uint8_t *publicKey, size_t publicKeyLen, char *out, uint16_t outLen) {
+    uint8_t hash[SHA512_DIGEST_LENGTH] = {0};
+    SHA512_256(publicKey, publicKeyLen, hash);
+    array_to_hexstr(out, outLen, hash + ETH_ADDR_OFFSET, ETH_ADDR_LEN);
+}
+
+zxerr_t crypto_fillEthAddress(uint8_t *buffer, uint16_t bufferLen, uint16_t *addrLen) {
+    // [len][uncompressed pk][len][hex address], the chain code is not emulated
+    const uint16_t replyLen = 1 + PK_LEN_SECP256K1_FULL + 1 + ETH_ADDR_LEN * 2;
+    if (buffer == NULL || addrLen == NULL || bufferLen < replyLen + 32) {
+        return zxerr_unknown;
+    }
+    MEMZERO(buffer, bufferLen);
+
+    buffer[0] = PK_LEN_SECP256K1_FULL;
+    buffer[1] = 0x04;
+    emu_crypto_devicePublicKey(addr_secp256k1, buffer + 2);
+    emu_crypto_devicePublicKey(addr_eth, buffer + 2 + 32);
+
+    char address[ETH_ADDR_HEX_LEN] = {0};
+    emu_crypto_ethAddress(buffer + 2, PK_LEN_SECP256K1_FULL - 1, address, sizeof(address));
+    buffer[1 + PK_LEN_SECP256K1_FULL] = ETH_ADDR_LEN * 2;
+    MEMCPY(buffer + 2 + PK_LEN_SECP256K1_FULL, address, ETH_ADDR_LEN * 2);
+
+    *addrLen = replyLen;
+    return zxerr_ok;
+}
+
+zxerr_t crypto_fillAddress(uint8_t *buffer, uint16_t buffer_len, uint16_t *addrLen, address_kind_e kind) {
+    if (buffer == NULL || addrLen == NULL || buffer_len < PK_LEN_SECP256K1 + 50) {
+        return zxerr_unknown;
+    }
+    MEMZERO(buffer, buffer_len);
+    *addrLen = 0;
+
+    switch (kind) {
+        case addr_ed25519:
+        case addr_sr25519: {
+            // [pk][bech32 address]
+            emu_crypto_devicePublicKey(kind, buffer);
+            char *addr_out = (char *)(buffer + PK_LEN_ED25519);
+            const uint16_t addr_out_len = crypto_encodeAddress(addr_out, buffer_len - PK_LEN_ED25519, buffer, kind);
+            if (addr_out_len == 0) {
+                return zxerr_encoding_failed;
+            }
+            *addrLen = PK_LEN_ED25519 + addr_out_len;
+            return zxerr_ok;
+        }
+        case addr_secp256k1: {
+            // [compressed pk][hex address]
+            buffer[0] = 0x02;
+            emu_crypto_devicePublicKey(kind, buffer + 1);
+            emu_crypto_ethAddress(buffer + 1, PUB_KEY_SIZE, (char *)(buffer + PK_LEN_SECP256K1), ETH_ADDR_HEX_LEN);
+            *addrLen = PK_LEN_SECP256K1 + ETH_ADDR_LEN * 2;
+            return zxerr_ok;
+        }
+        case addr_eth:
+            return crypto_fillEthAddress(buffer, buffer_len, addrLen);
+    }
+    return zxerr_unknown;
+}
+
+zxerr_t crypto_signEd25519(uint8_t *signature, uint16_t signatureMaxlen, const uint8_t *message, uint16_t messageLen,
+                           uint16_t *sigSize) {
+    if (signature == NULL || message == NULL || sigSize == NULL || signatureMaxlen < ED25519_SIGNATURE_SIZE ||
+        messageLen != CX_SHA256_SIZE) {
+        return zxerr_unknown;
+    }
+    emu_crypto_sign_traced(addr_ed25519, message, messageLen, signature);
+    *sigSize = ED25519_SIGNATURE_SIZE;
+    return zxerr_ok;
+}
+
+zxerr_t crypto_signSecp256k1(uint8_t *signature, uint16_t signatureMaxlen, const uint8_t *message, uint16_t messageLen,
+                             uint16_t *sigSize) {
+    if (signature == NULL || message == NULL || sigSize == NULL || signatureMaxlen < EMU_SECP256K1_SIGNATURE_LEN ||
+        messageLen != CX_SHA256_SIZE) {
+        return zxerr_invalid_crypto_settings;
+    }
+    // r || s || v, no DER copy
+    emu_crypto_sign_traced(addr_secp256k1, message, messageLen, signature);
+    signature[64] = 0;
+    *sigSize = EMU_SECP256K1_SIGNATURE_LEN;
+    return zxerr_ok;
+}
+
+zxerr_t crypto_sign_sr25519(uint8_t *output, uint16_t outputLen, const uint8_t *data, size_t len, const uint8_t *ctx,
+                            size_t ctx_len, uint16_t *sigSize) {
+    if (output == NULL || data == NULL || sigSize == NULL || ctx == NULL || outputLen < SIG_LEN) {
+        return zxerr_unknown;
+    }
+    uint8_t digest[CX_SHA256_SIZE] = {0};
+    emu_crypto_hash(ctx, ctx_len, data, len, digest);
+    emu_crypto_sign_traced(addr_sr25519, digest, sizeof(digest), output);
+    *sigSize = SIG_LEN;
+    return zxerr_ok;
+}
+
+zxerr_t keccak_digest(const unsigned char *in, unsigned int inLen, unsigned char *out, unsigned int outLen) {
+    // Not Keccak, only its size
+    if (outLen < CX_SHA256_SIZE) {
+        return zxerr_unknown;
+    }
+    uint8_t digest[SHA512_DIGEST_LENGTH] = {0};
+    SHA512_256(in, inLen, digest);
+    MEMCPY(out, digest, CX_SHA256_SIZE);
+    return zxerr_ok;
+}
+
+zxerr_t crypto_sign_eth(uint8_t *buffer, uint16_t signatureMaxlen, const uint8_t *message, uint16_t messageLen,
+                        uint16_t *sigSize) {
+    if (buffer == NULL || message == NULL || sigSize == NULL || signatureMaxlen < EMU_SECP256K1_SIGNATURE_LEN) {
+        return zxerr_unknown;
+    }
+
+    uint8_t digest[CX_SHA256_SIZE] = {0};
+    TRACE_START(trace_hash)
+    CHECK_ZXERR(keccak_digest(message, messageLen, digest, sizeof(digest)))
+    TRACE_STOP(trace_hash)
+
+    // v || r || s, v comes from the parsed transaction like on the device
+    uint8_t v = 0;
+    CHECK_ZXERR(tx_compute_eth_v(0, &v))
+    emu_crypto_sign_traced(addr_eth, digest, sizeof(digest), buffer + 1);
+    buffer[0] = v;
+    *sigSize = EMU_SECP256K1_SIGNATURE_LEN;
+    return zxerr_ok;
+}
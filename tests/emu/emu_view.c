@@ -0,0 +1,61 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+// Stand-ins for the zxlib view entry points the APDU layer calls.
+// view.h is not included on purpose: it drags in the BAGL/NBGL declarations,
+// and only the callbacks matter here.
+
+#include <stddef.h>
+
+#include "emu_view.h"
+
+emu_view_t emu_view;
+
+void emu_view_clear() {
+    emu_view.getItem = NULL;
+    emu_view.getNumItems = NULL;
+    emu_view.accept = NULL;
+    emu_view.pending = false;
+    emu_view.error = false;
+}
+
+void view_review_init(emu_getItem_t viewfuncGetItem, emu_getNumItems_t viewfuncGetNumItems,
+                      emu_accept_t viewfuncAccept) {
+    emu_view_clear();
+    emu_view.getItem = viewfuncGetItem;
+    emu_view.getNumItems = viewfuncGetNumItems;
+    emu_view.accept = viewfuncAccept;
+}
+
+void view_review_show(unsigned int reviewKind) {
+    (void)reviewKind;
+    emu_view.pending = emu_view.getItem != NULL && emu_view.getNumItems != NULL;
+}
+
+// Inner item navigation is not emulated, the review only shows the top level
+void view_inspect_init(void *getInnerItem, void *getNumInnerItems, void *canInspectItem) {
+    (void)getInnerItem;
+    (void)getNumInnerItems;
+    (void)canInspectItem;
+}
+
+void view_custom_error_show(const char *upper, const char *lower) {
+    (void)upper;
+    (void)lower;
+    emu_view_clear();
+    emu_view.pending = true;
+    emu_view.error = true;
+}
@@ -0,0 +1,45 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+// State of the emulated screens, shared by emu_view.c and the driver in emu.c
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "zxerror.h"
+
+// Same shapes as the zxlib view callbacks
+typedef zxerr_t (*emu_getNumItems_t)(uint8_t *numItems);
+typedef zxerr_t (*emu_getItem_t)(int8_t displayIdx, char *outKey, uint16_t outKeyLen, char *outVal, uint16_t outValLen,
+                                 uint8_t pageIdx, uint8_t *pageCount);
+typedef void (*emu_accept_t)();
+
+typedef struct {
+    emu_getItem_t getItem;
+    emu_getNumItems_t getNumItems;
+    emu_accept_t accept;
+
+    // A review is on screen
+    bool pending;
+    // The screen is an error the user can only dismiss
+    bool error;
+} emu_view_t;
+
+extern emu_view_t emu_view;
+
+/// Takes down whatever is on screen
+void emu_view_clear();
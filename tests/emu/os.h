@@ -0,0 +1,97 @@
+/*******************************************************************************
+ *   (c) 2018 - 2024 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+#pragma once
+
+// Host stand-in for the parts of the Ledger SDK os.h the APDU layer uses
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <setjmp.h>
+#include <stdint.h>
+
+#include "cx.h"
+
+typedef unsigned short exception_t;
+
+typedef struct try_context_s try_context_t;
+struct try_context_s {
+    jmp_buf jmp_buf;
+    try_context_t *previous;
+    exception_t ex;
+};
+
+/// Innermost open TRY block, NULL outside of any
+try_context_t *try_context_get(void);
+/// Makes ctx the innermost TRY block and returns the previous one
+try_context_t *try_context_set(try_context_t *ctx);
+/// Jumps to the innermost TRY block, aborts when there is none
+void os_longjmp(unsigned int exception) __attribute__((noreturn));
+
+// Same shape as the SDK macros, so a function can only hold one TRY block
+#define BEGIN_TRY \
+    {             \
+        try_context_t __try_ctx;
+
+#define TRY                                       \
+    __try_ctx.ex = setjmp(__try_ctx.jmp_buf);     \
+    if (__try_ctx.ex == 0) {                      \
+        __try_ctx.previous = try_context_set(&__try_ctx);
+
+#define CATCH(x)                              \
+    goto __try_finally;                       \
+    }                                         \
+    else if (__try_ctx.ex == (x)) {           \
+        __try_ctx.ex = 0;                     \
+        try_context_set(__try_ctx.previous);
+
+#define CATCH_OTHER(e)                        \
+    goto __try_finally;                       \
+    }                                         \
+    else {                                    \
+        exception_t e = __try_ctx.ex;         \
+        __try_ctx.ex = 0;                     \
+        try_context_set(__try_ctx.previous);
+
+#define FINALLY                                \
+    goto __try_finally;                        \
+    }                                          \
+    __try_finally:                             \
+    if (try_context_get() == &__try_ctx) {     \
+        try_context_set(__try_ctx.previous);   \
+    }
+
+#define END_TRY                     \
+    if (__try_ctx.ex != 0) {        \
+        os_longjmp(__try_ctx.ex);   \
+    }                               \
+    }
+
+#define THROW(x) os_longjmp(x)
+
+#define EXCEPTION_IO_RESET 0x10
+
+#define BOLOS_UX_OK 0xAA
+#define BOLOS_TRUE 0xAA
+#define BOLOS_FALSE 0x55
+
+/// Returns BOLOS_UX_OK while the emulated device is unlocked
+unsigned int os_global_pin_is_validated(void);
+
+#ifdef __cplusplus
+}
+#endif
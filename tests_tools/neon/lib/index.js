@@ -1,4 +1,6 @@
 var addon = require('../native');
+const assert = require('assert');
+const crypto = require('crypto');
 
 // Here we can write some simple tests for play around
 console.log("--------------------------------------")
@@ -9,4 +11,23 @@ a = Buffer.from("b65abc66a8fdeac1197d03daa6c3791d0c0799a52db6b7127b1cd12d46e3436
 b = Buffer.from([116, 101, 115, 116, 32, 109, 101, 115, 115, 97, 103, 101]);
 c = Buffer.from("48fdbe5cf3524bdd078ac711565d658a3053d10660749959883c4710f49d9948b2d5f829bea6800897dc6ea0150ca11075cc36b75bfcf3712aafb8e1bd10bf8f", 'hex');
 
-console.log(addon.schnorrkel_verify(a,Buffer.from([103, 111, 111, 100]),b, c));
\ No newline at end of file
+console.log(addon.schnorrkel_verify(a,Buffer.from([103, 111, 111, 100]),b, c));
+
+// Bit i of the result is set when signature i verifies
+const ctx = Buffer.from([103, 111, 111, 100]);
+const bad = Buffer.from(c);
+bad[0] ^= 1;
+const sr = addon.schnorrkel_verify_batch([a, a, a], [ctx, ctx, ctx], [b, b, b], [c, bad, c], 2);
+console.log(sr);
+assert.deepStrictEqual(sr, Buffer.from([0b101]));
+
+// Same bitmap for ed25519, each signature is checked on its own
+const { publicKey, privateKey } = crypto.generateKeyPairSync('ed25519');
+// Raw key is what follows the 12 bytes SPKI header
+const pk = publicKey.export({ format: 'der', type: 'spki' }).subarray(12);
+const sig = crypto.sign(null, b, privateKey);
+const badSig = Buffer.from(sig);
+badSig[0] ^= 1;
+const ed = addon.ed25519_verify_parallel([pk, pk, pk], [b, b, ctx], [sig, badSig, sig], 2);
+console.log(ed);
+assert.deepStrictEqual(ed, Buffer.from([0b001]));
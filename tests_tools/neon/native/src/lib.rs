@@ -1,3 +1,6 @@
+use std::thread;
+
+use ed25519_dalek::{Signature as Ed25519Signature, VerifyingKey};
 use neon::prelude::*;
 use neon::types::buffer::TypedArray;
 use schnorrkel::{context::*, PublicKey, Signature};
@@ -43,8 +46,202 @@ fn schnorrkel_verify(mut cx: FunctionContext) -> JsResult<JsBoolean> {
     }
 }
 
+// Copies an array of buffers out of JS, so the batch can be checked off the JS thread
+fn buffers(cx: &mut FunctionContext, i: usize) -> NeonResult<Vec<Vec<u8>>> {
+    let array = cx.argument::<JsArray>(i)?;
+    let values = array.to_vec(cx)?;
+    let mut out = Vec::with_capacity(values.len());
+    for value in values {
+        let buffer = value.downcast_or_throw::<JsBuffer, _>(cx)?;
+        out.push(buffer.as_slice(cx).to_vec());
+    }
+    Ok(out)
+}
+
+// Optional worker count, 1 when missing
+fn threads(cx: &mut FunctionContext, i: usize) -> NeonResult<usize> {
+    match cx.argument_opt(i) {
+        Some(value) if !value.is_a::<JsUndefined, _>(cx) => {
+            let n = value.downcast_or_throw::<JsNumber, _>(cx)?.value(cx);
+            Ok(if n >= 1.0 { n as usize } else { 1 })
+        }
+        _ => Ok(1),
+    }
+}
+
+// Bit i (LSB first) is set when item i verified
+fn bitmap<'a>(cx: &mut FunctionContext<'a>, results: &[bool]) -> JsResult<'a, JsBuffer> {
+    let mut bits = vec![0u8; (results.len() + 7) / 8];
+    for (i, ok) in results.iter().enumerate() {
+        if *ok {
+            bits[i / 8] |= 1 << (i % 8);
+        }
+    }
+    JsBuffer::from_slice(cx, &bits)
+}
+
+// Splits the items over up to `threads` workers, results keep the input order
+fn verify_chunks<T: Sync>(items: &[T], threads: usize, check: fn(&[T]) -> Vec<bool>) -> Vec<bool> {
+    if items.is_empty() {
+        return vec![];
+    }
+    let chunk = (items.len() + threads - 1) / threads;
+    if chunk == items.len() {
+        return check(items);
+    }
+    thread::scope(|s| {
+        let workers: Vec<_> = items.chunks(chunk).map(|part| s.spawn(move || check(part))).collect();
+        workers.into_iter().flat_map(|w| w.join().unwrap()).collect()
+    })
+}
+
+struct Sr25519Item {
+    // None when the public key or signature does not even parse
+    keys: Option<(PublicKey, Signature)>,
+    context: Vec<u8>,
+    hasher: Sha512Trunc256,
+}
+
+impl Sr25519Item {
+    fn transcript(&self) -> impl SigningTranscript {
+        signing_context(&self.context).hash256(self.hasher.clone())
+    }
+}
+
+// One batch for the whole chunk, items are only checked one by one when it fails
+fn sr25519_check(items: &[Sr25519Item]) -> Vec<bool> {
+    let parsed: Vec<&Sr25519Item> = items.iter().filter(|item| item.keys.is_some()).collect();
+    let public_keys: Vec<PublicKey> = parsed.iter().map(|item| item.keys.unwrap().0).collect();
+    let signatures: Vec<Signature> = parsed.iter().map(|item| item.keys.unwrap().1).collect();
+    let transcripts = parsed.iter().map(|item| item.transcript());
+
+    if schnorrkel::verify_batch(transcripts, &signatures, &public_keys, true).is_ok() {
+        return items.iter().map(|item| item.keys.is_some()).collect();
+    }
+    items
+        .iter()
+        .map(|item| match item.keys {
+            Some((pk, sig)) => pk.verify(item.transcript(), &sig).is_ok(),
+            None => false,
+        })
+        .collect()
+}
+
+/// schnorrkel_verify_batch(pubkeys[], contexts[], messages[], signatures[], threads?) -> bitmap Buffer
+/// Same checks as schnorrkel_verify for every index
+fn schnorrkel_verify_batch(mut cx: FunctionContext) -> JsResult<JsBuffer> {
+    let pubkeys = buffers(&mut cx, 0)?;
+    let contexts = buffers(&mut cx, 1)?;
+    let messages = buffers(&mut cx, 2)?;
+    let signatures = buffers(&mut cx, 3)?;
+    let threads = threads(&mut cx, 4)?;
+
+    let n = pubkeys.len();
+    if contexts.len() != n || messages.len() != n || signatures.len() != n {
+        return cx.throw_error("pubkeys, contexts, messages and signatures must have the same length");
+    }
+
+    let items: Vec<Sr25519Item> = (0..n)
+        .map(|i| {
+            let keys = match (PublicKey::from_bytes(&pubkeys[i]), Signature::from_bytes(&signatures[i])) {
+                (Ok(pk), Ok(sig)) => Some((pk, sig)),
+                _ => None,
+            };
+            let mut hasher = Sha512Trunc256::new();
+            hasher.update(&messages[i]);
+            Sr25519Item { keys, context: contexts[i].clone(), hasher }
+        })
+        .collect();
+
+    let results = verify_chunks(&items, threads, sr25519_check);
+    bitmap(&mut cx, &results)
+}
+
+struct Ed25519Item {
+    keys: Option<(VerifyingKey, Ed25519Signature)>,
+    message: Vec<u8>,
+}
+
+// Each signature on its own with verify_strict, which rejects small order keys and R. There is no batch equation
+// here: the one in ed25519-dalek accepts some of those, so it would answer differently than checking one by one
+fn ed25519_check(items: &[Ed25519Item]) -> Vec<bool> {
+    items
+        .iter()
+        .map(|item| match item.keys {
+            Some((pk, sig)) => pk.verify_strict(&item.message, &sig).is_ok(),
+            None => false,
+        })
+        .collect()
+}
+
+/// ed25519_verify_parallel(pubkeys[], messages[], signatures[], threads?) -> bitmap Buffer
+/// Strict verification (RFC 8032 with small order keys and R rejected) of every index on its own,
+/// the items are only spread over the worker threads
+fn ed25519_verify_parallel(mut cx: FunctionContext) -> JsResult<JsBuffer> {
+    let pubkeys = buffers(&mut cx, 0)?;
+    let messages = buffers(&mut cx, 1)?;
+    let signatures = buffers(&mut cx, 2)?;
+    let threads = threads(&mut cx, 3)?;
+
+    let n = pubkeys.len();
+    if messages.len() != n || signatures.len() != n {
+        return cx.throw_error("pubkeys, messages and signatures must have the same length");
+    }
+
+    let items: Vec<Ed25519Item> = (0..n)
+        .map(|i| {
+            let pk = <[u8; 32]>::try_from(pubkeys[i].as_slice())
+                .ok()
+                .and_then(|pk| VerifyingKey::from_bytes(&pk).ok());
+            let sig = Ed25519Signature::from_slice(&signatures[i]).ok();
+            Ed25519Item { keys: pk.zip(sig), message: messages[i].clone() }
+        })
+        .collect();
+
+    let results = verify_chunks(&items, threads, ed25519_check);
+    bitmap(&mut cx, &results)
+}
+
 #[neon::main]
 fn main(mut cx: ModuleContext) -> NeonResult<()> {
     cx.export_function("schnorrkel_verify", schnorrkel_verify)?;
+    cx.export_function("schnorrkel_verify_batch", schnorrkel_verify_batch)?;
+    cx.export_function("ed25519_verify_parallel", ed25519_verify_parallel)?;
     Ok(())
-}
\ No newline at end of file
+}
+
+#[cfg(test)]
+mod tests {
+    use ed25519_dalek::{Signer, SigningKey, Verifier};
+
+    use super::*;
+
+    fn item(pk: [u8; 32], sig: [u8; 64], message: &[u8]) -> Ed25519Item {
+        Ed25519Item {
+            keys: VerifyingKey::from_bytes(&pk).ok().zip(Some(Ed25519Signature::from_bytes(&sig))),
+            message: message.to_vec(),
+        }
+    }
+
+    #[test]
+    fn ed25519_check_is_strict() {
+        let key = SigningKey::from_bytes(&[7u8; 32]);
+        let good = key.sign(b"message");
+
+        // Identity key with R = identity and s = 0 passes the cofactorless check for any message
+        let mut identity = [0u8; 32];
+        identity[0] = 1;
+        let mut weak = [0u8; 64];
+        weak[..32].copy_from_slice(&identity);
+        let weak_key = VerifyingKey::from_bytes(&identity).unwrap();
+        assert!(weak_key.verify(b"message", &Ed25519Signature::from_bytes(&weak)).is_ok());
+
+        let items = vec![
+            item(key.verifying_key().to_bytes(), good.to_bytes(), b"message"),
+            item(identity, weak, b"message"),
+            item(key.verifying_key().to_bytes(), good.to_bytes(), b"other message"),
+        ];
+        assert_eq!(ed25519_check(&items), vec![true, false, false]);
+        assert_eq!(verify_chunks(&items, 2, ed25519_check), vec![true, false, false]);
+    }
+}